@@ -23,5 +23,8 @@ long cma=__NR_process_vm_readv;
              AC_LANG_POP([C])
              AC_MSG_RESULT([$cma_happy])])
     fi
+    if test "$cma_happy" = "yes" ; then
+        AC_CHECK_FUNCS([memfd_create])
+    fi
     AS_IF([test "$cma_happy" = "yes"], [$1], [$2])
 ])
@@ -0,0 +1,19 @@
+#CHECK_SHM([action-if-found], [action-if-not-found])
+# --------------------------------------------------------
+# check if POSIX shared memory support is wanted.
+AC_DEFUN([CHECK_SHM], [
+    AC_ARG_WITH([shm],
+       [AS_HELP_STRING([--with-shm],
+         [Map the symmetric heap and data segment through POSIX shared memory for on-node comms, invalid with XPMEM or CMA (default: no)])])
+
+    shm_happy="no"
+    if test "$with_shm" = "yes" ; then
+        AC_CHECK_FUNCS([memfd_create],
+            [shm_happy="yes"],
+            [AC_SEARCH_LIBS([shm_open], [rt],
+                [AC_DEFINE([HAVE_SHM_OPEN], [1], [Define if shm_open is available])
+                 shm_happy="yes"],
+                [shm_happy="no"])])
+    fi
+    AS_IF([test "$shm_happy" = "yes"], [$1], [$2])
+])
@@ -13,6 +13,12 @@ extern "C" {
 /* Counting puts */
 typedef char * shmemx_ct_t;
 
+/* Persistent collective request */
+typedef struct shmemx_coll_req *shmemx_coll_req_t;
+
+/* Request-based RMA handle; NULL once the operation has completed */
+typedef struct shmemx_req *shmemx_req_t;
+
 /* Counter */
 typedef struct {
     uint64_t pending_put;
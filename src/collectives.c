@@ -21,27 +21,50 @@
 #include "shmem_internal.h"
 #include "shmem_collectives.h"
 #include "shmem_internal_op.h"
+#include "shmem_copy.h"
+#include "shmem_team.h"
+#include "shmem_remote_pointer.h"
 
 coll_type_t shmem_internal_barrier_type = AUTO;
 coll_type_t shmem_internal_bcast_type = AUTO;
 coll_type_t shmem_internal_reduce_type = AUTO;
 coll_type_t shmem_internal_collect_type = AUTO;
 coll_type_t shmem_internal_fcollect_type = AUTO;
+coll_type_t shmem_internal_alltoall_type = AUTO;
+coll_type_t shmem_internal_alltoalls_type = AUTO;
+int shmem_internal_coll_node_size = 1;
 long *shmem_internal_barrier_all_psync;
 long *shmem_internal_sync_all_psync;
+void *shmem_internal_alltoall_scratch;
+size_t shmem_internal_alltoall_scratch_len = 0;
+void *shmem_internal_alltoalls_staging;
+size_t shmem_internal_alltoalls_staging_len = 0;
 
 char *coll_type_str[] = { "AUTO",
                           "LINEAR",
                           "TREE",
                           "DISSEM",
                           "RING",
-                          "RECDBL" };
+                          "RECDBL",
+                          "HIER",
+                          "RABENSEIFNER",
+                          "PIPELINE",
+                          "SCATTER",
+                          "BRUCK",
+                          "PAIRWISE",
+                          "PACKED" };
 
 static int *full_tree_children;
 static int full_tree_num_children;
 static int full_tree_parent;
 static long tree_radix = -1;
 
+/* Posted non-blocking collectives, in posting order */
+static shmem_internal_coll_req_t *nbc_head = NULL, *nbc_tail = NULL;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t nbc_lock;
+#endif
+
 
 static int
 shmem_internal_build_kary_tree(int radix, int PE_start, int stride,
@@ -52,19 +75,21 @@ shmem_internal_build_kary_tree(int radix, int PE_start, int stride,
 
     /* my_id is the index in a theoretical 0...N-1 array of
        participating tasks. where the 0th entry is the root */
-    int my_id = (((shmem_internal_my_pe - PE_start) / stride) + PE_size - PE_root) % PE_size;
+    int my_id = (shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, stride, PE_size) +
+                 PE_size - PE_root) % PE_size;
 
     /* We shift PE_root to index 0, resulting in a PE active set layout of (for
        example radix 2): 0 [ 1 2 ] [ 3 4 ] [ 5 6 ] ...  The first group [ 1 2 ]
        are chilren of 0, second group [ 3 4 ] are chilren of 1, and so on */
-    *parent = PE_start + (((my_id - 1) / radix + PE_root) % PE_size) * stride;
+    *parent = shmem_internal_active_set_pe(((my_id - 1) / radix + PE_root) % PE_size,
+                                           PE_start, stride);
 
     *num_children = 0;
     for (i = 1 ; i <= radix ; ++i) {
         int tmp = radix * my_id + i;
         if (tmp < PE_size) {
             const int child_idx = (PE_root + tmp) % PE_size;
-            children[(*num_children)++] = PE_start + child_idx * stride;
+            children[(*num_children)++] = shmem_internal_active_set_pe(child_idx, PE_start, stride);
         }
     }
 
@@ -96,14 +121,33 @@ shmem_internal_build_kary_tree(int radix, int PE_start, int stride,
 static inline int
 shmem_internal_circular_iter_next(int curr, int PE_start, int PE_stride, int PE_size)
 {
-    const int last = PE_start + (PE_stride * (PE_size - 1));
-    int next;
+    int next = shmem_internal_pe_in_active_set(curr, PE_start, PE_stride, PE_size) + 1;
+
+    if (next == PE_size)
+        next = 0;
+
+    return shmem_internal_active_set_pe(next, PE_start, PE_stride);
+}
 
-    next = curr + PE_stride;
-    if (next > last)
-        next = PE_start;
 
-    return next;
+/* Resolve the tree of the calling PE over an active set, using the
+ * precomputed binomial tree when it spans all PEs from PE 0.  Otherwise, the
+ * children are stored in the given array of tree_radix entries. */
+static inline void
+shmem_internal_coll_tree(shmem_internal_tree_t *tree, int *children, int PE_root,
+                         int PE_start, int PE_stride, int PE_size)
+{
+    if (PE_size == shmem_internal_num_pes && 0 == PE_root) {
+        /* we're the full tree, use the binomial tree */
+        tree->parent = full_tree_parent;
+        tree->num_children = full_tree_num_children;
+        tree->children = full_tree_children;
+    } else {
+        tree->children = children;
+        shmem_internal_build_kary_tree(tree_radix, PE_start, PE_stride, PE_size,
+                                       PE_root, &tree->parent, &tree->num_children,
+                                       children);
+    }
 }
 
 
@@ -116,6 +160,7 @@ shmem_internal_collectives_init(void)
     char *type;
 
     tree_radix = shmem_internal_params.COLL_RADIX;
+    SHMEM_MUTEX_INIT(nbc_lock);
 
     /* initialize barrier_all psync array */
     shmem_internal_barrier_all_psync =
@@ -175,6 +220,8 @@ shmem_internal_collectives_init(void)
             shmem_internal_barrier_type = TREE;
         } else if (0 == strcmp(type, "dissem")) {
             shmem_internal_barrier_type = DISSEM;
+        } else if (0 == strcmp(type, "hier")) {
+            shmem_internal_barrier_type = HIER;
         } else {
             RAISE_WARN_MSG("Ignoring bad barrier algorithm '%s'\n", type);
         }
@@ -187,6 +234,10 @@ shmem_internal_collectives_init(void)
             shmem_internal_bcast_type = LINEAR;
         } else if (0 == strcmp(type, "tree")) {
             shmem_internal_bcast_type = TREE;
+        } else if (0 == strcmp(type, "pipeline")) {
+            shmem_internal_bcast_type = PIPELINE;
+        } else if (0 == strcmp(type, "scatter")) {
+            shmem_internal_bcast_type = SCATTER;
         } else {
             RAISE_WARN_MSG("Ignoring bad broadcast algorithm '%s'\n", type);
         }
@@ -203,6 +254,10 @@ shmem_internal_collectives_init(void)
             shmem_internal_reduce_type = TREE;
         } else if (0 == strcmp(type, "recdbl")) {
             shmem_internal_reduce_type = RECDBL;
+        } else if (0 == strcmp(type, "hier")) {
+            shmem_internal_reduce_type = HIER;
+        } else if (0 == strcmp(type, "rabenseifner")) {
+            shmem_internal_reduce_type = RABENSEIFNER;
         } else {
             RAISE_WARN_MSG("Ignoring bad reduction algorithm '%s'\n", type);
         }
@@ -213,6 +268,8 @@ shmem_internal_collectives_init(void)
             shmem_internal_collect_type = AUTO;
         } else if (0 == strcmp(type, "linear")) {
             shmem_internal_collect_type = LINEAR;
+        } else if (0 == strcmp(type, "recdbl")) {
+            shmem_internal_collect_type = RECDBL;
         } else {
             RAISE_WARN_MSG("Ignoring bad collect algorithm '%s'\n", type);
         }
@@ -233,11 +290,153 @@ shmem_internal_collectives_init(void)
             RAISE_WARN_MSG("Ignoring bad fcollect algorithm '%s'\n", type);
         }
     }
+    if (shmem_internal_params.ALLTOALL_ALGORITHM_provided) {
+        type = shmem_internal_params.ALLTOALL_ALGORITHM;
+        if (0 == strcmp(type, "auto")) {
+            shmem_internal_alltoall_type = AUTO;
+        } else if (0 == strcmp(type, "linear")) {
+            shmem_internal_alltoall_type = LINEAR;
+        } else if (0 == strcmp(type, "pairwise")) {
+            shmem_internal_alltoall_type = PAIRWISE;
+        } else if (0 == strcmp(type, "bruck")) {
+            shmem_internal_alltoall_type = BRUCK;
+        } else if (0 == strcmp(type, "hier")) {
+            shmem_internal_alltoall_type = HIER;
+        } else {
+            RAISE_WARN_MSG("Ignoring bad alltoall algorithm '%s'\n", type);
+        }
+    }
+    if (shmem_internal_params.ALLTOALLS_ALGORITHM_provided) {
+        type = shmem_internal_params.ALLTOALLS_ALGORITHM;
+        if (0 == strcmp(type, "auto")) {
+            shmem_internal_alltoalls_type = AUTO;
+        } else if (0 == strcmp(type, "linear")) {
+            shmem_internal_alltoalls_type = LINEAR;
+        } else if (0 == strcmp(type, "packed")) {
+            shmem_internal_alltoalls_type = PACKED;
+        } else {
+            RAISE_WARN_MSG("Ignoring bad alltoalls algorithm '%s'\n", type);
+        }
+    }
+
+    /* Bruck receives at most half of the blocks per step */
+    if ((shmem_internal_alltoall_type == AUTO || shmem_internal_alltoall_type == BRUCK) &&
+        shmem_internal_params.ALLTOALL_BRUCK_CROSSOVER > 0) {
+        size_t scratch_len = shmem_internal_params.ALLTOALL_BRUCK_CROSSOVER *
+                             ((shmem_internal_num_pes + 1) / 2);
+
+        shmem_internal_alltoall_scratch = shmem_internal_shmalloc(scratch_len);
+        if (NULL == shmem_internal_alltoall_scratch) return -1;
+        shmem_internal_alltoall_scratch_len = scratch_len;
+    }
+
+    if ((shmem_internal_alltoalls_type == AUTO || shmem_internal_alltoalls_type == PACKED) &&
+        shmem_internal_params.ALLTOALLS_STAGING_SIZE > 0) {
+        shmem_internal_alltoalls_staging =
+            shmem_internal_shmalloc(shmem_internal_params.ALLTOALLS_STAGING_SIZE);
+        if (NULL == shmem_internal_alltoalls_staging) return -1;
+        shmem_internal_alltoalls_staging_len = shmem_internal_params.ALLTOALLS_STAGING_SIZE;
+    }
+
+    return 0;
+}
+
+
+/* Buffers of the node layout detection, allocated at initialization and
+ * released once the layout is known */
+static long *coll_node_buf;
+static long *coll_node_psync;
+static void *coll_node_pwrk;
+int shmem_internal_coll_node_pending = 0;
+
+/* Prepare the detection of the node layout required by the hierarchical
+ * algorithms.  This does not communicate: the layout is agreed upon during
+ * the first shmem_barrier_all (see shmem_internal_collectives_node_detect).
+ * Called after the teams are initialized. */
+int
+shmem_internal_collectives_node_init(void)
+{
+#if USE_XPMEM || USE_SHM
+    int i;
+
+    if (shmem_internal_num_pes == 1 || shmem_internal_team_shared.size == 1 ||
+        (shmem_internal_barrier_type != AUTO && shmem_internal_barrier_type != HIER &&
+         shmem_internal_reduce_type != AUTO && shmem_internal_reduce_type != HIER &&
+         shmem_internal_alltoall_type != AUTO && shmem_internal_alltoall_type != HIER))
+        return 0;
+
+    coll_node_buf = shmem_internal_shmalloc(sizeof(long) * 6);
+    coll_node_psync = shmem_internal_shmalloc(sizeof(long) * SHMEM_REDUCE_SYNC_SIZE);
+    coll_node_pwrk = shmem_internal_shmalloc(sizeof(long) * SHMEM_REDUCE_MIN_WRKDATA_SIZE);
+    if (NULL == coll_node_buf || NULL == coll_node_psync || NULL == coll_node_pwrk)
+        return -1;
+
+    for (i = 0; i < SHMEM_REDUCE_SYNC_SIZE; i++)
+        coll_node_psync[i] = SHMEM_SYNC_VALUE;
+
+    shmem_internal_coll_node_pending = 1;
+#endif
 
     return 0;
 }
 
 
+/* Determine whether the PEs are laid out in equal blocks of consecutive PEs
+ * per node.  Every PE must reach the same conclusion, so the SHMEM_TEAM_SHARED
+ * layouts are combined with a reduction over all PEs, which is performed in
+ * place of the sync of the first shmem_barrier_all.  Until then, the
+ * hierarchical algorithms are not used. */
+void
+shmem_internal_collectives_node_detect(void)
+{
+    long *buf = coll_node_buf;
+
+    shmem_internal_coll_node_pending = 0;
+
+    /* MAX of the node size, of its negation (i.e. MIN), and of a flag that
+     * is set when this node's PEs are not an aligned block */
+    buf[0] = shmem_internal_team_shared.size;
+    buf[1] = -shmem_internal_team_shared.size;
+    buf[2] = shmem_internal_team_shared.size > 1 &&
+             (shmem_internal_team_shared.stride != 1 ||
+              shmem_internal_team_shared.start % shmem_internal_team_shared.size != 0);
+
+    shmem_internal_op_to_all(&buf[3], buf, 3, sizeof(long), 0, 1,
+                             shmem_internal_num_pes, coll_node_pwrk, coll_node_psync,
+                             SHM_INTERNAL_MAX, SHM_INTERNAL_LONG);
+
+    if (buf[3] == -buf[4] && 0 == buf[5])
+        shmem_internal_coll_node_size = buf[3];
+
+    DEBUG_MSG("Collectives node size is %d\n", shmem_internal_coll_node_size);
+
+    /* Complete the barrier, which also ensures that no PE still accesses the
+     * detection buffers */
+    shmem_internal_sync(0, 1, shmem_internal_num_pes, shmem_internal_barrier_all_psync);
+
+    shmem_internal_free(coll_node_pwrk);
+    shmem_internal_free(coll_node_psync);
+    shmem_internal_free(coll_node_buf);
+    coll_node_pwrk = NULL;
+    coll_node_psync = NULL;
+    coll_node_buf = NULL;
+}
+
+
+/* The PEs of a node check in with their leader in the hierarchical
+ * algorithms by incrementing a pSync slot of the leader with a processor
+ * atomic, since the leader's pSync is directly accessible */
+static inline
+void
+shmem_internal_coll_node_arrive(long *pSync, int leader)
+{
+    long *remote_psync = (long *) shmem_internal_ptr(pSync, leader);
+
+    shmem_internal_assert(NULL != remote_psync);
+    __atomic_fetch_add(remote_psync, 1, __ATOMIC_RELEASE);
+}
+
+
 /*****************************************
  *
  * BARRIER/SYNC Implementations
@@ -246,12 +445,13 @@ shmem_internal_collectives_init(void)
 void
 shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync)
 {
+    const int root = shmem_internal_active_set_pe(0, PE_start, PE_stride);
     long zero = 0, one = 1;
 
     /* need 1 slot */
     shmem_internal_assert(SHMEM_BARRIER_SYNC_SIZE >= 1);
 
-    if (PE_start == shmem_internal_my_pe) {
+    if (root == shmem_internal_my_pe) {
         int pe, i;
 
         /* wait for N - 1 callins up the tree */
@@ -263,15 +463,14 @@ shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
 
         /* Send acks down psync tree */
-        for (pe = PE_start + PE_stride, i = 1 ;
-             i < PE_size ;
-             i++, pe += PE_stride) {
+        for (i = 1 ; i < PE_size ; i++) {
+            pe = shmem_internal_active_set_pe(i, PE_start, PE_stride);
             shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), pe);
         }
 
     } else {
         /* send message to root */
-        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), PE_start,
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), root,
                               SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
         /* wait for ack down psync tree */
@@ -372,7 +571,7 @@ shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync
 {
     int one = 1, neg_one = -1;
     int distance, to, i;
-    int coll_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
+    int coll_rank = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
     int *pSync_ints = (int*) pSync;
 
     /* need log2(num_procs) int slots.  max_num_procs is
@@ -385,8 +584,7 @@ shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync
     shmem_internal_assert(SHMEM_BARRIER_SYNC_SIZE >= (sizeof(int) * 8) / (sizeof(long) / sizeof(int)));
 
     for (i = 0, distance = 1 ; distance < PE_size ; ++i, distance <<= 1) {
-        to = ((coll_rank + distance) % PE_size);
-        to = PE_start + (to * PE_stride);
+        to = shmem_internal_active_set_pe((coll_rank + distance) % PE_size, PE_start, PE_stride);
 
         shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[i], &one, sizeof(int),
                               to, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
@@ -407,6 +605,55 @@ shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync
 }
 
 
+/* Two-level barrier.  The PEs of each node check in with their node leader
+ * (the first PE of the node) through shared memory, the leaders perform a
+ * dissemination barrier among themselves, and then release the PEs of their
+ * node.  Requires shmem_internal_coll_use_hier(). */
+void
+shmem_internal_sync_hier(int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    long zero = 0, one = 1;
+    const int node_size = shmem_internal_coll_node_size;
+    const int leader = PE_start + ((shmem_internal_my_pe - PE_start) / node_size) * node_size;
+
+    /* need 1 slot, plus the dissemination barrier among the leaders.  The
+     * remaining slots cover 2^((SHMEM_BARRIER_SYNC_SIZE-1)*sizeof(long)/sizeof(int))
+     * nodes. */
+    shmem_internal_assert(SHMEM_BARRIER_SYNC_SIZE >= 2);
+
+    if (leader == shmem_internal_my_pe) {
+        int pe;
+
+        /* wait for the PEs of this node to call in */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, node_size - 1);
+
+        /* Clear pSync */
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+
+        shmem_internal_sync_dissem(PE_start, node_size, PE_size / node_size,
+                                   pSync + 1);
+
+        /* Release the PEs of this node */
+        for (pe = leader + 1; pe < leader + node_size; pe++)
+            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), pe);
+
+    } else {
+        /* send message to the node leader */
+        shmem_internal_coll_node_arrive(pSync, leader);
+
+        /* wait for release from the node leader */
+        SHMEM_WAIT(pSync, 0);
+
+        /* Clear pSync */
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+    }
+}
+
+
 /*****************************************
  *
  * BROADCAST
@@ -418,7 +665,7 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
                             long *pSync, int complete)
 {
     long zero = 0, one = 1;
-    int real_root = PE_start + PE_root * PE_stride;
+    int real_root = shmem_internal_active_set_pe(PE_root, PE_start, PE_stride);
     long completion = 0;
 
     /* need 1 slot */
@@ -430,7 +677,8 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
         int i, pe;
 
         /* send data to all peers */
-        for (pe = PE_start,i=0; i < PE_size; pe += PE_stride, i++) {
+        for (i = 0; i < PE_size; i++) {
+            pe = shmem_internal_active_set_pe(i, PE_start, PE_stride);
             if (pe == shmem_internal_my_pe) continue;
             shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, source, len, pe, &completion);
         }
@@ -439,7 +687,8 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
         shmem_internal_fence(SHMEM_CTX_DEFAULT);
 
         /* send completion ack to all peers */
-        for (pe = PE_start,i=0; i < PE_size; pe += PE_stride, i++) {
+        for (i = 0; i < PE_size; i++) {
+            pe = shmem_internal_active_set_pe(i, PE_start, PE_stride);
             if (pe == shmem_internal_my_pe) continue;
             shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(long), pe);
         }
@@ -472,32 +721,20 @@ shmem_internal_bcast_linear(void *target, const void *source, size_t len,
 }
 
 
-void
-shmem_internal_bcast_tree(void *target, const void *source, size_t len,
-                          int PE_root, int PE_start, int PE_stride, int PE_size,
-                          long *pSync, int complete)
+static void
+shmem_internal_bcast_tree_sched(const shmem_internal_tree_t *tree, void *target,
+                                const void *source, size_t len, long *pSync,
+                                int complete)
 {
     long zero = 0, one = 1;
     long completion = 0;
-    int parent, num_children, *children;
+    const int parent = tree->parent, num_children = tree->num_children;
+    const int *children = tree->children;
     const void *send_buf = source;
 
     /* need 1 slot */
     shmem_internal_assert(SHMEM_BCAST_SYNC_SIZE >= 1);
 
-    if (PE_size == 1 || len == 0) return;
-
-    if (PE_size == shmem_internal_num_pes && 0 == PE_root) {
-        /* we're the full tree, use the binomial tree */
-        parent = full_tree_parent;
-        num_children = full_tree_num_children;
-        children = full_tree_children;
-    } else {
-        children = alloca(sizeof(int) * tree_radix);
-        shmem_internal_build_kary_tree(tree_radix, PE_start, PE_stride, PE_size,
-                                       PE_root, &parent, &num_children, children);
-    }
-
     if (0 != num_children) {
         int i;
 
@@ -560,6 +797,209 @@ shmem_internal_bcast_tree(void *target, const void *source, size_t len,
 }
 
 
+void
+shmem_internal_bcast_tree(void *target, const void *source, size_t len,
+                          int PE_root, int PE_start, int PE_stride, int PE_size,
+                          long *pSync, int complete)
+{
+    shmem_internal_tree_t tree;
+    int *children;
+
+    if (PE_size == 1 || len == 0) return;
+
+    children = alloca(sizeof(int) * tree_radix);
+    shmem_internal_coll_tree(&tree, children, PE_root, PE_start, PE_stride, PE_size);
+    shmem_internal_bcast_tree_sched(&tree, target, source, len, pSync, complete);
+}
+
+
+/* Segmented tree broadcast.  The message is sent down the tree in segments
+ * of SHMEM_BCAST_SEGMENT_SIZE bytes, so that a PE forwards a segment to its
+ * children while the next segment arrives.  The pSync slot counts the
+ * segments received from the parent, followed by the acks from the children
+ * when complete is set. */
+static void
+shmem_internal_bcast_pipeline_sched(const shmem_internal_tree_t *tree, void *target,
+                                    const void *source, size_t len, long *pSync,
+                                    int complete)
+{
+    long zero = 0, one = 1;
+    long completion = 0;
+    const int parent = tree->parent, num_children = tree->num_children;
+    const int *children = tree->children;
+    const uint8_t *send_buf = source;
+    const size_t seg_size = shmem_internal_params.BCAST_SEGMENT_SIZE > 0 ?
+                            shmem_internal_params.BCAST_SEGMENT_SIZE : len;
+    const long num_segs = (len + seg_size - 1) / seg_size;
+    long seg;
+    int i;
+
+    /* need 1 slot */
+    shmem_internal_assert(SHMEM_BCAST_SYNC_SIZE >= 1);
+
+    if (parent != shmem_internal_my_pe)
+        send_buf = target;
+
+    for (seg = 0; seg < num_segs; seg++) {
+        size_t off = seg * seg_size;
+        size_t seg_len = (len - off < seg_size) ? len - off : seg_size;
+
+        /* wait for the segment if not the root */
+        if (parent != shmem_internal_my_pe)
+            SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, seg + 1);
+
+        if (0 == num_children) continue;
+
+        for (i = 0 ; i < num_children ; ++i) {
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (uint8_t *) target + off,
+                                  send_buf + off, seg_len, children[i], &completion);
+        }
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+
+        for (i = 0 ; i < num_children ; ++i) {
+            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                                  children[i], SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+    }
+
+    if (1 == complete) {
+        /* send ack to the parent, then wait for acks from the children */
+        if (parent != shmem_internal_my_pe)
+            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                                  parent, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, num_children +
+                         ((parent == shmem_internal_my_pe) ? 0 : num_segs));
+    }
+
+    /* Clear pSync */
+    shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+                             shmem_internal_my_pe);
+    SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+}
+
+
+void
+shmem_internal_bcast_pipeline(void *target, const void *source, size_t len,
+                              int PE_root, int PE_start, int PE_stride, int PE_size,
+                              long *pSync, int complete)
+{
+    shmem_internal_tree_t tree;
+    int *children;
+
+    if (PE_size == 1 || len == 0) return;
+
+    children = alloca(sizeof(int) * tree_radix);
+    shmem_internal_coll_tree(&tree, children, PE_root, PE_start, PE_stride, PE_size);
+    shmem_internal_bcast_pipeline_sched(&tree, target, source, len, pSync, complete);
+}
+
+
+/* Scatter/allgather broadcast for very large messages.  The root scatters one
+ * block of the message to each PE, and the blocks are then passed along a
+ * chain that starts at the root (whose target buffer is not written), so each
+ * PE sends and receives about len bytes regardless of PE_size.
+ *
+ * The pSync slot counts the blocks received from the left neighbor.  The
+ * scattered block adds PE_size, which the chain alone cannot reach, so that a
+ * single slot tracks both.  On the root, it counts the acks when complete is
+ * set. */
+void
+shmem_internal_bcast_scatter(void *target, const void *source, size_t len,
+                             int PE_root, int PE_start, int PE_stride, int PE_size,
+                             long *pSync, int complete)
+{
+    long zero = 0, one = 1, scattered = PE_size;
+    long completion = 0;
+    const int real_root = shmem_internal_active_set_pe(PE_root, PE_start, PE_stride);
+    const int my_pos = (shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size) - PE_root + PE_size) % PE_size;
+    const int right = shmem_internal_active_set_pe((PE_root + my_pos + 1) % PE_size, PE_start, PE_stride);
+    int i;
+
+/* Block b, numbered from the root, is [BLOCK_OFF(b), BLOCK_OFF(b+1)) */
+#define BLOCK_OFF(b) ((len * (size_t) (b)) / PE_size)
+
+    /* need 1 slot */
+    shmem_internal_assert(SHMEM_BCAST_SYNC_SIZE >= 1);
+
+    if (PE_size == 1 || len == 0) return;
+
+    if (real_root == shmem_internal_my_pe) {
+        int pe;
+
+        /* scatter block i to the PE at position i */
+        for (i = 1 ; i < PE_size ; i++) {
+            pe = shmem_internal_active_set_pe((PE_root + i) % PE_size, PE_start, PE_stride);
+            if (BLOCK_OFF(i + 1) > BLOCK_OFF(i))
+                shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (uint8_t *) target + BLOCK_OFF(i),
+                                      (uint8_t *) source + BLOCK_OFF(i),
+                                      BLOCK_OFF(i + 1) - BLOCK_OFF(i), pe, &completion);
+        }
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+
+        for (i = 1 ; i < PE_size ; i++) {
+            pe = shmem_internal_active_set_pe((PE_root + i) % PE_size, PE_start, PE_stride);
+            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &scattered, sizeof(scattered),
+                                  pe, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+    }
+
+    /* At step i, forward block my_pos - i to the right neighbor; the last PE
+     * in the chain does not send to the root */
+    for (i = 0 ; i < PE_size - 1 ; i++) {
+        int block = (my_pos - i + PE_size) % PE_size;
+
+        if (real_root != shmem_internal_my_pe)
+            SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, scattered + i);
+
+        if (my_pos == PE_size - 1) continue;
+
+        if (BLOCK_OFF(block + 1) > BLOCK_OFF(block)) {
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (uint8_t *) target + BLOCK_OFF(block),
+                                  (real_root == shmem_internal_my_pe ?
+                                   (uint8_t *) source : (uint8_t *) target) + BLOCK_OFF(block),
+                                  BLOCK_OFF(block + 1) - BLOCK_OFF(block), right, &completion);
+            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        }
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                              right, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    }
+
+#undef BLOCK_OFF
+
+    if (real_root == shmem_internal_my_pe) {
+        if (1 == complete) {
+            /* wait for acks from everyone */
+            SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size - 1);
+
+            /* Clear pSync */
+            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+                                     shmem_internal_my_pe);
+            SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+        }
+    } else {
+        /* wait for the last block */
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_GE, scattered + PE_size - 1);
+
+        /* Clear pSync */
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
+
+        if (1 == complete) {
+            /* send ack back to root */
+            shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
+                                  real_root, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        }
+    }
+}
+
+
 /*****************************************
  *
  * REDUCTION
@@ -571,6 +1011,7 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
                                 void *pWrk, long *pSync,
                                 shm_internal_op_t op, shm_internal_datatype_t datatype)
 {
+    const int root = shmem_internal_active_set_pe(0, PE_start, PE_stride);
 
     long zero = 0, one = 1;
     long completion = 0;
@@ -580,7 +1021,7 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
 
     if (count == 0) return;
 
-    if (PE_start == shmem_internal_my_pe) {
+    if (root == shmem_internal_my_pe) {
         int pe, i;
         /* update our target buffer with our contribution.  The put
            will flush any atomic cache value that may currently
@@ -591,9 +1032,8 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
         shmem_internal_quiet(SHMEM_CTX_DEFAULT);
 
         /* let everyone know that it's safe to send to us */
-        for (pe = PE_start + PE_stride, i = 1 ;
-             i < PE_size ;
-             i++, pe += PE_stride) {
+        for (i = 1 ; i < PE_size ; i++) {
+            pe = shmem_internal_active_set_pe(i, PE_start, PE_stride);
             shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one), pe);
         }
 
@@ -614,12 +1054,12 @@ shmem_internal_op_to_all_linear(void *target, const void *source, size_t count,
 
         /* send data, ack, and wait for completion */
         shmem_internal_atomicv(SHMEM_CTX_DEFAULT, target, source, count * type_size,
-                               PE_start, op, datatype, &completion);
+                               root, op, datatype, &completion);
         shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
         shmem_internal_fence(SHMEM_CTX_DEFAULT);
 
         shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &one, sizeof(one),
-                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+                              root, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
     }
 
     /* broadcast out */
@@ -637,10 +1077,10 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
                               void *pWrk, long *pSync,
                               shm_internal_op_t op, shm_internal_datatype_t datatype)
 {
-    int group_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
+    int group_rank = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
     long zero = 0, one = 1;
 
-    int peer = PE_start + ((group_rank + 1) % PE_size) * PE_stride;
+    int peer = shmem_internal_active_set_pe((group_rank + 1) % PE_size, PE_start, PE_stride);
     int free_source = 0;
 
     /* One slot for reduce-scatter and another for the allgather */
@@ -650,7 +1090,7 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
 
     if (PE_size == 1) {
         if (target != source)
-            memcpy(target, source, count*type_size);
+            shmem_internal_copy(target, source, count*type_size);
         return;
     }
 
@@ -751,39 +1191,41 @@ shmem_internal_op_to_all_ring(void *target, const void *source, size_t count, si
 }
 
 
-void
-shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, size_t type_size,
-                              int PE_start, int PE_stride, int PE_size,
-                              void *pWrk, long *pSync,
-                              shm_internal_op_t op, shm_internal_datatype_t datatype)
+/* Broadcast from the root of a resolved tree, reusing the tree when the
+ * selected algorithm walks one */
+static void
+shmem_internal_bcast_sched(const shmem_internal_tree_t *tree, void *target,
+                           const void *source, size_t len, int PE_start,
+                           int PE_stride, int PE_size, long *pSync, int complete)
+{
+    coll_type_t type = shmem_internal_bcast_select(len, PE_size);
+
+    if (PE_size == 1 || len == 0) return;
+
+    if (TREE == type)
+        shmem_internal_bcast_tree_sched(tree, target, source, len, pSync, complete);
+    else if (PIPELINE == type)
+        shmem_internal_bcast_pipeline_sched(tree, target, source, len, pSync, complete);
+    else
+        shmem_internal_bcast_run(type, target, source, len, 0, PE_start, PE_stride,
+                                 PE_size, pSync, complete);
+}
+
+
+static void
+shmem_internal_op_to_all_tree_sched(const shmem_internal_tree_t *tree, void *target,
+                                    const void *source, size_t count, size_t type_size,
+                                    int PE_start, int PE_stride, int PE_size, long *pSync,
+                                    shm_internal_op_t op, shm_internal_datatype_t datatype)
 {
     long zero = 0, one = 1;
     long completion = 0;
-    int parent, num_children, *children;
+    const int parent = tree->parent, num_children = tree->num_children;
+    const int *children = tree->children;
 
     /* need 2 slots, plus bcast */
     shmem_internal_assert(SHMEM_REDUCE_SYNC_SIZE >= 2 + SHMEM_BCAST_SYNC_SIZE);
 
-    if (PE_size == 1) {
-        if (target != source) {
-            memcpy(target, source, type_size*count);
-        }
-        return;
-    }
-
-    if (count == 0) return;
-
-    if (PE_size == shmem_internal_num_pes) {
-        /* we're the full tree, use the binomial tree */
-        parent = full_tree_parent;
-        num_children = full_tree_num_children;
-        children = full_tree_children;
-    } else {
-        children = alloca(sizeof(int) * tree_radix);
-        shmem_internal_build_kary_tree(tree_radix, PE_start, PE_stride, PE_size,
-                                       0, &parent, &num_children, children);
-    }
-
     if (0 != num_children) {
         int i;
 
@@ -829,29 +1271,54 @@ shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, si
     }
 
     /* broadcast out */
-    shmem_internal_bcast(target, target, count * type_size, 0, PE_start,
-                         PE_stride, PE_size, pSync + 2, 0);
+    shmem_internal_bcast_sched(tree, target, target, count * type_size, PE_start,
+                               PE_stride, PE_size, pSync + 2, 0);
 }
 
 
 void
-shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t count, size_t type_size,
-                                   int PE_start, int PE_stride, int PE_size,
-                                   void *pWrk, long *pSync,
-                                   shm_internal_op_t op, shm_internal_datatype_t datatype)
+shmem_internal_op_to_all_tree(void *target, const void *source, size_t count, size_t type_size,
+                              int PE_start, int PE_stride, int PE_size,
+                              void *pWrk, long *pSync,
+                              shm_internal_op_t op, shm_internal_datatype_t datatype)
 {
-    int my_id = ((shmem_internal_my_pe - PE_start) / PE_stride);
-    int log2_proc = 1, pow2_proc = 2;
-    int i = PE_size >> 1;
-    size_t wrk_size = type_size*count;
-    void * const current_target = malloc(wrk_size);
-    long completion = 0;
+    shmem_internal_tree_t tree;
+    int *children;
+
+    if (PE_size == 1) {
+        if (target != source) {
+            shmem_internal_copy(target, source, type_size*count);
+        }
+        return;
+    }
+
+    if (count == 0) return;
+
+    children = alloca(sizeof(int) * tree_radix);
+    shmem_internal_coll_tree(&tree, children, 0, PE_start, PE_stride, PE_size);
+    shmem_internal_op_to_all_tree_sched(&tree, target, source, count, type_size,
+                                        PE_start, PE_stride, PE_size, pSync, op, datatype);
+}
+
+
+void
+shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t count, size_t type_size,
+                                   int PE_start, int PE_stride, int PE_size,
+                                   void *pWrk, long *pSync,
+                                   shm_internal_op_t op, shm_internal_datatype_t datatype)
+{
+    int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    int log2_proc = 1, pow2_proc = 2;
+    int i = PE_size >> 1;
+    size_t wrk_size = type_size*count;
+    void * const current_target = malloc(wrk_size);
+    long completion = 0;
     long * pSync_extra_peer = pSync + SHMEM_REDUCE_SYNC_SIZE - 2;
     const long ps_target_ready = 1, ps_data_ready = 2;
 
     if (PE_size == 1) {
         if (target != source) {
-            memcpy(target, source, type_size*count);
+            shmem_internal_copy(target, source, type_size*count);
         }
         free(current_target);
         return;
@@ -890,7 +1357,7 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
     /* extra peer exchange: grab information from extra_peer so its part of
      * pairwise exchange */
     if (my_id >= pow2_proc) {
-        int peer = (my_id - pow2_proc) * PE_stride + PE_start;
+        int peer = shmem_internal_active_set_pe(my_id - pow2_proc, PE_start, PE_stride);
 
         /* Wait for target ready, required when source and target overlap */
         SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_EQ, ps_target_ready);
@@ -905,7 +1372,7 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 
     } else {
         if (my_id < PE_size - pow2_proc) {
-            int peer = (my_id + pow2_proc) * PE_stride + PE_start;
+            int peer = shmem_internal_active_set_pe(my_id + pow2_proc, PE_start, PE_stride);
             shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync_extra_peer, &ps_target_ready, sizeof(long), peer);
 
             SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_EQ, ps_data_ready);
@@ -918,7 +1385,7 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 
         for (i = 0; i < log2_proc; i++) {
             long *step_psync = &pSync[i];
-            int peer = (my_id ^ (1 << i)) * PE_stride + PE_start;
+            int peer = shmem_internal_active_set_pe(my_id ^ (1 << i), PE_start, PE_stride);
 
             if (shmem_internal_my_pe < peer) {
                 shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, step_psync, &ps_target_ready,
@@ -951,7 +1418,7 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 
         /* update extra peer with the final result from the pairwise exchange */
         if (my_id < PE_size - pow2_proc) {
-            int peer = (my_id + pow2_proc) * PE_stride + PE_start;
+            int peer = shmem_internal_active_set_pe(my_id + pow2_proc, PE_start, PE_stride);
 
             shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, current_target, wrk_size,
                                   peer, &completion);
@@ -961,7 +1428,7 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
                                      sizeof(long), peer);
         }
 
-        memcpy(target, current_target, wrk_size);
+        shmem_internal_copy(target, current_target, wrk_size);
     }
 
     free(current_target);
@@ -971,6 +1438,365 @@ shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t coun
 }
 
 
+/* Small reductions are specialized for each type and operation (see
+ * collectives_c.c4) and exchange their values through the pSync.  Each
+ * recursive doubling step, and the exchange with the extra PE, owns a slot of
+ * nwords data words followed by a flag word.  Values of up to 4 bytes travel
+ * in the flag word itself, so that each step is a single atomic write.
+ * Returns the number of data words, or -1 if the reduction should take the
+ * generic path. */
+#define REDUCE_SMALL_FLAG (((uint64_t) 1) << 32)
+
+int
+shmem_internal_reduce_small_words(size_t len, int PE_size)
+{
+    int nwords, log2_proc = 0;
+
+    if (AUTO != shmem_internal_reduce_type || 0 == len ||
+        len > shmem_internal_params.REDUCE_SMALL_SIZE ||
+        len > SHMEM_INTERNAL_REDUCE_SMALL_MAX)
+        return -1;
+
+    nwords = (len <= sizeof(uint32_t)) ? 0 : (len + sizeof(long) - 1) / sizeof(long);
+
+    while ((2 << log2_proc) <= PE_size)
+        log2_proc++;
+
+    if ((nwords + 1) * (log2_proc + 1) > SHMEM_REDUCE_SYNC_SIZE)
+        return -1;
+
+    return nwords;
+}
+
+
+void
+shmem_internal_reduce_small_send(long *slot, const void *val, size_t len,
+                                 int nwords, int pe)
+{
+    uint64_t flag = REDUCE_SMALL_FLAG;
+
+    if (0 == nwords) {
+        uint32_t payload = 0;
+
+        memcpy(&payload, val, len);
+        flag |= payload;
+    } else {
+        long completion = 0;
+
+        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, slot, val, len, pe, &completion);
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+    }
+
+    shmem_internal_atomic_set(SHMEM_CTX_DEFAULT, &slot[nwords], &flag, sizeof(flag),
+                              pe, SHM_INTERNAL_UINT64);
+}
+
+
+void
+shmem_internal_reduce_small_recv(long *slot, void *val, size_t len, int nwords)
+{
+    int i;
+
+    SHMEM_WAIT_UNTIL(&slot[nwords], SHMEM_CMP_NE, SHMEM_SYNC_VALUE);
+
+    if (0 == nwords) {
+        uint32_t payload = (uint32_t) slot[0];
+
+        memcpy(val, &payload, len);
+    } else {
+        memcpy(val, slot, len);
+    }
+
+    for (i = 0; i <= nwords; i++)
+        slot[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/* Rabenseifner's algorithm: a reduce-scatter by recursive halving followed by
+ * an allgather by recursive doubling, which moves the same amount of data as
+ * the ring in 2*log2(PE_size) steps.  As in recdbl_sw, PEs beyond the largest
+ * power of two first hand their data to a partner and receive the result at
+ * the end.
+ *
+ * Data is received in the target buffer and partial results are kept in a
+ * private buffer.  pSync[i] counts the messages exchanged with the partner at
+ * distance 2^i: the partner's target ready notification and data for the
+ * reduce-scatter, and its data for the allgather. */
+void
+shmem_internal_op_to_all_rabenseifner(void *target, const void *source, size_t count,
+                                      size_t type_size, int PE_start, int PE_stride,
+                                      int PE_size, void *pWrk, long *pSync,
+                                      shm_internal_op_t op, shm_internal_datatype_t datatype)
+{
+    const int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    long * const pSync_extra_peer = pSync + SHMEM_REDUCE_SYNC_SIZE - 2;
+    const long one = 1;
+    long completion = 0;
+    int log2_proc = 0, pow2_proc = 1, i;
+    size_t lo, hi, step_lo[SHMEM_REDUCE_SYNC_SIZE - 2], step_hi[SHMEM_REDUCE_SYNC_SIZE - 2];
+    uint8_t *current;
+
+    if (count == 0) return;
+
+    if (PE_size == 1) {
+        if (target != source)
+            shmem_internal_copy(target, source, count * type_size);
+        return;
+    }
+
+    while (pow2_proc * 2 <= PE_size) {
+        pow2_proc *= 2;
+        log2_proc++;
+    }
+
+    shmem_internal_assert(log2_proc <= SHMEM_REDUCE_SYNC_SIZE - 2);
+
+    current = malloc(count * type_size);
+    if (NULL == current)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n", count * type_size);
+
+    memcpy(current, source, count * type_size);
+
+    if (my_id >= pow2_proc) {
+        int peer = shmem_internal_active_set_pe(my_id - pow2_proc, PE_start, PE_stride);
+
+        /* Wait for target ready, required when source and target overlap */
+        SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_GE, 1);
+
+        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, current, count * type_size,
+                              peer, &completion);
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync_extra_peer, &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        /* Wait for the result */
+        SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_GE, 2);
+        goto out;
+    }
+
+    if (my_id < PE_size - pow2_proc) {
+        int peer = shmem_internal_active_set_pe(my_id + pow2_proc, PE_start, PE_stride);
+
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync_extra_peer, &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        SHMEM_WAIT_UNTIL(pSync_extra_peer, SHMEM_CMP_GE, 1);
+
+        shmem_internal_reduce_local(op, datatype, count, target, current);
+    }
+
+    /* Reduce-scatter: at each step, keep half of the current range and send
+     * the other half to the partner.  The fully reduced range is left in the
+     * target buffer. */
+    lo = 0;
+    hi = count;
+    for (i = log2_proc - 1; i >= 0; i--) {
+        const int peer = shmem_internal_active_set_pe(my_id ^ (1 << i), PE_start, PE_stride);
+        const size_t mid = lo + (hi - lo) / 2;
+        size_t send_lo, send_hi;
+
+        step_lo[i] = lo;
+        step_hi[i] = hi;
+
+        if (my_id & (1 << i)) {
+            send_lo = lo;
+            send_hi = mid;
+            lo = mid;
+        } else {
+            send_lo = mid;
+            send_hi = hi;
+            hi = mid;
+        }
+
+        /* Our target buffer is free, wait until the partner's is */
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync[i], &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+        SHMEM_WAIT_UNTIL(&pSync[i], SHMEM_CMP_GE, 1);
+
+        if (send_hi > send_lo) {
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (uint8_t *) target + send_lo * type_size,
+                                  current + send_lo * type_size,
+                                  (send_hi - send_lo) * type_size, peer, &completion);
+            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        }
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync[i], &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        SHMEM_WAIT_UNTIL(&pSync[i], SHMEM_CMP_GE, 2);
+
+        if (hi > lo) {
+            if (i > 0)
+                shmem_internal_reduce_local(op, datatype, hi - lo,
+                                            (uint8_t *) target + lo * type_size,
+                                            current + lo * type_size);
+            else
+                shmem_internal_reduce_local(op, datatype, hi - lo,
+                                            current + lo * type_size,
+                                            (uint8_t *) target + lo * type_size);
+        }
+    }
+
+    /* Allgather: exchange the reduced ranges with the same partners in the
+     * reverse order.  The partner only accesses the other half of the range
+     * of the matching reduce-scatter step, so no ready notification is
+     * needed. */
+    for (i = 0; i < log2_proc; i++) {
+        const int peer = shmem_internal_active_set_pe(my_id ^ (1 << i), PE_start, PE_stride);
+
+        if (hi > lo) {
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (uint8_t *) target + lo * type_size,
+                                  (uint8_t *) target + lo * type_size,
+                                  (hi - lo) * type_size, peer, &completion);
+            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        }
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync[i], &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+
+        SHMEM_WAIT_UNTIL(&pSync[i], SHMEM_CMP_GE, 3);
+
+        lo = step_lo[i];
+        hi = step_hi[i];
+    }
+
+    /* Send the result to the extra peer */
+    if (my_id < PE_size - pow2_proc) {
+        int peer = shmem_internal_active_set_pe(my_id + pow2_proc, PE_start, PE_stride);
+
+        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, target, count * type_size,
+                              peer, &completion);
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync_extra_peer, &one, sizeof(one),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+    }
+
+out:
+    free(current);
+
+    for (i = 0; i < log2_proc; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+    *pSync_extra_peer = SHMEM_SYNC_VALUE;
+}
+
+
+/* Hierarchical reduction.  The PEs of each node reduce into the target
+ * buffer of their node leader through shared memory, with each PE combining
+ * one slice of the buffer.  The node leaders then perform a recursive doubling
+ * or ring reduction among themselves, and the PEs of each node copy the result
+ * from their leader.  The last pSync slots, which are not used by the
+ * algorithms run among the leaders, count arrivals at the leader and release
+ * the other PEs of the node.  Requires shmem_internal_coll_use_hier(). */
+void
+shmem_internal_op_to_all_hier(void *target, const void *source, size_t count, size_t type_size,
+                              int PE_start, int PE_stride, int PE_size,
+                              void *pWrk, long *pSync,
+                              shm_internal_op_t op, shm_internal_datatype_t datatype)
+{
+    long zero = 0, one = 1;
+    const int node_size = shmem_internal_coll_node_size;
+    const int node_rank = (shmem_internal_my_pe - PE_start) % node_size;
+    const int leader = shmem_internal_my_pe - node_rank;
+    const int num_nodes = PE_size / node_size;
+    long * const node_psync = pSync + SHMEM_REDUCE_SYNC_SIZE - 3;
+    long * const done_psync = pSync + SHMEM_REDUCE_SYNC_SIZE - 4;
+    size_t first = count * node_rank / node_size;
+    size_t nelems = count * (node_rank + 1) / node_size - first;
+    uint8_t *slice;
+    int i;
+
+    /* Recursive doubling uses pSync[0..log2(num_nodes)) and the last two
+     * slots, ring uses the leading slots */
+    shmem_internal_assert(SHMEM_REDUCE_SYNC_SIZE >= 4 + 2 + SHMEM_BARRIER_SYNC_SIZE);
+
+    if (count == 0) return;
+
+    /* Symmetric buffers of the node's PEs are directly accessible whenever
+     * shmem_internal_coll_use_hier() holds */
+    slice = (uint8_t *) shmem_internal_ptr(target, leader) + first * type_size;
+
+    /* Wait until all PEs of the node have entered the reduction, then reduce
+     * this PE's slice of the node into the leader's target buffer.  Only this
+     * PE accesses the slice, so this is safe when source and target are the
+     * same buffer. */
+    if (leader == shmem_internal_my_pe) {
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, node_size - 1);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, 0);
+
+        for (i = 1; i < node_size; i++)
+            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &one, sizeof(one),
+                                     leader + i);
+    } else {
+        shmem_internal_coll_node_arrive(node_psync, leader);
+        SHMEM_WAIT(node_psync, 0);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, 0);
+    }
+
+    if (nelems > 0) {
+        if (target != source)
+            shmem_internal_copy(slice,
+                                (uint8_t *) shmem_internal_ptr(source, leader) +
+                                first * type_size,
+                                nelems * type_size);
+
+        for (i = 1; i < node_size; i++)
+            shmem_internal_reduce_local(op, datatype, nelems,
+                                        (uint8_t *) shmem_internal_ptr(source, leader + i) +
+                                        first * type_size,
+                                        slice);
+    }
+
+    shmem_internal_membar_acq_rel();
+
+    if (leader == shmem_internal_my_pe) {
+        /* Wait for the slices, reduce among the node leaders, and release
+         * the PEs of the node */
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, node_size - 1);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, 0);
+
+        if (num_nodes > 1)
+            shmem_internal_op_to_all_sw(target, target, count, type_size,
+                                        PE_start, node_size, num_nodes,
+                                        pWrk, pSync, op, datatype);
+
+        shmem_internal_membar_acq_rel();
+
+        for (i = 1; i < node_size; i++)
+            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &one, sizeof(one),
+                                     leader + i);
+
+        /* The result is read from our target buffer, wait until all PEs of
+         * the node are done before returning.  A separate slot is used, since
+         * the other PEs may already enter the next reduction. */
+        SHMEM_WAIT_UNTIL(done_psync, SHMEM_CMP_EQ, node_size - 1);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, done_psync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(done_psync, SHMEM_CMP_EQ, 0);
+
+    } else {
+        shmem_internal_coll_node_arrive(node_psync, leader);
+        SHMEM_WAIT(node_psync, 0);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &zero, sizeof(zero),
+                                 shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, 0);
+
+        shmem_internal_copy(target, shmem_internal_ptr(target, leader),
+                            count * type_size);
+        shmem_internal_membar_acq_rel();
+
+        shmem_internal_coll_node_arrive(done_psync, leader);
+    }
+}
+
+
 /*****************************************
  *
  * COLLECT (variable size)
@@ -980,6 +1806,7 @@ void
 shmem_internal_collect_linear(void *target, const void *source, size_t len,
                               int PE_start, int PE_stride, int PE_size, long *pSync)
 {
+    const int root = shmem_internal_active_set_pe(0, PE_start, PE_stride);
     size_t my_offset;
     long tmp[2];
     int peer, start_pe, i;
@@ -991,16 +1818,17 @@ shmem_internal_collect_linear(void *target, const void *source, size_t len,
               target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
 
     if (PE_size == 1) {
-        if (target != source) memcpy(target, source, len);
+        if (target != source) shmem_internal_copy(target, source, len);
         return;
     }
 
     /* Linear prefix sum -- propagate update lengths and calculate offset */
-    if (PE_start == shmem_internal_my_pe) {
+    if (root == shmem_internal_my_pe) {
         my_offset = 0;
         tmp[0] = (long) len; /* FIXME: Potential truncation of size_t into long */
         tmp[1] = 1; /* FIXME: Packing flag with data relies on byte ordering */
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, tmp, 2 * sizeof(long), PE_start + PE_stride);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, tmp, 2 * sizeof(long),
+                                  shmem_internal_active_set_pe(1, PE_start, PE_stride));
     }
     else {
         /* wait for send data */
@@ -1008,11 +1836,11 @@ shmem_internal_collect_linear(void *target, const void *source, size_t len,
         my_offset = pSync[0];
 
         /* Not the last guy, so send offset to next PE */
-        if (shmem_internal_my_pe < PE_start + PE_stride * (PE_size - 1)) {
+        if (shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size) < PE_size - 1) {
             tmp[0] = (long) (my_offset + len);
             tmp[1] = 1;
             shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, tmp, 2 * sizeof(long),
-                                     shmem_internal_my_pe + PE_stride);
+                                     shmem_internal_active_set_pe(shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size) + 1, PE_start, PE_stride));
         }
     }
 
@@ -1040,6 +1868,157 @@ shmem_internal_collect_linear(void *target, const void *source, size_t len,
 }
 
 
+/* Recursive doubling algorithm.  An exclusive prefix sum of the
+ * contribution lengths is computed with recursive doubling, after which
+ * the data is exchanged with recursive doubling, each PE sending the
+ * contiguous range of the target gathered so far.  When the PE set is not
+ * a power of two, the first 2r PEs (where r is the remainder) are folded
+ * in pairs, the even PE handing its contribution to its odd neighbor and
+ * receiving the full result at the end.  Folding adjacent PEs keeps every
+ * range contiguous in the target.
+ *
+ *   log(p) alpha + (p-1)/p n beta for the data, plus log(p) alpha for
+ *   the offsets
+ *
+ * pSync[0] carries the folded length, pSync[1] the final result to a
+ * folded PE and pSync[2 + i] the exchange at step i.  The length
+ * exchanged at step i is sent as 2 * (len + 1), so that the completion
+ * signal of the data sent at the same step can share the slot by adding 1.
+ */
+void
+shmem_internal_collect_recdbl(void *target, const void *source, size_t len,
+                              int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    size_t *pSync_sizes = (size_t *) pSync;
+    const int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    int log2_proc = 0, pow2_proc = 1, rem, vid, folded, i;
+    size_t my_len, my_offset, group_len, group_prefix, tmp, one = 1;
+    size_t step_prefix[sizeof(int) * 8], step_len[sizeof(int) * 8];
+    size_t step_sync[sizeof(int) * 8];
+    long completion = 0;
+
+    shmem_internal_assert(sizeof(size_t) == sizeof(long));
+
+    DEBUG_MSG("target=%p, source=%p, len=%zd, PE_Start=%d, PE_stride=%d, PE_size=%d, pSync=%p\n",
+              target, source, len, PE_start, PE_stride, PE_size, (void*) pSync);
+
+    if (PE_size == 1) {
+        if (target != source) shmem_internal_copy(target, source, len);
+        return;
+    }
+
+    while (pow2_proc * 2 <= PE_size) {
+        pow2_proc *= 2;
+        log2_proc++;
+    }
+    rem = PE_size - pow2_proc;
+
+    /* Need 2 slots for folding, plus one per step */
+    shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 2 + log2_proc);
+
+    /* Fold the extra PEs into their odd neighbor */
+    if (my_id < 2 * rem && my_id % 2 == 0) {
+        int peer = shmem_internal_active_set_pe(my_id + 1, PE_start, PE_stride);
+
+        tmp = 2 * (len + 1);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_sizes[0], &tmp, sizeof(size_t),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_SIZE_T);
+
+        /* The peer reads the source and writes the full result */
+        SHMEM_WAIT_UNTIL(&pSync[1], SHMEM_CMP_NE, 0);
+        pSync[1] = SHMEM_SYNC_VALUE;
+        return;
+    }
+
+    my_len = len;
+    folded = (my_id < 2 * rem);
+    if (folded) {
+        SHMEM_WAIT_UNTIL(&pSync[0], SHMEM_CMP_GE, 2);
+        my_len += pSync_sizes[0] / 2 - 1;
+        pSync[0] = SHMEM_SYNC_VALUE;
+        vid = my_id / 2;
+    } else {
+        vid = my_id - rem;
+    }
+
+    /* Exclusive prefix sum over the virtual PEs.  Record the range of the
+     * target held before each step for the data exchange. */
+    group_len = my_len;
+    group_prefix = 0;
+
+    for (i = 0 ; i < log2_proc ; i++) {
+        int peer_vid = vid ^ (1 << i);
+        int peer = shmem_internal_active_set_pe((peer_vid < rem) ? peer_vid * 2 + 1 : peer_vid + rem, PE_start, PE_stride);
+        size_t peer_len;
+
+        step_prefix[i] = group_prefix;
+        step_len[i] = group_len;
+
+        tmp = 2 * (group_len + 1);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_sizes[2 + i], &tmp, sizeof(size_t),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_SIZE_T);
+
+        SHMEM_WAIT_UNTIL(&pSync[2 + i], SHMEM_CMP_GE, 2);
+
+        /* The data completion may already have been added */
+        step_sync[i] = pSync_sizes[2 + i] & ~one;
+        peer_len = step_sync[i] / 2 - 1;
+
+        if (peer_vid < vid) group_prefix += peer_len;
+        group_len += peer_len;
+    }
+
+    /* group_prefix is now the offset of this virtual PE's data, and
+     * group_len the total length */
+    my_offset = group_prefix + my_len - len;
+
+    if (folded && my_len != len) {
+        int peer = shmem_internal_active_set_pe(my_id - 1, PE_start, PE_stride);
+        shmem_internal_get(SHMEM_CTX_DEFAULT, (char*) target + group_prefix, source,
+                           my_len - len, peer);
+    }
+    if (len > 0 && ((char*) target + my_offset) != source)
+        shmem_internal_copy((char*) target + my_offset, source, len);
+    if (folded && my_len != len)
+        shmem_internal_get_wait(SHMEM_CTX_DEFAULT);
+
+    for (i = 0 ; i < log2_proc ; i++) {
+        int peer_vid = vid ^ (1 << i);
+        int peer = shmem_internal_active_set_pe((peer_vid < rem) ? peer_vid * 2 + 1 : peer_vid + rem, PE_start, PE_stride);
+        size_t offset = group_prefix - step_prefix[i];
+
+        if (step_len[i] > 0) {
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + offset,
+                                  (char*) target + offset, step_len[i], peer,
+                                  &completion);
+            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+            shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        }
+
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_sizes[2 + i], &one, sizeof(size_t),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_SIZE_T);
+
+        SHMEM_WAIT_UNTIL(&pSync[2 + i], SHMEM_CMP_GE, (long) (step_sync[i] + 1));
+        pSync[2 + i] = SHMEM_SYNC_VALUE;
+    }
+
+    /* Send the result to the folded PE */
+    if (folded) {
+        int peer = shmem_internal_active_set_pe(my_id - 1, PE_start, PE_stride);
+
+        if (group_len > 0) {
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, target, target, group_len, peer,
+                                  &completion);
+            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+            shmem_internal_fence(SHMEM_CTX_DEFAULT);
+        }
+
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_sizes[1], &one, sizeof(size_t),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_SIZE_T);
+    }
+}
+
+
 /*****************************************
  *
  * COLLECT (same size)
@@ -1049,31 +2028,32 @@ void
 shmem_internal_fcollect_linear(void *target, const void *source, size_t len,
                                int PE_start, int PE_stride, int PE_size, long *pSync)
 {
+    const int root = shmem_internal_active_set_pe(0, PE_start, PE_stride);
     long tmp = 1;
     long completion = 0;
 
     /* need 1 slot, plus bcast */
     shmem_internal_assert(SHMEM_COLLECT_SYNC_SIZE >= 1 + SHMEM_BCAST_SYNC_SIZE);
 
-    if (PE_start == shmem_internal_my_pe) {
+    if (root == shmem_internal_my_pe) {
         /* Copy data into the target */
-        if (source != target) memcpy(target, source, len);
+        if (source != target) shmem_internal_copy(target, source, len);
 
         /* send completion update */
         shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(long),
-                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+                              root, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
 
         /* wait for N updates */
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, PE_size);
 
         /* Clear pSync */
         tmp = 0;
-        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(tmp), PE_start);
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(tmp), root);
         SHMEM_WAIT_UNTIL(pSync, SHMEM_CMP_EQ, 0);
     } else {
         /* Push data into the target */
-        size_t offset = ((shmem_internal_my_pe - PE_start) / PE_stride) * len;
-        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + offset, source, len, PE_start,
+        size_t offset = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size) * len;
+        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + offset, source, len, root,
                               &completion);
         shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
 
@@ -1082,7 +2062,7 @@ shmem_internal_fcollect_linear(void *target, const void *source, size_t len,
 
         /* send completion update */
         shmem_internal_atomic(SHMEM_CTX_DEFAULT, pSync, &tmp, sizeof(long),
-                              PE_start, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
+                              root, SHM_INTERNAL_SUM, SHM_INTERNAL_LONG);
     }
 
     shmem_internal_bcast(target, target, len * PE_size, 0, PE_start, PE_stride,
@@ -1104,8 +2084,8 @@ shmem_internal_fcollect_ring(void *target, const void *source, size_t len,
     int i;
     /* my_id is the index in a theoretical 0...N-1 array of
        participating tasks */
-    int my_id = ((shmem_internal_my_pe - PE_start) / PE_stride);
-    int next_proc = PE_start + ((my_id + 1) % PE_size) * PE_stride;
+    int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    int next_proc = shmem_internal_active_set_pe((my_id + 1) % PE_size, PE_start, PE_stride);
     long completion = 0;
     long zero = 0, one = 1;
 
@@ -1115,7 +2095,7 @@ shmem_internal_fcollect_ring(void *target, const void *source, size_t len,
     if (len == 0) return;
 
     /* copy my portion to the right place */
-    memcpy((char*) target + (my_id * len), source, len);
+    shmem_internal_copy((char*) target + (my_id * len), source, len);
 
     /* send n - 1 messages to the next highest proc.  Each message
        contains what we received the previous step (including our own
@@ -1157,7 +2137,7 @@ void
 shmem_internal_fcollect_recdbl(void *target, const void *source, size_t len,
                                int PE_start, int PE_stride, int PE_size, long *pSync)
 {
-    int my_id = ((shmem_internal_my_pe - PE_start) / PE_stride);
+    int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
     int i;
     long completion = 0;
     size_t curr_offset;
@@ -1179,11 +2159,11 @@ shmem_internal_fcollect_recdbl(void *target, const void *source, size_t len,
 
     /* copy my portion to the right place */
     curr_offset = my_id * len;
-    memcpy((char*) target + curr_offset, source, len);
+    shmem_internal_copy((char*) target + curr_offset, source, len);
 
     for (i = 0, distance = 0x1 ; distance < PE_size ; i++, distance <<= 1) {
         int peer = my_id ^ distance;
-        int real_peer = PE_start + (peer * PE_stride);
+        int real_peer = shmem_internal_active_set_pe(peer, PE_start, PE_stride);
 
         /* send data to peer */
         shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (char*) target + curr_offset, (char*) target + curr_offset,
@@ -1211,10 +2191,10 @@ shmem_internal_fcollect_recdbl(void *target, const void *source, size_t len,
 
 
 void
-shmem_internal_alltoall(void *dest, const void *source, size_t len,
-                        int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_alltoall_linear(void *dest, const void *source, size_t len,
+                               int PE_start, int PE_stride, int PE_size, long *pSync)
 {
-    const int my_as_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
+    const int my_as_rank = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
     const void *dest_ptr = (uint8_t *) dest + my_as_rank * len;
     int peer, start_pe, i;
 
@@ -1229,7 +2209,7 @@ shmem_internal_alltoall(void *dest, const void *source, size_t len,
                                                  PE_size);
     peer = start_pe;
     do {
-        int peer_as_rank = (peer - PE_start) / PE_stride; /* Peer's index in active set */
+        int peer_as_rank = shmem_internal_pe_in_active_set(peer, PE_start, PE_stride, PE_size); /* Peer's index in active set */
 
         shmem_internal_put_nbi(SHMEM_CTX_DEFAULT, (void *) dest_ptr, (uint8_t *) source + peer_as_rank * len,
                               len, peer);
@@ -1244,12 +2224,263 @@ shmem_internal_alltoall(void *dest, const void *source, size_t len,
 }
 
 
+/* Pairwise exchange, in which step i sends to the PE at distance i
+ * (XOR distance when the PE set is a power of two), so that every PE
+ * receives from a single peer per step.  At most SHMEM_ALLTOALL_WINDOW
+ * puts are left outstanding, limiting the load on the network and on the
+ * targets for large blocks.
+ */
 void
-shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
-                         ptrdiff_t sst, size_t elem_size, size_t nelems,
-                         int PE_start, int PE_stride, int PE_size, long *pSync)
+shmem_internal_alltoall_pairwise(void *dest, const void *source, size_t len,
+                                 int PE_start, int PE_stride, int PE_size, long *pSync)
 {
-    const int my_as_rank = (shmem_internal_my_pe - PE_start) / PE_stride;
+    const int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    const int pow2 = (0 == (PE_size & (PE_size - 1)));
+    void *dest_ptr = (uint8_t *) dest + my_id * len;
+    long window = shmem_internal_params.ALLTOALL_WINDOW;
+    long outstanding = 0;
+    int i;
+
+    shmem_internal_assert(SHMEM_ALLTOALL_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+
+    if (0 == len)
+        return;
+
+    if (window < 1) window = 1;
+
+    shmem_internal_copy(dest_ptr, (uint8_t *) source + my_id * len, len);
+
+    for (i = 1 ; i < PE_size ; i++) {
+        int peer_id = pow2 ? my_id ^ i : (my_id + i) % PE_size;
+
+        shmem_internal_put_nbi(SHMEM_CTX_DEFAULT, dest_ptr,
+                               (uint8_t *) source + peer_id * len, len,
+                               shmem_internal_active_set_pe(peer_id, PE_start, PE_stride));
+
+        if (++outstanding == window && i < PE_size - 1) {
+            shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+            outstanding = 0;
+        }
+    }
+
+    shmem_internal_barrier(PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+}
+
+
+/* Bruck algorithm.  After a local rotation, step k sends every block
+ * whose index has bit k set to the PE at distance 2^k, so that all blocks
+ * reach their destination in log(p) messages per PE:
+ *
+ *   log(p) alpha + (n/2) log(p) beta
+ *
+ * The blocks of each step are packed into one message and received in
+ * the scratch buffer, so a PE signals the PE that sends to it in the next
+ * step once it has unpacked the current one.  pSync holds one int ready
+ * flag and one int data flag per step, interleaved, so that the public
+ * SHMEM_ALLTOALL_SYNC_SIZE covers PE sets of up to 2^16 PEs
+ * (see shmem_internal_alltoall_use_bruck).
+ */
+void
+shmem_internal_alltoall_bruck(void *dest, const void *source, size_t len,
+                              int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    int *pSync_ints = (int *) pSync;
+    uint8_t *scratch = shmem_internal_alltoall_scratch;
+    uint8_t *work, *pack;
+    int one = 1, neg_one = -1;
+    long completion = 0;
+    int i, k, distance;
+
+    /* need 2 int slots per step */
+    shmem_internal_assert(PE_size <= 1 << (SHMEM_ALLTOALL_SYNC_SIZE * sizeof(long) / sizeof(int) / 2));
+    shmem_internal_assert(len * ((PE_size + 1) / 2) <= shmem_internal_alltoall_scratch_len);
+
+    if (0 == len)
+        return;
+
+    if (PE_size == 1) {
+        shmem_internal_copy(dest, source, len);
+        return;
+    }
+
+    work = malloc(PE_size * len);
+    pack = malloc(((PE_size + 1) / 2) * len);
+    if (NULL == work || NULL == pack)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n",
+                        (PE_size + (PE_size + 1) / 2) * len);
+
+    /* Rotate so that block i is destined to the PE at distance i */
+    for (i = 0 ; i < PE_size ; i++)
+        memcpy(work + i * len, (uint8_t *) source + ((my_id + i) % PE_size) * len, len);
+
+    /* The scratch buffer is free for the first step */
+    shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[0], &one, sizeof(int),
+                          shmem_internal_active_set_pe((my_id - 1 + PE_size) % PE_size, PE_start, PE_stride),
+                          SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+    for (k = 0, distance = 1 ; distance < PE_size ; k++, distance <<= 1) {
+        int peer = shmem_internal_active_set_pe((my_id + distance) % PE_size, PE_start, PE_stride);
+        size_t nbytes = 0;
+
+        for (i = distance ; i < PE_size ; i++) {
+            if (i & distance) {
+                memcpy(pack + nbytes, work + i * len, len);
+                nbytes += len;
+            }
+        }
+
+        /* Wait for the peer to free its scratch buffer */
+        SHMEM_WAIT_UNTIL(&pSync_ints[2 * k], SHMEM_CMP_NE, 0);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[2 * k], &neg_one, sizeof(int),
+                              shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        shmem_internal_put_nb(SHMEM_CTX_DEFAULT, scratch, pack, nbytes, peer, &completion);
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[2 * k + 1], &one, sizeof(int),
+                              peer, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        SHMEM_WAIT_UNTIL(&pSync_ints[2 * k + 1], SHMEM_CMP_NE, 0);
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[2 * k + 1], &neg_one, sizeof(int),
+                              shmem_internal_my_pe, SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+
+        for (i = distance, nbytes = 0 ; i < PE_size ; i++) {
+            if (i & distance) {
+                memcpy(work + i * len, scratch + nbytes, len);
+                nbytes += len;
+            }
+        }
+
+        /* Release the scratch buffer to the sender of the next step */
+        if (distance * 2 < PE_size) {
+            shmem_internal_atomic(SHMEM_CTX_DEFAULT, &pSync_ints[2 * (k + 1)], &one, sizeof(int),
+                                  shmem_internal_active_set_pe((my_id - distance * 2 + PE_size) % PE_size, PE_start, PE_stride),
+                                  SHM_INTERNAL_SUM, SHM_INTERNAL_INT);
+        }
+    }
+
+    /* Block i came from the PE at distance -i */
+    for (i = 0 ; i < PE_size ; i++)
+        memcpy((uint8_t *) dest + ((my_id - i + PE_size) % PE_size) * len, work + i * len, len);
+
+    free(pack);
+    free(work);
+
+    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+}
+
+
+/* Node-aware algorithm.  The PE with node rank r gathers, directly from
+ * the source buffers of the PEs on its node, the blocks destined to the PE
+ * with node rank r on every node, and sends them as a single message.
+ * This divides the number of messages on the network by the node size.
+ * Requires shmem_internal_coll_use_hier(), which provides the node layout
+ * and direct access to the source buffers of the node's PEs.
+ *
+ * The last pSync slot is used for the node barrier, and the remaining slots
+ * for the final dissemination barrier.
+ */
+void
+shmem_internal_alltoall_hier(void *dest, const void *source, size_t len,
+                             int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int node_size = shmem_internal_coll_node_size;
+    const int my_id = shmem_internal_my_pe - PE_start;
+    const int node_start = my_id - my_id % node_size;
+    const int node_rank = my_id - node_start;
+    const int my_node = my_id / node_size;
+    const int num_nodes = PE_size / node_size;
+    const int leader = PE_start + node_start;
+    long *node_psync = pSync + SHMEM_ALLTOALL_SYNC_SIZE - 1;
+    long zero = 0, one = 1;
+    const uint8_t **node_source;
+    uint8_t *pack;
+    long completion = 0;
+    int i, n;
+
+    /* need 1 slot, plus the dissemination barrier */
+    shmem_internal_assert(PE_size <= 1 << ((SHMEM_ALLTOALL_SYNC_SIZE - 1) * sizeof(long) / sizeof(int)));
+    shmem_internal_assert(PE_stride == 1 && node_size > 1);
+
+    if (0 == len)
+        return;
+
+    node_source = malloc(sizeof(uint8_t *) * node_size);
+    if (NULL == node_source)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n",
+                        sizeof(uint8_t *) * node_size);
+
+    for (i = 0 ; i < node_size ; i++)
+        node_source[i] = shmem_internal_ptr(source, PE_start + node_start + i);
+
+    pack = malloc(node_size * len);
+    if (NULL == pack)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n", node_size * len);
+
+    /* The source buffers of the node are read directly, wait until every PE
+     * of the node has entered the collective */
+    if (leader == shmem_internal_my_pe) {
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, node_size - 1);
+
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &zero, sizeof(zero),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, 0);
+
+        for (i = leader + 1; i < leader + node_size; i++)
+            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &one, sizeof(one), i);
+    } else {
+        shmem_internal_coll_node_arrive(node_psync, leader);
+
+        SHMEM_WAIT(node_psync, 0);
+
+        shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, node_psync, &zero, sizeof(zero),
+                                  shmem_internal_my_pe);
+        SHMEM_WAIT_UNTIL(node_psync, SHMEM_CMP_EQ, 0);
+    }
+
+    /* Send to the other nodes in a staggered order, ending with this node */
+    for (n = 1 ; n <= num_nodes ; n++) {
+        int node = (my_node + n) % num_nodes;
+        int dest_id = node * node_size + node_rank;
+
+        if (node == my_node) {
+            for (i = 0 ; i < node_size ; i++)
+                shmem_internal_copy((uint8_t *) dest + (node_start + i) * len,
+                                    node_source[i] + dest_id * len, len);
+        } else {
+            for (i = 0 ; i < node_size ; i++)
+                shmem_internal_copy(pack + i * len, node_source[i] + dest_id * len, len);
+
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, (uint8_t *) dest + node_start * len,
+                                  pack, node_size * len, PE_start + dest_id, &completion);
+            shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        }
+    }
+
+    /* Completes the puts, and keeps the source buffers in place until every
+     * PE of the node has read them */
+    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+    shmem_internal_sync_dissem(PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_ALLTOALL_SYNC_SIZE - 1; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+
+    free(pack);
+    free(node_source);
+}
+
+
+void
+shmem_internal_alltoalls_linear(void *dest, const void *source, ptrdiff_t dst,
+                                ptrdiff_t sst, size_t elem_size, size_t nelems,
+                                int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_as_rank = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
     const void *dest_base = (uint8_t *) dest + my_as_rank * nelems * dst * elem_size;
     int peer, start_pe, i;
 
@@ -1273,17 +2504,18 @@ shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
     peer = start_pe;
     do {
         size_t i;
-        int peer_as_rank    = (peer - PE_start) / PE_stride; /* Peer's index in active set */
+        int peer_as_rank    = shmem_internal_pe_in_active_set(peer, PE_start, PE_stride, PE_size); /* Peer's index in active set */
         uint8_t *dest_ptr   = (uint8_t *) dest_base;
         uint8_t *source_ptr = (uint8_t *) source + peer_as_rank * nelems * sst * elem_size;
 
         for (i = nelems ; i > 0; i--) {
-            shmem_internal_put_scalar(SHMEM_CTX_DEFAULT, (void *) dest_ptr, (uint8_t *) source_ptr,
-                                     elem_size, peer);
+            shmem_internal_put_scalar_batch(SHMEM_CTX_DEFAULT, (void *) dest_ptr,
+                                            (uint8_t *) source_ptr, elem_size, peer);
 
             source_ptr += sst * elem_size;
             dest_ptr   += dst * elem_size;
         }
+        shmem_internal_put_flush(SHMEM_CTX_DEFAULT, peer);
         peer = shmem_internal_circular_iter_next(peer, PE_start, PE_stride,
                                                  PE_size);
     } while (peer != start_pe);
@@ -1293,3 +2525,568 @@ shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
     for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
         pSync[i] = SHMEM_SYNC_VALUE;
 }
+
+
+static inline
+void
+shmem_internal_strided_copy(void *dest, ptrdiff_t dst, const void *source,
+                            ptrdiff_t sst, size_t elem_size, size_t nelems)
+{
+    uint8_t *dest_ptr = (uint8_t *) dest;
+    const uint8_t *source_ptr = (const uint8_t *) source;
+    size_t i;
+
+    if (dst == 1 && sst == 1) {
+        shmem_internal_copy(dest, source, nelems * elem_size);
+        return;
+    }
+
+    for (i = 0 ; i < nelems ; i++) {
+        memcpy(dest_ptr, source_ptr, elem_size);
+        dest_ptr   += dst * elem_size;
+        source_ptr += sst * elem_size;
+    }
+}
+
+
+/* Packed algorithm.  The elements sent to each peer are packed into a
+ * contiguous message, received in the staging buffer reserved at
+ * initialization, and scattered into the destination by the target.
+ * Messages are sent in rounds of SHMEM_ALLTOALL_WINDOW peers, each peer
+ * owning a slot of one half of the staging buffer, and blocks that don't
+ * fit a slot are sent over several rounds.  The barrier ending a round
+ * completes its messages, and successive rounds alternate between the two
+ * halves, so a round never overwrites a half that is being unpacked.
+ * Peers whose memory is directly accessible are written in place.
+ */
+void
+shmem_internal_alltoalls_packed(void *dest, const void *source, ptrdiff_t dst,
+                                ptrdiff_t sst, size_t elem_size, size_t nelems,
+                                int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    const int my_id = shmem_internal_pe_in_active_set(shmem_internal_my_pe, PE_start, PE_stride, PE_size);
+    const size_t dest_block = nelems * dst * elem_size;
+    const size_t source_block = nelems * sst * elem_size;
+    const size_t half_len = shmem_internal_alltoalls_staging_len / 2;
+    long window = shmem_internal_params.ALLTOALL_WINDOW;
+    size_t slot_len, chunk_nelems, first;
+    uint8_t *pack;
+    int round = 0, step, i, k;
+
+    shmem_internal_assert(SHMEM_ALLTOALLS_SYNC_SIZE >= SHMEM_BARRIER_SYNC_SIZE);
+
+    if (0 == nelems)
+        return;
+
+    if (window < 1) window = 1;
+    if (window > PE_size - 1) window = PE_size > 1 ? PE_size - 1 : 1;
+
+    slot_len = half_len / window;
+    chunk_nelems = slot_len / elem_size;
+    shmem_internal_assert(chunk_nelems > 0);
+
+    shmem_internal_strided_copy((uint8_t *) dest + my_id * dest_block, dst,
+                                (uint8_t *) source + my_id * source_block, sst,
+                                elem_size, nelems);
+
+    if (PE_size == 1)
+        return;
+
+    pack = malloc(window * slot_len);
+    if (NULL == pack)
+        RAISE_ERROR_MSG("Unable to allocate %zub temporary buffer\n", window * slot_len);
+
+    for (first = 0 ; first < nelems ; first += chunk_nelems) {
+        size_t count = (nelems - first < chunk_nelems) ? nelems - first : chunk_nelems;
+
+        for (step = 1 ; step < PE_size ; step += window, round++) {
+            uint8_t *half = (uint8_t *) shmem_internal_alltoalls_staging + (round % 2) * half_len;
+            int nsteps = (PE_size - step < window) ? PE_size - step : window;
+
+            /* Send to the PEs at distance step ... step + nsteps - 1 */
+            for (k = 0 ; k < nsteps ; k++) {
+                int peer_id = (my_id + step + k) % PE_size;
+                int peer = shmem_internal_active_set_pe(peer_id, PE_start, PE_stride);
+                const uint8_t *source_ptr = (uint8_t *) source + peer_id * source_block +
+                                            first * sst * elem_size;
+                uint8_t *remote_ptr = shmem_internal_ptr((uint8_t *) dest + my_id * dest_block,
+                                                         peer);
+
+                if (NULL != remote_ptr) {
+                    shmem_internal_strided_copy(remote_ptr + first * dst * elem_size, dst,
+                                                source_ptr, sst, elem_size, count);
+                } else {
+                    shmem_internal_strided_copy(pack + k * slot_len, 1, source_ptr, sst,
+                                                elem_size, count);
+                    shmem_internal_put_nbi(SHMEM_CTX_DEFAULT, half + k * slot_len,
+                                           pack + k * slot_len, count * elem_size, peer);
+                }
+            }
+
+            shmem_internal_barrier(PE_start, PE_stride, PE_size, pSync);
+
+            /* Unpack from the PEs at distance -step ... -(step + nsteps - 1) */
+            for (k = 0 ; k < nsteps ; k++) {
+                int peer_id = (my_id - step - k + PE_size) % PE_size;
+
+                if (NULL == shmem_internal_ptr(dest, shmem_internal_active_set_pe(peer_id, PE_start, PE_stride))) {
+                    shmem_internal_strided_copy((uint8_t *) dest + peer_id * dest_block +
+                                                first * dst * elem_size, dst,
+                                                half + k * slot_len, 1, elem_size, count);
+                }
+            }
+        }
+    }
+
+    /* Keep the next call from writing a half that is being unpacked */
+    shmem_internal_barrier(PE_start, PE_stride, PE_size, pSync);
+
+    for (i = 0; i < SHMEM_BARRIER_SYNC_SIZE; i++)
+        pSync[i] = SHMEM_SYNC_VALUE;
+
+    free(pack);
+}
+
+
+/*****************************************
+ *
+ * PERSISTENT COLLECTIVES
+ *
+ *****************************************/
+void
+shmem_internal_coll_req_plan(shmem_internal_coll_req_t *req)
+{
+    int root = 0;
+
+    req->tree.parent = shmem_internal_my_pe;
+    req->tree.num_children = 0;
+    req->tree.children = NULL;
+
+    switch (req->coll) {
+    case COLL_REDUCE:
+        req->type = shmem_internal_op_to_all_select(req->count, req->type_size,
+                                                    req->PE_start, req->PE_stride,
+                                                    req->PE_size, req->op, req->datatype);
+        break;
+    case COLL_BCAST:
+        req->type = shmem_internal_bcast_select(req->count * req->type_size, req->PE_size);
+        root = req->PE_root;
+        break;
+    case COLL_FCOLLECT:
+        req->type = shmem_internal_fcollect_select(req->PE_size);
+        break;
+    default:
+        RAISE_ERROR_MSG("Illegal persistent collective (%d)\n", req->coll);
+    }
+
+    /* The reduction tree also carries the broadcast of the result */
+    if ((TREE == req->type || PIPELINE == req->type) && req->PE_size > 1) {
+        int *children = malloc(sizeof(int) * tree_radix);
+
+        if (NULL == children)
+            RAISE_ERROR_MSG("Unable to allocate %zub tree\n", sizeof(int) * tree_radix);
+
+        shmem_internal_coll_tree(&req->tree, children, root, req->PE_start,
+                                 req->PE_stride, req->PE_size);
+        if (req->tree.children != children)
+            free(children);
+    }
+
+    DEBUG_MSG("Persistent collective %d: %s, <%d, %d, %d>, %zu x %zuB\n", req->coll,
+              coll_type_str[req->type], req->PE_start, req->PE_stride, req->PE_size,
+              req->count, req->type_size);
+}
+
+
+void
+shmem_internal_coll_req_start(shmem_internal_coll_req_t *req)
+{
+    const size_t len = req->count * req->type_size;
+
+    /* A peer may still be in the previous start of this request, e.g. an
+     * interior tree node that is forwarding the last payload and waiting for
+     * acks in the request pSync, or a recursive doubling partner that has not
+     * yet observed its flag.  Wait for every PE to finish it before reusing
+     * the pSync and buffers. */
+    if (req->started && req->PE_size > 1) {
+        long *psync = shmem_internal_team_choose_psync(req->team, SYNC);
+        shmem_internal_sync(req->PE_start, req->PE_stride, req->PE_size, psync);
+        shmem_internal_team_release_psyncs(req->team, SYNC);
+    }
+    req->started = 1;
+
+    switch (req->coll) {
+    case COLL_REDUCE:
+        if (TREE == req->type && req->PE_size > 1 && req->count > 0)
+            shmem_internal_op_to_all_tree_sched(&req->tree, req->dest, req->source,
+                                                req->count, req->type_size,
+                                                req->PE_start, req->PE_stride,
+                                                req->PE_size, req->psync, req->op,
+                                                req->datatype);
+        else
+            shmem_internal_op_to_all_run(req->type, req->dest, req->source,
+                                         req->count, req->type_size, req->PE_start,
+                                         req->PE_stride, req->PE_size, NULL,
+                                         req->psync, req->op, req->datatype);
+        break;
+    case COLL_BCAST:
+        /* The root's dest also receives the data */
+        if (req->dest != req->source && req->PE_root ==
+            shmem_internal_pe_in_active_set(shmem_internal_my_pe, req->PE_start,
+                                            req->PE_stride, req->PE_size))
+            memcpy(req->dest, req->source, len);
+
+        if (req->PE_size == 1 || len == 0)
+            break;
+        else if (TREE == req->type)
+            shmem_internal_bcast_tree_sched(&req->tree, req->dest, req->source,
+                                            len, req->psync, 1);
+        else if (PIPELINE == req->type)
+            shmem_internal_bcast_pipeline_sched(&req->tree, req->dest, req->source,
+                                                len, req->psync, 1);
+        else
+            shmem_internal_bcast_run(req->type, req->dest, req->source, len,
+                                     req->PE_root, req->PE_start, req->PE_stride,
+                                     req->PE_size, req->psync, 1);
+        break;
+    case COLL_FCOLLECT:
+        shmem_internal_fcollect_run(req->type, req->dest, req->source, len,
+                                    req->PE_start, req->PE_stride, req->PE_size,
+                                    req->psync);
+        break;
+    default:
+        RAISE_ERROR_MSG("Illegal persistent collective (%d)\n", req->coll);
+    }
+}
+
+
+void
+shmem_internal_coll_req_fini(shmem_internal_coll_req_t *req)
+{
+    if (req->tree.children != full_tree_children)
+        free(req->tree.children);
+
+    req->tree.children = NULL;
+}
+
+
+/*****************************************
+ *
+ * NON-BLOCKING COLLECTIVES
+ *
+ *****************************************/
+/* Non-blocking collectives run on a k-ary tree rooted at PE_root.  Children
+ * report up to their parent, which releases them with a down message once its
+ * own parent has released it.  Reductions and fcollects leave their partial
+ * result in dest before reporting up, the parent reads it with a get, and the
+ * result is put down the tree.
+ *
+ * Each team has an up and a down counter that are only ever incremented, and a
+ * request waits for the running totals that it expects.  No PE completes a
+ * collective before every PE has reported up, so a message sent for the next
+ * collective on the team cannot satisfy a wait in the current one, as long as
+ * each PE runs the collectives on a team one at a time, in posting order. */
+
+#define NBC_UP   0
+#define NBC_DOWN 1
+
+static void
+nbc_begin(shmem_internal_coll_req_t *req)
+{
+    shmem_internal_team_t *team = req->team;
+    const size_t len = req->count * req->type_size;
+
+    team->nbc_up += req->tree.num_children;
+    req->up_target = team->nbc_up;
+
+    if (req->tree.parent != shmem_internal_my_pe) {
+        team->nbc_down += 1;
+        req->down_target = team->nbc_down;
+    }
+
+    switch (req->coll) {
+    case COLL_REDUCE:
+        memcpy(req->buf, req->source, len);
+        break;
+    case COLL_BCAST:
+        /* The root's dest also receives the data, and is sent from there */
+        if (req->tree.parent == shmem_internal_my_pe && req->dest != req->source)
+            memcpy(req->dest, req->source, len);
+        break;
+    case COLL_FCOLLECT:
+        memcpy((char *) req->dest + team->my_pe * len, req->source, len);
+        break;
+    default:
+        break;
+    }
+}
+
+
+/* Pull the children's partial results once they have reported up */
+static void
+nbc_gather(shmem_internal_coll_req_t *req)
+{
+    const size_t len = req->count * req->type_size;
+    const int num_children = req->tree.num_children;
+    const int *children = req->tree.children;
+    char *acc = req->buf;
+    int i;
+
+    switch (req->coll) {
+    case COLL_REDUCE:
+        for (i = 0; i < num_children; i++)
+            shmem_internal_get(SHMEM_CTX_DEFAULT, acc + (i + 1) * len, req->dest,
+                               len, children[i]);
+        shmem_internal_get_wait(SHMEM_CTX_DEFAULT);
+
+        for (i = 0; i < num_children; i++)
+            shmem_internal_reduce_local(req->op, req->datatype, req->count,
+                                        acc + (i + 1) * len, acc);
+
+        memcpy(req->dest, acc, len);
+        break;
+    case COLL_FCOLLECT:
+        /* The fcollect tree is rooted at index 0, so the subtree below index c
+         * is c itself, then c*k+1 ... c*k+k, and so on, one range per level */
+        for (i = 0; i < num_children; i++) {
+            long first = shmem_internal_pe_in_active_set(children[i], req->PE_start,
+                                                         req->PE_stride, req->PE_size);
+            long width = 1;
+
+            while (first < req->PE_size) {
+                long nblocks = (first + width > req->PE_size) ?
+                               req->PE_size - first : width;
+
+                shmem_internal_get(SHMEM_CTX_DEFAULT, (char *) req->dest + first * len,
+                                   (char *) req->dest + first * len, nblocks * len,
+                                   children[i]);
+                first = first * tree_radix + 1;
+                width *= tree_radix;
+            }
+        }
+        shmem_internal_get_wait(SHMEM_CTX_DEFAULT);
+        break;
+    default:
+        break;
+    }
+}
+
+
+/* Push the result to the children and release them */
+static void
+nbc_release(shmem_internal_coll_req_t *req)
+{
+    long one = 1, completion = 0;
+    long *nbc_psync = shmem_internal_team_nbc_psync(req->team);
+    const int num_children = req->tree.num_children;
+    const int *children = req->tree.children;
+    size_t len = req->count * req->type_size;
+    int i;
+
+    if (0 == num_children) return;
+
+    switch (req->coll) {
+    case COLL_FCOLLECT:
+        len *= req->PE_size;
+        break;
+    case COLL_BARRIER:
+        len = 0;
+        break;
+    default:
+        break;
+    }
+
+    if (len > 0) {
+        for (i = 0; i < num_children; i++)
+            shmem_internal_put_nb(SHMEM_CTX_DEFAULT, req->dest, req->dest, len,
+                                  children[i], &completion);
+        shmem_internal_put_wait(SHMEM_CTX_DEFAULT, &completion);
+        shmem_internal_fence(SHMEM_CTX_DEFAULT);
+    }
+
+    for (i = 0; i < num_children; i++)
+        shmem_internal_atomic(SHMEM_CTX_DEFAULT, &nbc_psync[NBC_DOWN], &one,
+                              sizeof(one), children[i], SHM_INTERNAL_SUM,
+                              SHM_INTERNAL_LONG);
+}
+
+
+/* Advance a request as far as it can go without blocking, returns nonzero
+ * once it has completed */
+static int
+nbc_progress_req(shmem_internal_coll_req_t *req)
+{
+    long one = 1;
+    long *nbc_psync = shmem_internal_team_nbc_psync(req->team);
+    const int parent = req->tree.parent;
+    int cmpret;
+
+    switch (req->state) {
+    case COLL_STATE_QUEUED:
+        if (req->team->nbc_completed != req->seq)
+            return 0;
+
+        nbc_begin(req);
+        req->state = COLL_STATE_UP;
+        /* fall through */
+    case COLL_STATE_UP:
+        SHMEM_TEST(SHMEM_CMP_GE, &nbc_psync[NBC_UP], req->up_target, cmpret);
+        if (!cmpret)
+            return 0;
+
+        shmem_internal_membar_acq_rel();
+        shmem_transport_syncmem();
+
+        nbc_gather(req);
+
+        if (parent != shmem_internal_my_pe) {
+            shmem_internal_membar_acq_rel();
+            shmem_internal_atomic(SHMEM_CTX_DEFAULT, &nbc_psync[NBC_UP], &one,
+                                  sizeof(one), parent, SHM_INTERNAL_SUM,
+                                  SHM_INTERNAL_LONG);
+        }
+        req->state = COLL_STATE_DOWN;
+        /* fall through */
+    case COLL_STATE_DOWN:
+        if (parent != shmem_internal_my_pe) {
+            SHMEM_TEST(SHMEM_CMP_GE, &nbc_psync[NBC_DOWN], req->down_target, cmpret);
+            if (!cmpret)
+                return 0;
+
+            shmem_internal_membar_acq_rel();
+            shmem_transport_syncmem();
+        }
+
+        nbc_release(req);
+
+        free(req->buf);
+        req->buf = NULL;
+        req->team->nbc_completed++;
+        req->state = COLL_STATE_DONE;
+        /* fall through */
+    case COLL_STATE_DONE:
+        return 1;
+    default:
+        RAISE_ERROR_MSG("Illegal non-blocking collective state (%d)\n", req->state);
+    }
+
+    return 0;
+}
+
+
+/* Called with nbc_lock held */
+static void
+nbc_progress(void)
+{
+    shmem_internal_coll_req_t *req = nbc_head, *prev = NULL;
+
+    while (req != NULL) {
+        shmem_internal_coll_req_t *next = req->next;
+
+        if (nbc_progress_req(req)) {
+            if (prev == NULL)
+                nbc_head = next;
+            else
+                prev->next = next;
+            if (nbc_tail == req)
+                nbc_tail = prev;
+            req->next = NULL;
+        } else {
+            prev = req;
+        }
+
+        req = next;
+    }
+}
+
+
+void
+shmem_internal_coll_req_post(shmem_internal_coll_req_t *req)
+{
+    const int root = (COLL_BCAST == req->coll) ? req->PE_root : 0;
+    const size_t len = req->count * req->type_size;
+
+    req->tree.parent = shmem_internal_my_pe;
+    req->tree.num_children = 0;
+    req->tree.children = NULL;
+    req->buf = NULL;
+    req->next = NULL;
+
+    if (req->PE_size > 1) {
+        req->tree.children = malloc(sizeof(int) * tree_radix);
+        if (NULL == req->tree.children)
+            RAISE_ERROR_MSG("Unable to allocate %zub tree\n", sizeof(int) * tree_radix);
+
+        shmem_internal_build_kary_tree(tree_radix, req->PE_start, req->PE_stride,
+                                       req->PE_size, root, &req->tree.parent,
+                                       &req->tree.num_children, req->tree.children);
+    }
+
+    /* Reductions keep an accumulator and one buffer per child */
+    if (COLL_REDUCE == req->coll && len > 0) {
+        req->buf = malloc((1 + req->tree.num_children) * len);
+        if (NULL == req->buf)
+            RAISE_ERROR_MSG("Unable to allocate %zub reduction buffer\n",
+                            (1 + req->tree.num_children) * len);
+    }
+
+    SHMEM_MUTEX_LOCK(nbc_lock);
+
+    req->seq = req->team->nbc_posted++;
+    req->state = COLL_STATE_QUEUED;
+
+    if (nbc_tail == NULL)
+        nbc_head = req;
+    else
+        nbc_tail->next = req;
+    nbc_tail = req;
+
+    nbc_progress();
+
+    SHMEM_MUTEX_UNLOCK(nbc_lock);
+}
+
+
+int
+shmem_internal_coll_req_test(shmem_internal_coll_req_t *req)
+{
+    int ret;
+
+    SHMEM_MUTEX_LOCK(nbc_lock);
+    nbc_progress();
+    ret = (COLL_STATE_DONE == req->state);
+    SHMEM_MUTEX_UNLOCK(nbc_lock);
+
+    return ret;
+}
+
+
+void
+shmem_internal_coll_req_wait(shmem_internal_coll_req_t *req)
+{
+    while (!shmem_internal_coll_req_test(req)) {
+        shmem_shr_transport_probe();
+        shmem_transport_probe();
+        SPINLOCK_BODY();
+    }
+}
+
+
+void
+shmem_internal_coll_nbc_drain(shmem_internal_team_t *team)
+{
+    int done;
+
+    do {
+        SHMEM_MUTEX_LOCK(nbc_lock);
+        nbc_progress();
+        done = (team->nbc_completed == team->nbc_posted);
+        SHMEM_MUTEX_UNLOCK(nbc_lock);
+
+        if (!done) {
+            shmem_shr_transport_probe();
+            shmem_transport_probe();
+            SPINLOCK_BODY();
+        }
+    } while (!done);
+}
@@ -65,6 +65,7 @@ shmem_ctx_destroy(shmem_ctx_t ctx)
     }
 
     shmem_internal_quiet(ctx);
+    shmem_shr_transport_ctx_destroy(ctx);
     shmem_transport_ctx_destroy((shmem_transport_ctx_t *) ctx);
 
     return;
@@ -37,6 +37,9 @@
 #include "runtime.h"
 #include "build_info.h"
 #include "shmem_team.h"
+#include "shmem_copy.h"
+#include "shmem_wait.h"
+#include "shmem_internal_op.h"
 
 #if defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING) && defined(__linux__)
 #include <sys/personality.h>
@@ -119,6 +122,8 @@ shmem_internal_shutdown(void)
 
     shmem_shr_transport_fini();
 
+    shmem_internal_wait_fini();
+
     SHMEM_MUTEX_DESTROY(shmem_internal_mutex_alloc);
 
     shmem_internal_randr_fini();
@@ -211,6 +216,13 @@ shmem_internal_init(int tl_requested, int *tl_provided)
         shmem_internal_params.BOUNCE_SIZE = 0;
     }
 
+    /* Select the local copy engine before any on-node communication */
+    shmem_internal_copy_init();
+    shmem_internal_op_init();
+
+    ret = shmem_internal_wait_init();
+    if (ret) goto cleanup;
+
     /* Print library parameters */
     if (0 == shmem_internal_my_pe) {
         if (shmem_internal_params.VERSION || shmem_internal_params.INFO ||
@@ -416,6 +428,12 @@ shmem_internal_init(int tl_requested, int *tl_provided)
     }
     teams_initialized = 1;
 
+    ret = shmem_internal_collectives_node_init();
+    if (ret != 0) {
+        RETURN_ERROR_MSG("Initialization of hierarchical collectives failed (%d)\n", ret);
+        goto cleanup;
+    }
+
     shmem_internal_randr_init();
     randr_initialized = 1;
 
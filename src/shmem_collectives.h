@@ -25,7 +25,14 @@ enum coll_type_t {
     TREE,
     DISSEM,
     RING,
-    RECDBL
+    RECDBL,
+    HIER,
+    RABENSEIFNER,
+    PIPELINE,
+    SCATTER,
+    BRUCK,
+    PAIRWISE,
+    PACKED
 };
 typedef enum coll_type_t coll_type_t;
 
@@ -39,10 +46,40 @@ extern coll_type_t shmem_internal_bcast_type;
 extern coll_type_t shmem_internal_reduce_type;
 extern coll_type_t shmem_internal_collect_type;
 extern coll_type_t shmem_internal_fcollect_type;
+extern coll_type_t shmem_internal_alltoall_type;
+extern coll_type_t shmem_internal_alltoalls_type;
+
+/* Number of PEs per node when every node holds the same number of
+ * consecutive PEs in SHMEM_TEAM_SHARED, otherwise 1.  Set by the first
+ * shmem_barrier_all while shmem_internal_coll_node_pending is set. */
+extern int shmem_internal_coll_node_size;
+extern int shmem_internal_coll_node_pending;
+
+int shmem_internal_collectives_node_init(void);
+void shmem_internal_collectives_node_detect(void);
 
 void shmem_internal_sync_linear(int PE_start, int PE_stride, int PE_size, long *pSync);
 void shmem_internal_sync_tree(int PE_start, int PE_stride, int PE_size, long *pSync);
 void shmem_internal_sync_dissem(int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_sync_hier(int PE_start, int PE_stride, int PE_size, long *pSync);
+
+/* The hierarchical algorithms require load/store access to the other PEs of
+ * the node, which CMA does not provide, and an active set made of whole nodes
+ * that spans more than one node.  Otherwise, the selectors fall back to the
+ * flat algorithms. */
+static inline
+int
+shmem_internal_coll_use_hier(int PE_start, int PE_stride, int PE_size)
+{
+#if USE_XPMEM || USE_SHM
+    const int node_size = shmem_internal_coll_node_size;
+
+    return node_size > 1 && PE_stride == 1 && PE_start % node_size == 0 &&
+           PE_size % node_size == 0 && PE_size > node_size;
+#else
+    return 0;
+#endif
+}
 
 static inline
 void
@@ -57,7 +94,9 @@ shmem_internal_sync(int PE_start, int PE_stride, int PE_size, long *pSync)
 
     switch (shmem_internal_barrier_type) {
     case AUTO:
-        if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
+        if (shmem_internal_coll_use_hier(PE_start, PE_stride, PE_size)) {
+            shmem_internal_sync_hier(PE_start, PE_stride, PE_size, pSync);
+        } else if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
             shmem_internal_sync_linear(PE_start, PE_stride, PE_size, pSync);
         } else {
             shmem_internal_sync_tree(PE_start, PE_stride, PE_size, pSync);
@@ -72,6 +111,12 @@ shmem_internal_sync(int PE_start, int PE_stride, int PE_size, long *pSync)
     case DISSEM:
         shmem_internal_sync_dissem(PE_start, PE_stride, PE_size, pSync);
         break;
+    case HIER:
+        if (shmem_internal_coll_use_hier(PE_start, PE_stride, PE_size))
+            shmem_internal_sync_hier(PE_start, PE_stride, PE_size, pSync);
+        else
+            shmem_internal_sync_tree(PE_start, PE_stride, PE_size, pSync);
+        break;
     default:
         RAISE_ERROR_MSG("Illegal barrier/sync type (%d)\n",
                         shmem_internal_barrier_type);
@@ -105,7 +150,11 @@ void
 shmem_internal_barrier_all(void)
 {
     shmem_internal_quiet(SHMEM_CTX_DEFAULT);
-    shmem_internal_sync(0, 1, shmem_internal_num_pes, shmem_internal_barrier_all_psync);
+
+    if (shmem_internal_coll_node_pending)
+        shmem_internal_collectives_node_detect();
+    else
+        shmem_internal_sync(0, 1, shmem_internal_num_pes, shmem_internal_barrier_all_psync);
 }
 
 
@@ -115,23 +164,40 @@ void shmem_internal_bcast_linear(void *target, const void *source, size_t len,
 void shmem_internal_bcast_tree(void *target, const void *source, size_t len,
                                int PE_root, int PE_start, int PE_stride, int PE_size,
                                long *pSync, int complete);
-
+void shmem_internal_bcast_pipeline(void *target, const void *source, size_t len,
+                                   int PE_root, int PE_start, int PE_stride, int PE_size,
+                                   long *pSync, int complete);
+void shmem_internal_bcast_scatter(void *target, const void *source, size_t len,
+                                  int PE_root, int PE_start, int PE_stride, int PE_size,
+                                  long *pSync, int complete);
+
+/* Resolve the broadcast algorithm for a message and active set size */
 static inline
-void
-shmem_internal_bcast(void *target, const void *source, size_t len,
-                     int PE_root, int PE_start, int PE_stride, int PE_size,
-                     long *pSync, int complete)
+coll_type_t
+shmem_internal_bcast_select(size_t len, int PE_size)
 {
     switch (shmem_internal_bcast_type) {
     case AUTO:
-        if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
-            shmem_internal_bcast_linear(target, source, len, PE_root, PE_start,
-                                        PE_stride, PE_size, pSync, complete);
-        } else {
-            shmem_internal_bcast_tree(target, source, len, PE_root, PE_start,
-                                      PE_stride, PE_size, pSync, complete);
-        }
-        break;
+        if (len >= shmem_internal_params.BCAST_SCATTER_CROSSOVER && PE_size > 2)
+            return SCATTER;
+        else if (PE_size < shmem_internal_params.COLL_CROSSOVER)
+            return LINEAR;
+        else if (len > shmem_internal_params.BCAST_SEGMENT_SIZE)
+            return PIPELINE;
+        else
+            return TREE;
+    default:
+        return shmem_internal_bcast_type;
+    }
+}
+
+static inline
+void
+shmem_internal_bcast_run(coll_type_t type, void *target, const void *source, size_t len,
+                         int PE_root, int PE_start, int PE_stride, int PE_size,
+                         long *pSync, int complete)
+{
+    switch (type) {
     case LINEAR:
         shmem_internal_bcast_linear(target, source, len, PE_root, PE_start,
                                     PE_stride, PE_size, pSync, complete);
@@ -140,12 +206,30 @@ shmem_internal_bcast(void *target, const void *source, size_t len,
         shmem_internal_bcast_tree(target, source, len, PE_root, PE_start,
                                   PE_stride, PE_size, pSync, complete);
         break;
+    case PIPELINE:
+        shmem_internal_bcast_pipeline(target, source, len, PE_root, PE_start,
+                                      PE_stride, PE_size, pSync, complete);
+        break;
+    case SCATTER:
+        shmem_internal_bcast_scatter(target, source, len, PE_root, PE_start,
+                                     PE_stride, PE_size, pSync, complete);
+        break;
     default:
-        RAISE_ERROR_MSG("Illegal broadcast type (%d)\n",
-                        shmem_internal_bcast_type);
+        RAISE_ERROR_MSG("Illegal broadcast type (%d)\n", type);
     }
 }
 
+static inline
+void
+shmem_internal_bcast(void *target, const void *source, size_t len,
+                     int PE_root, int PE_start, int PE_stride, int PE_size,
+                     long *pSync, int complete)
+{
+    shmem_internal_bcast_run(shmem_internal_bcast_select(len, PE_size), target,
+                             source, len, PE_root, PE_start, PE_stride, PE_size,
+                             pSync, complete);
+}
+
 
 void shmem_internal_op_to_all_linear(void *target, const void *source, size_t count, size_t type_size,
                                      int PE_start, int PE_stride, int PE_size,
@@ -164,51 +248,97 @@ void shmem_internal_op_to_all_recdbl_sw(void *target, const void *source, size_t
                                    int PE_start, int PE_stride, int PE_size,
                                    void *pWrk, long *pSync,
                                    shm_internal_op_t op, shm_internal_datatype_t datatype);
+void shmem_internal_op_to_all_rabenseifner(void *target, const void *source, size_t count,
+                                           size_t type_size, int PE_start, int PE_stride,
+                                           int PE_size, void *pWrk, long *pSync,
+                                           shm_internal_op_t op, shm_internal_datatype_t datatype);
+void shmem_internal_op_to_all_hier(void *target, const void *source, size_t count, size_t type_size,
+                                   int PE_start, int PE_stride, int PE_size,
+                                   void *pWrk, long *pSync,
+                                   shm_internal_op_t op, shm_internal_datatype_t datatype);
 
+/* Largest reduction, in bytes, that can exchange its values through the pSync */
+#define SHMEM_INTERNAL_REDUCE_SMALL_MAX 64
+
+int  shmem_internal_reduce_small_words(size_t len, int PE_size);
+void shmem_internal_reduce_small_send(long *slot, const void *val, size_t len,
+                                      int nwords, int pe);
+void shmem_internal_reduce_small_recv(long *slot, void *val, size_t len, int nwords);
+
+/* Reduction without network atomics: recursive doubling for small messages,
+ * then Rabenseifner's algorithm, or the ring for few PEs */
 static inline
-void
-shmem_internal_op_to_all(void *target, const void *source, size_t count,
-                         size_t type_size, int PE_start, int PE_stride,
-                         int PE_size, void *pWrk, long *pSync,
-                         shm_internal_op_t op,
-                         shm_internal_datatype_t datatype)
+coll_type_t
+shmem_internal_op_to_all_sw_select(size_t len, int PE_size)
 {
-    shmem_internal_assert(type_size > 0);
+    if (len < shmem_internal_params.COLL_SIZE_CROSSOVER)
+        return RECDBL;
+    else if (PE_size >= shmem_internal_params.COLL_CROSSOVER)
+        return RABENSEIFNER;
+    else
+        return RING;
+}
 
+/* AMO-based reductions push vector AMOs through the network transport.  When
+ * CMA shared memory atomics are active, heap AMOs between on-node PEs use
+ * processor atomics instead, and the two must not be mixed on one location. */
+static inline
+int
+shmem_internal_reduce_amo_supported(shm_internal_op_t op,
+                                    shm_internal_datatype_t datatype)
+{
+#ifdef USE_CMA
+    if (shmem_transport_cma_shr_atomics)
+        return 0;
+#endif
+    return shmem_transport_atomic_supported(op, datatype);
+}
+
+/* Resolve the reduction algorithm for a message, active set and operation */
+static inline
+coll_type_t
+shmem_internal_op_to_all_select(size_t count, size_t type_size, int PE_start,
+                                int PE_stride, int PE_size, shm_internal_op_t op,
+                                shm_internal_datatype_t datatype)
+{
     switch (shmem_internal_reduce_type) {
         case AUTO:
-            if (shmem_transport_atomic_supported(op, datatype)) {
-                if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
-                    shmem_internal_op_to_all_linear(target, source, count, type_size,
-                                                    PE_start, PE_stride, PE_size,
-                                                    pWrk, pSync, op, datatype);
-                } else {
-                    shmem_internal_op_to_all_tree(target, source, count, type_size,
-                                                  PE_start, PE_stride, PE_size,
-                                                  pWrk, pSync, op, datatype);
-                }
-            } else {
-                if (count * type_size < shmem_internal_params.COLL_SIZE_CROSSOVER)
-                    shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
-                                                       PE_start, PE_stride, PE_size,
-                                                       pWrk, pSync, op, datatype);
-                else
-                    shmem_internal_op_to_all_ring(target, source, count, type_size,
-                                                  PE_start, PE_stride, PE_size,
-                                                  pWrk, pSync, op, datatype);
-            }
+            if (shmem_internal_coll_use_hier(PE_start, PE_stride, PE_size))
+                return HIER;
+            else if (!shmem_internal_reduce_amo_supported(op, datatype))
+                return shmem_internal_op_to_all_sw_select(count * type_size, PE_size);
+            else if (PE_size < shmem_internal_params.COLL_CROSSOVER)
+                return LINEAR;
+            else
+                return TREE;
+        case LINEAR:
+        case TREE:
+            if (shmem_internal_reduce_amo_supported(op, datatype))
+                return shmem_internal_reduce_type;
+            else
+                return RECDBL;
+        case HIER:
+            if (shmem_internal_coll_use_hier(PE_start, PE_stride, PE_size))
+                return HIER;
+            else
+                return shmem_internal_op_to_all_sw_select(count * type_size, PE_size);
+        default:
+            return shmem_internal_reduce_type;
+    }
+}
 
-            break;
+static inline
+void
+shmem_internal_op_to_all_run(coll_type_t type, void *target, const void *source,
+                             size_t count, size_t type_size, int PE_start,
+                             int PE_stride, int PE_size, void *pWrk, long *pSync,
+                             shm_internal_op_t op, shm_internal_datatype_t datatype)
+{
+    switch (type) {
         case LINEAR:
-            if (shmem_transport_atomic_supported(op, datatype)) {
-                shmem_internal_op_to_all_linear(target, source, count, type_size,
-                                                PE_start, PE_stride, PE_size,
-                                                pWrk, pSync, op, datatype);
-            } else {
-                shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
-                                                   PE_start, PE_stride, PE_size,
-                                                   pWrk, pSync, op, datatype);
-            }
+            shmem_internal_op_to_all_linear(target, source, count, type_size,
+                                            PE_start, PE_stride, PE_size,
+                                            pWrk, pSync, op, datatype);
             break;
         case RING:
             shmem_internal_op_to_all_ring(target, source, count, type_size,
@@ -216,30 +346,79 @@ shmem_internal_op_to_all(void *target, const void *source, size_t count,
                                           pWrk, pSync, op, datatype);
             break;
         case TREE:
-            if (shmem_transport_atomic_supported(op, datatype)) {
-                shmem_internal_op_to_all_tree(target, source, count, type_size,
-                                              PE_start, PE_stride, PE_size,
-                                              pWrk, pSync, op, datatype);
-            } else {
-                shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
-                                                   PE_start, PE_stride, PE_size,
-                                                   pWrk, pSync, op, datatype);
-            }
+            shmem_internal_op_to_all_tree(target, source, count, type_size,
+                                          PE_start, PE_stride, PE_size,
+                                          pWrk, pSync, op, datatype);
             break;
         case RECDBL:
             shmem_internal_op_to_all_recdbl_sw(target, source, count, type_size,
                                                PE_start, PE_stride, PE_size,
                                                pWrk, pSync, op, datatype);
             break;
+        case HIER:
+            shmem_internal_op_to_all_hier(target, source, count, type_size,
+                                          PE_start, PE_stride, PE_size,
+                                          pWrk, pSync, op, datatype);
+            break;
+        case RABENSEIFNER:
+            shmem_internal_op_to_all_rabenseifner(target, source, count, type_size,
+                                                  PE_start, PE_stride, PE_size,
+                                                  pWrk, pSync, op, datatype);
+            break;
         default:
-            RAISE_ERROR_MSG("Illegal reduction type (%d)\n",
-                            shmem_internal_reduce_type);
+            RAISE_ERROR_MSG("Illegal reduction type (%d)\n", type);
     }
 }
 
+static inline
+void
+shmem_internal_op_to_all_sw(void *target, const void *source, size_t count,
+                            size_t type_size, int PE_start, int PE_stride,
+                            int PE_size, void *pWrk, long *pSync,
+                            shm_internal_op_t op,
+                            shm_internal_datatype_t datatype)
+{
+    shmem_internal_op_to_all_run(shmem_internal_op_to_all_sw_select(count * type_size, PE_size),
+                                 target, source, count, type_size, PE_start,
+                                 PE_stride, PE_size, pWrk, pSync, op, datatype);
+}
+
+static inline
+void
+shmem_internal_op_to_all(void *target, const void *source, size_t count,
+                         size_t type_size, int PE_start, int PE_stride,
+                         int PE_size, void *pWrk, long *pSync,
+                         shm_internal_op_t op,
+                         shm_internal_datatype_t datatype)
+{
+    shmem_internal_assert(type_size > 0);
+
+    shmem_internal_op_to_all_run(shmem_internal_op_to_all_select(count, type_size, PE_start,
+                                                                 PE_stride, PE_size, op,
+                                                                 datatype),
+                                 target, source, count, type_size, PE_start,
+                                 PE_stride, PE_size, pWrk, pSync, op, datatype);
+}
+
 
 void shmem_internal_collect_linear(void *target, const void *source, size_t len,
                                    int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_collect_recdbl(void *target, const void *source, size_t len,
+                                   int PE_start, int PE_stride, int PE_size, long *pSync);
+
+/* Recursive doubling collect uses 2 + log2(PE_size) pSync slots, which fit
+ * in SHMEM_COLLECT_SYNC_SIZE for all but the largest PE sets */
+static inline
+int
+shmem_internal_collect_use_recdbl(int PE_size)
+{
+    int log2_proc = 0;
+
+    while (log2_proc < (int) sizeof(int) * 8 - 2 && (2 << log2_proc) <= PE_size)
+        log2_proc++;
+
+    return 2 + log2_proc <= SHMEM_COLLECT_SYNC_SIZE;
+}
 
 static inline
 void
@@ -248,13 +427,27 @@ shmem_internal_collect(void *target, const void *source, size_t len,
 {
     switch (shmem_internal_collect_type) {
     case AUTO:
-        shmem_internal_collect_linear(target, source, len, PE_start, PE_stride,
-                                      PE_size, pSync);
+        if (PE_size < shmem_internal_params.COLL_CROSSOVER ||
+            !shmem_internal_collect_use_recdbl(PE_size)) {
+            shmem_internal_collect_linear(target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        } else {
+            shmem_internal_collect_recdbl(target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        }
         break;
     case LINEAR:
         shmem_internal_collect_linear(target, source, len, PE_start, PE_stride,
                                       PE_size, pSync);
         break;
+    case RECDBL:
+        if (shmem_internal_collect_use_recdbl(PE_size))
+            shmem_internal_collect_recdbl(target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        else
+            shmem_internal_collect_linear(target, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        break;
     default:
         RAISE_ERROR_MSG("Illegal collect type (%d)\n",
                         shmem_internal_collect_type);
@@ -269,16 +462,30 @@ void shmem_internal_fcollect_ring(void *target, const void *source, size_t len,
 void shmem_internal_fcollect_recdbl(void *target, const void *source, size_t len,
                                     int PE_start, int PE_stride, int PE_size, long *pSync);
 
+/* Resolve the fcollect algorithm for an active set size */
 static inline
-void
-shmem_internal_fcollect(void *target, const void *source, size_t len,
-                   int PE_start, int PE_stride, int PE_size, long *pSync)
+coll_type_t
+shmem_internal_fcollect_select(int PE_size)
 {
     switch (shmem_internal_fcollect_type) {
     case AUTO:
-        shmem_internal_fcollect_ring(target, source, len, PE_start, PE_stride,
-                                     PE_size, pSync);
-        break;
+        return RING;
+    case RECDBL:
+        if (0 == (PE_size & (PE_size - 1)))
+            return RECDBL;
+        else
+            return RING;
+    default:
+        return shmem_internal_fcollect_type;
+    }
+}
+
+static inline
+void
+shmem_internal_fcollect_run(coll_type_t type, void *target, const void *source, size_t len,
+                            int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    switch (type) {
     case LINEAR:
         shmem_internal_fcollect_linear(target, source, len, PE_start, PE_stride,
                                        PE_size, pSync);
@@ -288,25 +495,231 @@ shmem_internal_fcollect(void *target, const void *source, size_t len,
                                      PE_size, pSync);
         break;
     case RECDBL:
-        if (0 == (PE_size & (PE_size - 1))) {
-            shmem_internal_fcollect_recdbl(target, source, len, PE_start, PE_stride,
+        shmem_internal_fcollect_recdbl(target, source, len, PE_start, PE_stride,
+                                       PE_size, pSync);
+        break;
+    default:
+        RAISE_ERROR_MSG("Illegal fcollect type (%d)\n", type);
+    }
+}
+
+static inline
+void
+shmem_internal_fcollect(void *target, const void *source, size_t len,
+                   int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    shmem_internal_fcollect_run(shmem_internal_fcollect_select(PE_size), target, source,
+                                len, PE_start, PE_stride, PE_size, pSync);
+}
+
+
+void shmem_internal_alltoall_linear(void *dest, const void *source, size_t len,
+                                    int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_pairwise(void *dest, const void *source, size_t len,
+                                      int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_bruck(void *dest, const void *source, size_t len,
+                                   int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoall_hier(void *dest, const void *source, size_t len,
+                                  int PE_start, int PE_stride, int PE_size, long *pSync);
+
+/* Bruck exchanges blocks through a symmetric scratch buffer reserved at
+ * initialization, which can't be shared by concurrent collectives.  Its two
+ * int pSync flags per step fit in SHMEM_ALLTOALL_SYNC_SIZE for PE sets of up
+ * to 2^16 PEs. */
+extern void *shmem_internal_alltoall_scratch;
+extern size_t shmem_internal_alltoall_scratch_len;
+
+static inline
+int
+shmem_internal_alltoall_use_bruck(size_t len, int PE_size)
+{
+    return shmem_internal_thread_level != SHMEM_THREAD_MULTIPLE &&
+           PE_size <= 1 << (SHMEM_ALLTOALL_SYNC_SIZE * sizeof(long) / sizeof(int) / 2) &&
+           len * ((PE_size + 1) / 2) <= shmem_internal_alltoall_scratch_len;
+}
+
+static inline
+void
+shmem_internal_alltoall(void *dest, const void *source, size_t len,
+                        int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    switch (shmem_internal_alltoall_type) {
+    case AUTO:
+        if (PE_size < shmem_internal_params.COLL_CROSSOVER) {
+            shmem_internal_alltoall_linear(dest, source, len, PE_start, PE_stride,
                                            PE_size, pSync);
+        } else if (len <= shmem_internal_params.ALLTOALL_BRUCK_CROSSOVER &&
+                   shmem_internal_coll_use_hier(PE_start, PE_stride, PE_size)) {
+            shmem_internal_alltoall_hier(dest, source, len, PE_start, PE_stride,
+                                         PE_size, pSync);
+        } else if (len <= shmem_internal_params.ALLTOALL_BRUCK_CROSSOVER &&
+                   shmem_internal_alltoall_use_bruck(len, PE_size)) {
+            shmem_internal_alltoall_bruck(dest, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
+        } else {
+            shmem_internal_alltoall_pairwise(dest, source, len, PE_start, PE_stride,
+                                             PE_size, pSync);
+        }
+        break;
+    case LINEAR:
+        shmem_internal_alltoall_linear(dest, source, len, PE_start, PE_stride,
+                                       PE_size, pSync);
+        break;
+    case PAIRWISE:
+        shmem_internal_alltoall_pairwise(dest, source, len, PE_start, PE_stride,
+                                         PE_size, pSync);
+        break;
+    case BRUCK:
+        if (shmem_internal_alltoall_use_bruck(len, PE_size)) {
+            shmem_internal_alltoall_bruck(dest, source, len, PE_start, PE_stride,
+                                          PE_size, pSync);
         } else {
-            shmem_internal_fcollect_ring(target, source, len, PE_start, PE_stride,
+            shmem_internal_alltoall_pairwise(dest, source, len, PE_start, PE_stride,
+                                             PE_size, pSync);
+        }
+        break;
+    case HIER:
+        if (shmem_internal_coll_use_hier(PE_start, PE_stride, PE_size)) {
+            shmem_internal_alltoall_hier(dest, source, len, PE_start, PE_stride,
                                          PE_size, pSync);
+        } else {
+            shmem_internal_alltoall_pairwise(dest, source, len, PE_start, PE_stride,
+                                             PE_size, pSync);
+        }
+        break;
+    default:
+        RAISE_ERROR_MSG("Illegal alltoall type (%d)\n",
+                        shmem_internal_alltoall_type);
+    }
+}
+
+
+void shmem_internal_alltoalls_linear(void *dest, const void *source, ptrdiff_t dst,
+                                     ptrdiff_t sst, size_t elem_size, size_t nelems,
+                                     int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_alltoalls_packed(void *dest, const void *source, ptrdiff_t dst,
+                                     ptrdiff_t sst, size_t elem_size, size_t nelems,
+                                     int PE_start, int PE_stride, int PE_size, long *pSync);
+
+/* The packed alltoalls receives in a symmetric staging buffer reserved at
+ * initialization, with the same restrictions as the Bruck scratch buffer */
+extern void *shmem_internal_alltoalls_staging;
+extern size_t shmem_internal_alltoalls_staging_len;
+
+static inline
+int
+shmem_internal_alltoalls_use_packed(size_t elem_size, int PE_size)
+{
+    long window = shmem_internal_params.ALLTOALL_WINDOW;
+
+    if (window < 1) window = 1;
+    if (window > PE_size - 1) window = PE_size > 1 ? PE_size - 1 : 1;
+
+    return shmem_internal_thread_level != SHMEM_THREAD_MULTIPLE &&
+           elem_size <= shmem_internal_alltoalls_staging_len / 2 / window;
+}
+
+static inline
+void
+shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
+                         ptrdiff_t sst, size_t elem_size, size_t nelems,
+                         int PE_start, int PE_stride, int PE_size, long *pSync)
+{
+    switch (shmem_internal_alltoalls_type) {
+    case AUTO:
+        /* Unit strides are a plain alltoall, when its pSync fits */
+        if (dst == 1 && sst == 1 &&
+            SHMEM_ALLTOALLS_SYNC_SIZE >= SHMEM_ALLTOALL_SYNC_SIZE) {
+            shmem_internal_alltoall(dest, source, nelems * elem_size, PE_start,
+                                    PE_stride, PE_size, pSync);
+        } else if (shmem_internal_alltoalls_use_packed(elem_size, PE_size)) {
+            shmem_internal_alltoalls_packed(dest, source, dst, sst, elem_size, nelems,
+                                            PE_start, PE_stride, PE_size, pSync);
+        } else {
+            shmem_internal_alltoalls_linear(dest, source, dst, sst, elem_size, nelems,
+                                            PE_start, PE_stride, PE_size, pSync);
+        }
+        break;
+    case LINEAR:
+        shmem_internal_alltoalls_linear(dest, source, dst, sst, elem_size, nelems,
+                                        PE_start, PE_stride, PE_size, pSync);
+        break;
+    case PACKED:
+        if (shmem_internal_alltoalls_use_packed(elem_size, PE_size)) {
+            shmem_internal_alltoalls_packed(dest, source, dst, sst, elem_size, nelems,
+                                            PE_start, PE_stride, PE_size, pSync);
+        } else {
+            shmem_internal_alltoalls_linear(dest, source, dst, sst, elem_size, nelems,
+                                            PE_start, PE_stride, PE_size, pSync);
         }
         break;
     default:
-        RAISE_ERROR_MSG("Illegal fcollect type (%d)\n",
-                        shmem_internal_fcollect_type);
+        RAISE_ERROR_MSG("Illegal alltoalls type (%d)\n",
+                        shmem_internal_alltoalls_type);
     }
 }
 
+/* A persistent collective resolves its algorithm and tree once, when it is
+ * initialized, and replays them with a reserved pSync on every start.  A
+ * non-blocking collective builds its tree when it is posted and is advanced
+ * by the progress engine, using the team's counters instead of a pSync. */
+struct shmem_internal_tree_t {
+    int  parent;
+    int  num_children;
+    int *children;
+};
+typedef struct shmem_internal_tree_t shmem_internal_tree_t;
+
+enum shmem_internal_coll_op_t {
+    COLL_REDUCE = 0,
+    COLL_BCAST,
+    COLL_FCOLLECT,
+    COLL_BARRIER
+};
+typedef enum shmem_internal_coll_op_t shmem_internal_coll_op_t;
+
+/* Non-blocking collectives are queued, then wait for their children to
+ * report up the tree and for their parent to release them */
+enum shmem_internal_coll_state_t {
+    COLL_STATE_QUEUED = 0,
+    COLL_STATE_UP,
+    COLL_STATE_DOWN,
+    COLL_STATE_DONE
+};
+typedef enum shmem_internal_coll_state_t shmem_internal_coll_state_t;
+
+struct shmem_internal_coll_req_t {
+    shmem_internal_coll_op_t  coll;
+    coll_type_t               type;
+    void                     *dest;
+    const void               *source;
+    size_t                    count;
+    size_t                    type_size;
+    int                       PE_root;
+    int                       PE_start, PE_stride, PE_size;
+    shm_internal_op_t         op;
+    shm_internal_datatype_t   datatype;
+    shmem_internal_tree_t     tree;
+    long                     *psync;
+    int                       psync_idx;
+    int                       started;
+
+    /* Non-blocking collectives only */
+    struct shmem_internal_team_t      *team;
+    shmem_internal_coll_state_t        state;
+    long                               seq;
+    long                               up_target, down_target;
+    void                              *buf;
+    struct shmem_internal_coll_req_t  *next;
+};
+typedef struct shmem_internal_coll_req_t shmem_internal_coll_req_t;
 
-void shmem_internal_alltoall(void *dest, const void *source, size_t len,
-                             int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_coll_req_plan(shmem_internal_coll_req_t *req);
+void shmem_internal_coll_req_start(shmem_internal_coll_req_t *req);
+void shmem_internal_coll_req_fini(shmem_internal_coll_req_t *req);
 
-void shmem_internal_alltoalls(void *dest, const void *source, ptrdiff_t dst,
-                              ptrdiff_t sst, size_t elem_size, size_t nelems,
-                              int PE_start, int PE_stride, int PE_size, long *pSync);
+void shmem_internal_coll_req_post(shmem_internal_coll_req_t *req);
+int  shmem_internal_coll_req_test(shmem_internal_coll_req_t *req);
+void shmem_internal_coll_req_wait(shmem_internal_coll_req_t *req);
+void shmem_internal_coll_nbc_drain(struct shmem_internal_team_t *team);
 #endif
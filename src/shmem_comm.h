@@ -64,8 +64,21 @@ void
 shmem_internal_put_signal_nbi(shmem_ctx_t ctx, void *target, const void *source, size_t len,
                               uint64_t *sig_addr, uint64_t signal, int sig_op, int pe)
 {
+    /* The signal must be updated through the same path as any other AMO on
+     * sig_addr.  When that is the shared memory path, the data is written
+     * through it as well, so that it is delivered ahead of the signal. */
+    int shr_signal = shmem_shr_transport_use_atomic(ctx, sig_addr, sizeof(uint64_t),
+                                                    pe, SHM_INTERNAL_UINT64);
+
     if (len == 0) {
-        if (sig_op == SHMEM_SIGNAL_ADD)
+        if (shr_signal) {
+            if (sig_op == SHMEM_SIGNAL_ADD)
+                shmem_shr_transport_atomic(ctx, sig_addr, &signal, sizeof(uint64_t),
+                                           pe, SHM_INTERNAL_SUM, SHM_INTERNAL_UINT64);
+            else
+                shmem_shr_transport_atomic_set(ctx, sig_addr, &signal, sizeof(uint64_t),
+                                               pe, SHM_INTERNAL_UINT64);
+        } else if (sig_op == SHMEM_SIGNAL_ADD)
             shmem_transport_atomic((shmem_transport_ctx_t *) ctx, sig_addr, &signal, sizeof(uint64_t),
                                    pe, SHM_INTERNAL_SUM, SHM_INTERNAL_UINT64);
         else
@@ -74,7 +87,7 @@ shmem_internal_put_signal_nbi(shmem_ctx_t ctx, void *target, const void *source,
         return;
     }
 
-    if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
+    if (shr_signal || shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
         shmem_shr_transport_put_signal(ctx, target, source, len, sig_addr, signal, sig_op, pe);
     } else {
         shmem_transport_put_signal_nbi((shmem_transport_ctx_t *) ctx, target, source, len, sig_addr, signal, sig_op, pe);
@@ -88,13 +101,39 @@ shmem_internal_put_nbi(shmem_ctx_t ctx, void *target, const void *source, size_t
     if (len == 0) return;
 
     if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
-        shmem_shr_transport_put(ctx, target, source, len, pe);
+        shmem_shr_transport_put_batch(ctx, target, source, len, pe);
     } else {
         shmem_transport_put_nbi((shmem_transport_ctx_t *)ctx, target, source, len, pe);
     }
 }
 
 
+/* Element put issued from a loop.  Puts to on-node peers may be coalesced and
+ * are completed by shmem_internal_put_flush, fence, or quiet.  The source
+ * buffer may be reused on return. */
+static inline
+void
+shmem_internal_put_scalar_batch(shmem_ctx_t ctx, void *target, const void *source,
+                                size_t len, int pe)
+{
+    shmem_internal_assert(len > 0);
+
+    if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
+        shmem_shr_transport_put_batch(ctx, target, source, len, pe);
+    } else {
+        shmem_transport_put_scalar((shmem_transport_ctx_t *)ctx, target, source, len, pe);
+    }
+}
+
+
+static inline
+void
+shmem_internal_put_flush(shmem_ctx_t ctx, int pe)
+{
+    shmem_shr_transport_flush(ctx, pe);
+}
+
+
 static inline
 void
 shmem_internal_put_ct_nb(shmemx_ct_t ct, void *target, const void *source, size_t len, int pe,
@@ -129,6 +168,68 @@ shmem_internal_get(shmem_ctx_t ctx, void *target, const void *source, size_t len
 }
 
 
+/* Request-based RMA.  On-node transfers complete before returning and
+ * produce no request. */
+static inline
+void
+shmem_internal_put_nbr(shmem_ctx_t ctx, void *target, const void *source, size_t len, int pe,
+                       shmem_transport_req_t **req)
+{
+    *req = NULL;
+    if (len == 0) return;
+
+    if (shmem_shr_transport_use_write(ctx, target, source, len, pe)) {
+        shmem_shr_transport_put(ctx, target, source, len, pe);
+    } else {
+        shmem_transport_put_nbr((shmem_transport_ctx_t *)ctx, target, source, len, pe, req);
+    }
+}
+
+
+static inline
+void
+shmem_internal_get_nbr(shmem_ctx_t ctx, void *target, const void *source, size_t len, int pe,
+                       shmem_transport_req_t **req)
+{
+    *req = NULL;
+    if (len == 0) return;
+
+    if (shmem_shr_transport_use_read(ctx, target, source, len, pe)) {
+        shmem_shr_transport_get(ctx, target, source, len, pe);
+    } else {
+        shmem_transport_get_nbr((shmem_transport_ctx_t *)ctx, target, source, len, pe, req);
+    }
+}
+
+
+static inline
+int
+shmem_internal_req_test(shmem_transport_req_t **req)
+{
+    if (*req == NULL) return 1;
+
+    if (shmem_transport_req_test(*req)) {
+        shmem_transport_req_free(*req);
+        *req = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+static inline
+void
+shmem_internal_req_wait(shmem_transport_req_t **req)
+{
+    if (*req == NULL) return;
+
+    shmem_transport_req_wait(*req);
+    shmem_transport_req_free(*req);
+    *req = NULL;
+}
+
+
 static inline
 void
 shmem_internal_get_ct(shmemx_ct_t ct, void *target, const void *source, size_t len, int pe)
@@ -0,0 +1,209 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define SHMEM_INTERNAL_INCLUDE
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_copy.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SHMEM_COPY_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+static void
+shmem_internal_copy_memcpy(void *dst, const void *src, size_t len)
+{
+    memcpy(dst, src, len);
+}
+
+/* Both crossovers start disabled, so copies issued before initialization
+ * use memcpy */
+size_t shmem_internal_copy_medium_min = SIZE_MAX;
+size_t shmem_internal_copy_large_min  = SIZE_MAX;
+shmem_internal_copy_fn_t shmem_internal_copy_medium = shmem_internal_copy_memcpy;
+shmem_internal_copy_fn_t shmem_internal_copy_large  = shmem_internal_copy_memcpy;
+
+/* Default non-temporal crossover when the last level cache size is unknown */
+#define SHMEM_COPY_NT_MIN_DEFAULT (4*1024*1024)
+
+
+#ifdef SHMEM_COPY_X86
+
+#define SHMEM_COPY_NT_ALIGN 64
+
+static void
+shmem_internal_copy_erms(void *dst, const void *src, size_t len)
+{
+    __asm__ __volatile__ ("rep movsb"
+                          : "+D" (dst), "+S" (src), "+c" (len)
+                          :
+                          : "memory");
+}
+
+
+/* Copy the unaligned head with memcpy so that the streaming stores are
+ * aligned on the destination, then copy whole 64 byte blocks.  The fence
+ * orders the streaming stores before any later store, e.g. a completion
+ * flag written by the caller. */
+#define SHMEM_COPY_NT_DEF(NAME, TARGET, BODY)                           \
+    static void __attribute__((target(TARGET)))                         \
+    shmem_internal_copy_nt_##NAME(void *dst, const void *src, size_t len) \
+    {                                                                   \
+        char *d = (char *) dst;                                         \
+        const char *s = (const char *) src;                             \
+        size_t head = (SHMEM_COPY_NT_ALIGN -                            \
+                       ((uintptr_t) d & (SHMEM_COPY_NT_ALIGN - 1))) &   \
+                      (SHMEM_COPY_NT_ALIGN - 1);                        \
+                                                                        \
+        if (head > len) head = len;                                     \
+        memcpy(d, s, head);                                             \
+        d += head; s += head; len -= head;                              \
+                                                                        \
+        for ( ; len >= SHMEM_COPY_NT_ALIGN ; len -= SHMEM_COPY_NT_ALIGN, \
+                d += SHMEM_COPY_NT_ALIGN, s += SHMEM_COPY_NT_ALIGN) {   \
+            BODY                                                        \
+        }                                                               \
+        _mm_sfence();                                                   \
+                                                                        \
+        memcpy(d, s, len);                                              \
+    }
+
+SHMEM_COPY_NT_DEF(sse2, "sse2",
+    __m128i v0 = _mm_loadu_si128((const __m128i *) s);
+    __m128i v1 = _mm_loadu_si128((const __m128i *) (s + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i *) (s + 32));
+    __m128i v3 = _mm_loadu_si128((const __m128i *) (s + 48));
+    _mm_stream_si128((__m128i *) d, v0);
+    _mm_stream_si128((__m128i *) (d + 16), v1);
+    _mm_stream_si128((__m128i *) (d + 32), v2);
+    _mm_stream_si128((__m128i *) (d + 48), v3);
+)
+
+SHMEM_COPY_NT_DEF(avx2, "avx2",
+    __m256i v0 = _mm256_loadu_si256((const __m256i *) s);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *) (s + 32));
+    _mm256_stream_si256((__m256i *) d, v0);
+    _mm256_stream_si256((__m256i *) (d + 32), v1);
+)
+
+SHMEM_COPY_NT_DEF(avx512, "avx512f",
+    __m512i v0 = _mm512_loadu_si512((const void *) s);
+    _mm512_stream_si512((void *) d, v0);
+)
+
+static int
+shmem_internal_copy_have_erms(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    /* CPUID.(EAX=07H, ECX=0):EBX.ERMS[bit 9] */
+    return (ebx >> 9) & 1;
+}
+
+#endif /* SHMEM_COPY_X86 */
+
+
+static size_t
+shmem_internal_copy_nt_default(void)
+{
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+    /* Stream copies that would displace more than half of the LLC */
+    if (llc > 0) return (size_t) llc / 2;
+#endif
+
+    return SHMEM_COPY_NT_MIN_DEFAULT;
+}
+
+
+void
+shmem_internal_copy_init(void)
+{
+    const char *engine = shmem_internal_params.COPY_ENGINE;
+    const char *large_name = "memcpy", *medium_name = "memcpy";
+
+    shmem_internal_copy_medium_min = SIZE_MAX;
+    shmem_internal_copy_large_min  = SIZE_MAX;
+
+    if (0 == strcasecmp(engine, "memcpy"))
+        goto out;
+
+#ifdef SHMEM_COPY_X86
+    __builtin_cpu_init();
+
+    if (0 != strcasecmp(engine, "auto") && 0 != strcasecmp(engine, "erms") &&
+        0 != strcasecmp(engine, "sse2") && 0 != strcasecmp(engine, "avx2") &&
+        0 != strcasecmp(engine, "avx512")) {
+        RAISE_WARN_MSG("Ignoring bad copy engine '%s'\n", engine);
+        engine = "auto";
+    }
+
+    if (shmem_internal_copy_have_erms()) {
+        shmem_internal_copy_medium     = shmem_internal_copy_erms;
+        shmem_internal_copy_medium_min = shmem_internal_params.COPY_ERMS_MIN;
+        medium_name = "erms";
+    }
+
+    if (0 == strcasecmp(engine, "erms"))
+        goto out;
+
+    if ((0 == strcasecmp(engine, "auto") || 0 == strcasecmp(engine, "avx512")) &&
+        __builtin_cpu_supports("avx512f")) {
+        shmem_internal_copy_large = shmem_internal_copy_nt_avx512;
+        large_name = "avx512";
+    } else if ((0 == strcasecmp(engine, "auto") || 0 == strcasecmp(engine, "avx512") ||
+                0 == strcasecmp(engine, "avx2")) && __builtin_cpu_supports("avx2")) {
+        shmem_internal_copy_large = shmem_internal_copy_nt_avx2;
+        large_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        shmem_internal_copy_large = shmem_internal_copy_nt_sse2;
+        large_name = "sse2";
+    }
+
+    if (0 != strcasecmp(engine, "auto") && 0 != strcasecmp(engine, large_name))
+        RAISE_WARN_MSG("Copy engine '%s' is not supported, using '%s'\n",
+                       engine, large_name);
+
+    if (shmem_internal_copy_large != shmem_internal_copy_memcpy) {
+        shmem_internal_copy_large_min = shmem_internal_params.COPY_NT_MIN_provided ?
+            shmem_internal_params.COPY_NT_MIN : shmem_internal_copy_nt_default();
+    }
+#else
+    if (0 != strcasecmp(engine, "auto"))
+        RAISE_WARN_MSG("Copy engine '%s' is not supported on this platform\n", engine);
+#endif
+
+out:
+    /* Non-temporal copies take precedence over ERMS */
+    if (shmem_internal_copy_medium_min > shmem_internal_copy_large_min)
+        shmem_internal_copy_medium_min = shmem_internal_copy_large_min;
+
+    DEBUG_MSG("Copy engine: medium=%s (min %zu), large=%s (min %zu)\n",
+              medium_name, shmem_internal_copy_medium_min,
+              large_name, shmem_internal_copy_large_min);
+}
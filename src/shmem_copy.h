@@ -0,0 +1,48 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#ifndef SHMEM_COPY_H
+#define SHMEM_COPY_H
+
+#include <stddef.h>
+#include <string.h>
+
+/* Copy engine used for shared memory transfers.  Small copies use memcpy,
+ * medium copies use "rep movsb" when the processor advertises enhanced rep
+ * movsb (ERMS), and large copies use non-temporal stores so that bulk data
+ * does not evict the caller's working set.  The methods and crossover sizes
+ * are selected from CPUID at startup by shmem_internal_copy_init(). */
+
+typedef void (*shmem_internal_copy_fn_t)(void *dst, const void *src, size_t len);
+
+extern size_t shmem_internal_copy_medium_min;
+extern size_t shmem_internal_copy_large_min;
+extern shmem_internal_copy_fn_t shmem_internal_copy_medium;
+extern shmem_internal_copy_fn_t shmem_internal_copy_large;
+
+void shmem_internal_copy_init(void);
+
+static inline void
+shmem_internal_copy(void *dst, const void *src, size_t len)
+{
+    if (len < shmem_internal_copy_medium_min)
+        memcpy(dst, src, len);
+    else if (len < shmem_internal_copy_large_min)
+        shmem_internal_copy_medium(dst, src, len);
+    else
+        shmem_internal_copy_large(dst, src, len);
+}
+
+#endif
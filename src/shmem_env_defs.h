@@ -50,6 +50,10 @@ SHMEM_INTERNAL_ENV_DEF(MAX_BOUNCE_BUFFERS, long, 128, SHMEM_INTERNAL_ENV_CAT_OTH
                        "Maximum number of bounce buffers per context")
 SHMEM_INTERNAL_ENV_DEF(TRAP_ON_ABORT, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Generate trap if the program aborts or calls shmem_global_exit")
+SHMEM_INTERNAL_ENV_DEF(WAIT_ADAPTIVE, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Spin with backoff for the learned completion time before blocking")
+SHMEM_INTERNAL_ENV_DEF(WAIT_SPIN_MAX, long, 50, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Maximum spin time (microseconds) of an adaptive wait")
 
 SHMEM_INTERNAL_ENV_DEF(COLL_CROSSOVER, long, 4, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
                        "Crossover between linear and tree collectives (num. PEs)")
@@ -58,28 +62,71 @@ SHMEM_INTERNAL_ENV_DEF(COLL_SIZE_CROSSOVER, size, 16384, SHMEM_INTERNAL_ENV_CAT_
 SHMEM_INTERNAL_ENV_DEF(COLL_RADIX, long, 4, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
                        "Radix for tree-based collectives")
 SHMEM_INTERNAL_ENV_DEF(BARRIER_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for barrier.  Options are auto, linear, tree, dissem")
+                       "Algorithm for barrier.  Options are auto, linear, tree, dissem, hier")
 SHMEM_INTERNAL_ENV_DEF(BCAST_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for broadcast.  Options are auto, linear, tree")
+                       "Algorithm for broadcast.  Options are auto, linear, tree, pipeline, scatter")
+SHMEM_INTERNAL_ENV_DEF(BCAST_SEGMENT_SIZE, size, 65536, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Segment size for the pipelined broadcast")
+SHMEM_INTERNAL_ENV_DEF(BCAST_SCATTER_CROSSOVER, size, 1024*1024, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Message size at or above which broadcast uses scatter/allgather")
 SHMEM_INTERNAL_ENV_DEF(REDUCE_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for reductions.  Options are auto, linear, tree, recdbl")
+                       "Algorithm for reductions.  Options are auto, linear, tree, recdbl, ring, hier, rabenseifner")
+SHMEM_INTERNAL_ENV_DEF(REDUCE_SMALL_SIZE, size, 64, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Largest reduction (in bytes) that exchanges its values through the pSync")
+SHMEM_INTERNAL_ENV_DEF(REDUCE_KERNEL, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Local reduction kernels.  Options are auto, scalar, sse4, avx2, avx512")
 SHMEM_INTERNAL_ENV_DEF(COLLECT_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
-                       "Algorithm for collect.  Options are auto, linear")
+                       "Algorithm for collect.  Options are auto, linear, recdbl")
 SHMEM_INTERNAL_ENV_DEF(FCOLLECT_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
                        "Algorithm for fcollect.  Options are auto, linear, ring, recdbl")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Algorithm for alltoall.  Options are auto, linear, pairwise, bruck, hier")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_BRUCK_CROSSOVER, size, 256, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Largest alltoall block size for which the Bruck and hier algorithms are auto-selected")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALL_WINDOW, long, 8, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Maximum number of outstanding puts in pairwise alltoall and peers per round in packed alltoalls")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALLS_ALGORITHM, string, "auto", SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Algorithm for alltoalls.  Options are auto, linear, packed")
+SHMEM_INTERNAL_ENV_DEF(ALLTOALLS_STAGING_SIZE, size, 1024*1024, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
+                       "Size of the symmetric staging buffer used by packed alltoalls")
 SHMEM_INTERNAL_ENV_DEF(BARRIERS_FLUSH, bool, false, SHMEM_INTERNAL_ENV_CAT_COLLECTIVES,
                         "Flush stdout and stderr on barrier")
 
 SHMEM_INTERNAL_ENV_DEF(TEAMS_MAX, long, DEFAULT_TEAMS_MAX, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Maximum number of teams per PE")
+SHMEM_INTERNAL_ENV_DEF(TEAM_PSYNC_DEPTH, long, 4, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Number of pSync slots in each team's collective pSync ring")
 SHMEM_INTERNAL_ENV_DEF(TEAM_SHARED_ONLY_SELF, bool, false, SHMEM_INTERNAL_ENV_CAT_OTHER,
                        "Include only the self PE in SHMEM_TEAM_SHARED")
+SHMEM_INTERNAL_ENV_DEF(COLL_REQS_MAX, long, 16, SHMEM_INTERNAL_ENV_CAT_OTHER,
+                       "Maximum number of persistent collective requests per PE")
+
+SHMEM_INTERNAL_ENV_DEF(COPY_ENGINE, string, "auto", SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Copy engine for local and on-node transfers.  Options are auto, memcpy, erms, sse2, avx2, avx512")
+SHMEM_INTERNAL_ENV_DEF(COPY_ERMS_MIN, size, 4096, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Size at or above which local copies use rep movsb")
+SHMEM_INTERNAL_ENV_DEF(COPY_NT_MIN, size, 4*1024*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Size at or above which local copies use non-temporal stores (default: half of the LLC)")
 
 #ifdef USE_CMA
 SHMEM_INTERNAL_ENV_DEF(CMA_PUT_MAX, size, 8*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
                        "Size below which to use CMA for puts")
 SHMEM_INTERNAL_ENV_DEF(CMA_GET_MAX, size, 16*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
                        "Size below which to use CMA for gets")
+SHMEM_INTERNAL_ENV_DEF(CMA_LARGE_MIN, size, 256*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Size at or above which CMA puts and gets are copied in parallel chunks (0 disables)")
+SHMEM_INTERNAL_ENV_DEF(CMA_LARGE_CHUNK, size, 256*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Chunk size for large CMA transfers")
+SHMEM_INTERNAL_ENV_DEF(CMA_LARGE_THREADS, long, 0, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Number of helper threads for large CMA transfers (limited to free cores)")
+SHMEM_INTERNAL_ENV_DEF(CMA_BATCH_PUT_MAX, size, 256, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Size at or below which CMA puts are batched (0 disables batching)")
+SHMEM_INTERNAL_ENV_DEF(CMA_BATCH_BYTES, size, 16*1024, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Bytes queued per peer before a CMA put batch is flushed")
+SHMEM_INTERNAL_ENV_DEF(CMA_BATCH_COUNT, long, 64, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Puts queued per peer before a CMA put batch is flushed (max. IOV_MAX)")
+SHMEM_INTERNAL_ENV_DEF(CMA_ATOMICS, bool, true, SHMEM_INTERNAL_ENV_CAT_INTRANODE,
+                       "Use shared memory atomics on the symmetric heap when all PEs share a node")
 #endif /* USE_CMA */
 
 #ifdef USE_OFI
@@ -92,7 +139,9 @@ SHMEM_INTERNAL_ENV_DEF(OFI_USE_PROVIDER, string, "auto", SHMEM_INTERNAL_ENV_CAT_
 SHMEM_INTERNAL_ENV_DEF(OFI_FABRIC, string, "auto", SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
                        "Fabric that should be used by the OFI transport")
 SHMEM_INTERNAL_ENV_DEF(OFI_DOMAIN, string, "auto", SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
-                       "Fabric domain that should be used by the OFI transport")
+                       "Fabric domain, or comma-separated list of rail domains, that should be used by the OFI transport")
+SHMEM_INTERNAL_ENV_DEF(OFI_STRIPE_MIN, size, 65536, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
+                       "Smallest put or get striped across all rails")
 SHMEM_INTERNAL_ENV_DEF(OFI_TX_POLL_LIMIT, long, DEFAULT_POLL_LIMIT, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
                        "Put completion poll limit")
 SHMEM_INTERNAL_ENV_DEF(OFI_RX_POLL_LIMIT, long, DEFAULT_POLL_LIMIT, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
@@ -107,6 +156,12 @@ SHMEM_INTERNAL_ENV_DEF(OFI_STX_ALLOCATOR, string, "round-robin", SHMEM_INTERNAL_
                        "Algorithm for allocating STX resources to contexts")
 SHMEM_INTERNAL_ENV_DEF(OFI_STX_DISABLE_PRIVATE, bool, false, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
                        "Disallow private contexts from having exclusive STX access")
+SHMEM_INTERNAL_ENV_DEF(OFI_CTX_POOL_SIZE, long, 8, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
+                       "Number of destroyed shareable contexts kept per team for reuse")
+SHMEM_INTERNAL_ENV_DEF(OFI_MR_CACHE, bool, false, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
+                       "Register and cache local buffers of large transfers")
+SHMEM_INTERNAL_ENV_DEF(OFI_MR_CACHE_SIZE, long, 256, SHMEM_INTERNAL_ENV_CAT_TRANSPORT,
+                       "Maximum number of cached local buffer registrations")
 #endif
 
 #ifdef USE_UCX
@@ -589,11 +589,32 @@ void shmem_internal_bit_to_string(char *str, size_t str_size,
     }
 }
 
+/* An active set with this stride describes a team with an arbitrary, sorted
+ * list of PEs rather than a <start, stride, size> triplet.  The start of such
+ * an active set is the team's index in the team pool. */
+#define SHMEM_INTERNAL_STRIDE_LIST 0
+
+int shmem_internal_team_list_pe(int team_idx, int rank);
+int shmem_internal_team_list_rank(int team_idx, int global_pe);
+
+/* Return the global PE of index `rank` within the given active set. */
+static inline
+int shmem_internal_active_set_pe(int rank, int PE_start, int PE_stride)
+{
+    if (PE_stride == SHMEM_INTERNAL_STRIDE_LIST)
+        return shmem_internal_team_list_pe(PE_start, rank);
+
+    return PE_start + rank * PE_stride;
+}
+
 /* Return -1 if `global_pe` is not in the given active set.
  * If `global_pe` is in the active set, return the PE index within this set. */
 static inline
 int shmem_internal_pe_in_active_set(int global_pe, int PE_start, int PE_stride, int PE_size)
 {
+    if (PE_stride == SHMEM_INTERNAL_STRIDE_LIST)
+        return shmem_internal_team_list_rank(PE_start, global_pe);
+
     int n = (global_pe - PE_start) / PE_stride;
     if (global_pe < PE_start || (global_pe - PE_start) % PE_stride || n >= PE_size)
         return -1;
@@ -0,0 +1,156 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <strings.h>
+
+#define SHMEM_INTERNAL_INCLUDE
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_internal_op.h"
+
+/* The scalar kernels are used until shmem_internal_op_init() runs */
+size_t shmem_internal_op_kernel_align = 1;
+
+#define SHMEM_OP_KERNEL_TABLE(type_name, c_type, op_name, calc)             \
+    shmem_internal_op_kernel_t shmem_op_##type_name##_##op_name##_kernel[2] = \
+        { shmem_op_##type_name##_##op_name##_func,                          \
+          shmem_op_##type_name##_##op_name##_func };
+
+SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_KERNEL_TABLE)
+
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SHMEM_OP_X86 1
+
+/* The vectorized kernels are the scalar loops compiled for each instruction
+ * set, with restrict qualified buffers (and in the aligned variant, aligned
+ * buffers) so that the compiler vectorizes them without runtime checks. */
+#ifndef __clang__
+#pragma GCC optimize ("tree-vectorize")
+#endif
+
+/* The vectorized complex product uses the textbook formula, so unlike the C99
+ * Annex G product it does not recover infinities from NaN results */
+#undef shmem_internal_cprod_op
+#define shmem_internal_cprod_op(a, b)                                       \
+    ({                                                                      \
+        __typeof__(a) r_;                                                   \
+        __real__ r_ = __real__ (a) * __real__ (b) - __imag__ (a) * __imag__ (b); \
+        __imag__ r_ = __real__ (a) * __imag__ (b) + __imag__ (a) * __real__ (b); \
+        r_;                                                                 \
+    })
+
+#define SHMEM_OP_KERNEL_DEF(isa, target_isa, align, type_name, c_type, op_name, calc) \
+    static void __attribute__((target(target_isa)))                         \
+    shmem_op_##type_name##_##op_name##_##isa(const void *in_, void *out_, size_t count) \
+    {                                                                       \
+        const c_type *restrict in = (const c_type *) in_;                   \
+        c_type *restrict out = (c_type *) out_;                             \
+        size_t i;                                                           \
+        for (i = 0; i < count; ++i)                                         \
+            out[i] = calc(out[i], in[i]);                                   \
+    }                                                                       \
+    static void __attribute__((target(target_isa)))                         \
+    shmem_op_##type_name##_##op_name##_##isa##_aligned(const void *in_, void *out_, \
+                                                        size_t count)       \
+    {                                                                       \
+        const c_type *restrict in = (const c_type *) __builtin_assume_aligned(in_, align); \
+        c_type *restrict out = (c_type *) __builtin_assume_aligned(out_, align); \
+        size_t i;                                                           \
+        for (i = 0; i < count; ++i)                                         \
+            out[i] = calc(out[i], in[i]);                                   \
+    }
+
+#define SHMEM_OP_KERNEL_SET(isa, type_name, op_name)                        \
+    do {                                                                    \
+        shmem_op_##type_name##_##op_name##_kernel[0] =                      \
+            shmem_op_##type_name##_##op_name##_##isa;                       \
+        shmem_op_##type_name##_##op_name##_kernel[1] =                      \
+            shmem_op_##type_name##_##op_name##_##isa##_aligned;             \
+    } while (0);
+
+#define SHMEM_OP_SSE4_DEF(type_name, c_type, op_name, calc)                 \
+    SHMEM_OP_KERNEL_DEF(sse4, "sse4.2", 16, type_name, c_type, op_name, calc)
+#define SHMEM_OP_AVX2_DEF(type_name, c_type, op_name, calc)                 \
+    SHMEM_OP_KERNEL_DEF(avx2, "avx2", 32, type_name, c_type, op_name, calc)
+#define SHMEM_OP_AVX512_DEF(type_name, c_type, op_name, calc)               \
+    SHMEM_OP_KERNEL_DEF(avx512, "avx512f,avx512bw,avx512dq,avx512vl", 64,  \
+                        type_name, c_type, op_name, calc)
+
+#define SHMEM_OP_SSE4_SET(type_name, c_type, op_name, calc)                 \
+    SHMEM_OP_KERNEL_SET(sse4, type_name, op_name)
+#define SHMEM_OP_AVX2_SET(type_name, c_type, op_name, calc)                 \
+    SHMEM_OP_KERNEL_SET(avx2, type_name, op_name)
+#define SHMEM_OP_AVX512_SET(type_name, c_type, op_name, calc)               \
+    SHMEM_OP_KERNEL_SET(avx512, type_name, op_name)
+
+SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_SSE4_DEF)
+SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_AVX2_DEF)
+SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_AVX512_DEF)
+
+#endif /* SHMEM_OP_X86 */
+
+
+void
+shmem_internal_op_init(void)
+{
+    const char *kernel = shmem_internal_params.REDUCE_KERNEL;
+    const char *name = "scalar";
+
+    if (0 == strcasecmp(kernel, "scalar"))
+        goto out;
+
+#ifdef SHMEM_OP_X86
+    __builtin_cpu_init();
+
+    if (0 != strcasecmp(kernel, "auto") && 0 != strcasecmp(kernel, "sse4") &&
+        0 != strcasecmp(kernel, "avx2") && 0 != strcasecmp(kernel, "avx512")) {
+        RAISE_WARN_MSG("Ignoring bad reduction kernel '%s'\n", kernel);
+        kernel = "auto";
+    }
+
+    if ((0 == strcasecmp(kernel, "auto") || 0 == strcasecmp(kernel, "avx512")) &&
+        __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+        SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_AVX512_SET)
+        shmem_internal_op_kernel_align = 64;
+        name = "avx512";
+    } else if ((0 == strcasecmp(kernel, "auto") || 0 == strcasecmp(kernel, "avx512") ||
+                0 == strcasecmp(kernel, "avx2")) && __builtin_cpu_supports("avx2")) {
+        SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_AVX2_SET)
+        shmem_internal_op_kernel_align = 32;
+        name = "avx2";
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        SHMEM_INTERNAL_OP_KERNELS(SHMEM_OP_SSE4_SET)
+        shmem_internal_op_kernel_align = 16;
+        name = "sse4";
+    }
+
+    if (0 != strcasecmp(kernel, "auto") && 0 != strcasecmp(kernel, name))
+        RAISE_WARN_MSG("Reduction kernel '%s' is not supported, using '%s'\n",
+                       kernel, name);
+#else
+    if (0 != strcasecmp(kernel, "auto"))
+        RAISE_WARN_MSG("Reduction kernel '%s' is not supported on this platform\n",
+                       kernel);
+#endif
+
+out:
+    DEBUG_MSG("Reduction kernels: %s (aligned to %zu bytes)\n", name,
+              shmem_internal_op_kernel_align);
+}
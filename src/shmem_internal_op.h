@@ -17,20 +17,39 @@
  *
  */
 
+#ifndef SHMEM_INTERNAL_OP_H
+#define SHMEM_INTERNAL_OP_H
+
+#include <stddef.h>
 #include <stdint.h>
 #include "transport.h"
 
+/* Local reduction kernels combine count elements of in into inout; the two
+ * buffers must not overlap.  Each operation has a pair of kernels, for
+ * buffers with arbitrary alignment and for buffers that are both aligned to
+ * shmem_internal_op_kernel_align bytes.  They start out as the scalar loops
+ * below and are replaced with vectorized kernels by shmem_internal_op_init(),
+ * according to SHMEM_REDUCE_KERNEL and the features of the processor. */
+typedef void (*shmem_internal_op_kernel_t)(const void *in, void *inout, size_t count);
+
+extern size_t shmem_internal_op_kernel_align;
+
+void shmem_internal_op_init(void);
+
 #define FUNC_OP_CREATE(type_name, c_type, op_name, calc)                    \
-    static inline void shmem_op_##type_name##_##op_name##_func(c_type *in,  \
-                                                    c_type *out, int count) \
+    static inline void shmem_op_##type_name##_##op_name##_func(const void *in_, \
+                                                    void *out_, size_t count) \
     {                                                                       \
-        int i;                                                              \
+        const c_type *in = (const c_type *) in_;                            \
+        c_type *out = (c_type *) out_;                                      \
+        size_t i;                                                           \
         for (i = 0; i < count; ++i) {                                       \
             *(out) = calc(*(out), *(in));                                   \
             ++out;                                                          \
             ++in;                                                           \
         }                                                                   \
-    }
+    }                                                                       \
+    extern shmem_internal_op_kernel_t shmem_op_##type_name##_##op_name##_kernel[2];
 
 
 /* Open SHMEM reduction operations */
@@ -41,194 +60,209 @@
 #define shmem_internal_and_op(a, b) ((a) & (b))
 #define shmem_internal_or_op(a, b) ((a) | (b))
 #define shmem_internal_xor_op(a, b) ((a) ^ (b))
+#define shmem_internal_cprod_op(a, b) ((a) * (b))
 
-FUNC_OP_CREATE(int32, int32_t, max, shmem_internal_max_op)
-FUNC_OP_CREATE(int32, int32_t, min, shmem_internal_min_op)
-FUNC_OP_CREATE(int32, int32_t, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(int32, int32_t, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(int32, int32_t, and, shmem_internal_and_op)
-FUNC_OP_CREATE(int32, int32_t, or, shmem_internal_or_op)
-FUNC_OP_CREATE(int32, int32_t, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(int64, int64_t, max, shmem_internal_max_op)
-FUNC_OP_CREATE(int64, int64_t, min, shmem_internal_min_op)
-FUNC_OP_CREATE(int64, int64_t, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(int64, int64_t, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(int64, int64_t, and, shmem_internal_and_op)
-FUNC_OP_CREATE(int64, int64_t, or, shmem_internal_or_op)
-FUNC_OP_CREATE(int64, int64_t, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(uchar, unsigned char, and, shmem_internal_and_op)
-FUNC_OP_CREATE(uchar, unsigned char, or, shmem_internal_or_op)
-FUNC_OP_CREATE(uchar, unsigned char, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(short, short, max, shmem_internal_max_op)
-FUNC_OP_CREATE(short, short, min, shmem_internal_min_op)
-FUNC_OP_CREATE(short, short, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(short, short, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(short, short, and, shmem_internal_and_op)
-FUNC_OP_CREATE(short, short, or, shmem_internal_or_op)
-FUNC_OP_CREATE(short, short, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(ushort, unsigned short, max, shmem_internal_max_op)
-FUNC_OP_CREATE(ushort, unsigned short, min, shmem_internal_min_op)
-FUNC_OP_CREATE(ushort, unsigned short, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(ushort, unsigned short, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(ushort, unsigned short, and, shmem_internal_and_op)
-FUNC_OP_CREATE(ushort, unsigned short, or, shmem_internal_or_op)
-FUNC_OP_CREATE(ushort, unsigned short, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(int, int, max, shmem_internal_max_op)
-FUNC_OP_CREATE(int, int, min, shmem_internal_min_op)
-FUNC_OP_CREATE(int, int, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(int, int, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(int, int, and, shmem_internal_and_op)
-FUNC_OP_CREATE(int, int, or, shmem_internal_or_op)
-FUNC_OP_CREATE(int, int, xor, shmem_internal_xor_op)
+/* All reduction kernels, as M(type_name, c_type, op_name, calc) */
+#define SHMEM_INTERNAL_OP_KERNELS(M)                                   \
+    M(int32, int32_t, max, shmem_internal_max_op)                      \
+    M(int32, int32_t, min, shmem_internal_min_op)                      \
+    M(int32, int32_t, sum, shmem_internal_sum_op)                      \
+    M(int32, int32_t, prod, shmem_internal_prod_op)                    \
+    M(int32, int32_t, and, shmem_internal_and_op)                      \
+    M(int32, int32_t, or, shmem_internal_or_op)                        \
+    M(int32, int32_t, xor, shmem_internal_xor_op)                      \
+                                                                       \
+    M(int64, int64_t, max, shmem_internal_max_op)                      \
+    M(int64, int64_t, min, shmem_internal_min_op)                      \
+    M(int64, int64_t, sum, shmem_internal_sum_op)                      \
+    M(int64, int64_t, prod, shmem_internal_prod_op)                    \
+    M(int64, int64_t, and, shmem_internal_and_op)                      \
+    M(int64, int64_t, or, shmem_internal_or_op)                        \
+    M(int64, int64_t, xor, shmem_internal_xor_op)                      \
+                                                                       \
+    M(uchar, unsigned char, and, shmem_internal_and_op)                \
+    M(uchar, unsigned char, or, shmem_internal_or_op)                  \
+    M(uchar, unsigned char, xor, shmem_internal_xor_op)                \
+                                                                       \
+    M(short, short, max, shmem_internal_max_op)                        \
+    M(short, short, min, shmem_internal_min_op)                        \
+    M(short, short, sum, shmem_internal_sum_op)                        \
+    M(short, short, prod, shmem_internal_prod_op)                      \
+    M(short, short, and, shmem_internal_and_op)                        \
+    M(short, short, or, shmem_internal_or_op)                          \
+    M(short, short, xor, shmem_internal_xor_op)                        \
+                                                                       \
+    M(ushort, unsigned short, max, shmem_internal_max_op)              \
+    M(ushort, unsigned short, min, shmem_internal_min_op)              \
+    M(ushort, unsigned short, sum, shmem_internal_sum_op)              \
+    M(ushort, unsigned short, prod, shmem_internal_prod_op)            \
+    M(ushort, unsigned short, and, shmem_internal_and_op)              \
+    M(ushort, unsigned short, or, shmem_internal_or_op)                \
+    M(ushort, unsigned short, xor, shmem_internal_xor_op)              \
+                                                                       \
+    M(int, int, max, shmem_internal_max_op)                            \
+    M(int, int, min, shmem_internal_min_op)                            \
+    M(int, int, sum, shmem_internal_sum_op)                            \
+    M(int, int, prod, shmem_internal_prod_op)                          \
+    M(int, int, and, shmem_internal_and_op)                            \
+    M(int, int, or, shmem_internal_or_op)                              \
+    M(int, int, xor, shmem_internal_xor_op)                            \
+                                                                       \
+    M(uint, unsigned int, max, shmem_internal_max_op)                  \
+    M(uint, unsigned int, min, shmem_internal_min_op)                  \
+    M(uint, unsigned int, sum, shmem_internal_sum_op)                  \
+    M(uint, unsigned int, prod, shmem_internal_prod_op)                \
+    M(uint, unsigned int, and, shmem_internal_and_op)                  \
+    M(uint, unsigned int, or, shmem_internal_or_op)                    \
+    M(uint, unsigned int, xor, shmem_internal_xor_op)                  \
+                                                                       \
+    M(long, long, max, shmem_internal_max_op)                          \
+    M(long, long, min, shmem_internal_min_op)                          \
+    M(long, long, sum, shmem_internal_sum_op)                          \
+    M(long, long, prod, shmem_internal_prod_op)                        \
+    M(long, long, and, shmem_internal_and_op)                          \
+    M(long, long, or, shmem_internal_or_op)                            \
+    M(long, long, xor, shmem_internal_xor_op)                          \
+                                                                       \
+    M(ulong, unsigned long, max, shmem_internal_max_op)                \
+    M(ulong, unsigned long, min, shmem_internal_min_op)                \
+    M(ulong, unsigned long, sum, shmem_internal_sum_op)                \
+    M(ulong, unsigned long, prod, shmem_internal_prod_op)              \
+    M(ulong, unsigned long, and, shmem_internal_and_op)                \
+    M(ulong, unsigned long, or, shmem_internal_or_op)                  \
+    M(ulong, unsigned long, xor, shmem_internal_xor_op)                \
+                                                                       \
+    M(longlong, long long, max, shmem_internal_max_op)                 \
+    M(longlong, long long, min, shmem_internal_min_op)                 \
+    M(longlong, long long, sum, shmem_internal_sum_op)                 \
+    M(longlong, long long, prod, shmem_internal_prod_op)               \
+    M(longlong, long long, and, shmem_internal_and_op)                 \
+    M(longlong, long long, or, shmem_internal_or_op)                   \
+    M(longlong, long long, xor, shmem_internal_xor_op)                 \
+                                                                       \
+    M(ulonglong, unsigned long long, max, shmem_internal_max_op)       \
+    M(ulonglong, unsigned long long, min, shmem_internal_min_op)       \
+    M(ulonglong, unsigned long long, sum, shmem_internal_sum_op)       \
+    M(ulonglong, unsigned long long, prod, shmem_internal_prod_op)     \
+    M(ulonglong, unsigned long long, and, shmem_internal_and_op)       \
+    M(ulonglong, unsigned long long, or, shmem_internal_or_op)         \
+    M(ulonglong, unsigned long long, xor, shmem_internal_xor_op)       \
+                                                                       \
+    M(float, float, max, shmem_internal_max_op)                        \
+    M(float, float, min, shmem_internal_min_op)                        \
+    M(float, float, sum, shmem_internal_sum_op)                        \
+    M(float, float, prod, shmem_internal_prod_op)                      \
+                                                                       \
+    M(double, double, max, shmem_internal_max_op)                      \
+    M(double, double, min, shmem_internal_min_op)                      \
+    M(double, double, sum, shmem_internal_sum_op)                      \
+    M(double, double, prod, shmem_internal_prod_op)                    \
+                                                                       \
+    M(long_double, long double, max, shmem_internal_max_op)            \
+    M(long_double, long double, min, shmem_internal_min_op)            \
+    M(long_double, long double, sum, shmem_internal_sum_op)            \
+    M(long_double, long double, prod, shmem_internal_prod_op)          \
+                                                                       \
+    M(double_complex, double _Complex, sum, shmem_internal_sum_op)     \
+    M(double_complex, double _Complex, prod, shmem_internal_cprod_op)  \
+                                                                       \
+    M(float_complex, float _Complex, sum, shmem_internal_sum_op)       \
+    M(float_complex, float _Complex, prod, shmem_internal_cprod_op)
 
-FUNC_OP_CREATE(uint, unsigned int, max, shmem_internal_max_op)
-FUNC_OP_CREATE(uint, unsigned int, min, shmem_internal_min_op)
-FUNC_OP_CREATE(uint, unsigned int, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(uint, unsigned int, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(uint, unsigned int, and, shmem_internal_and_op)
-FUNC_OP_CREATE(uint, unsigned int, or, shmem_internal_or_op)
-FUNC_OP_CREATE(uint, unsigned int, xor, shmem_internal_xor_op)
+SHMEM_INTERNAL_OP_KERNELS(FUNC_OP_CREATE)
 
-FUNC_OP_CREATE(long, long, max, shmem_internal_max_op)
-FUNC_OP_CREATE(long, long, min, shmem_internal_min_op)
-FUNC_OP_CREATE(long, long, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(long, long, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(long, long, and, shmem_internal_and_op)
-FUNC_OP_CREATE(long, long, or, shmem_internal_or_op)
-FUNC_OP_CREATE(long, long, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(ulong, unsigned long, max, shmem_internal_max_op)
-FUNC_OP_CREATE(ulong, unsigned long, min, shmem_internal_min_op)
-FUNC_OP_CREATE(ulong, unsigned long, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(ulong, unsigned long, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(ulong, unsigned long, and, shmem_internal_and_op)
-FUNC_OP_CREATE(ulong, unsigned long, or, shmem_internal_or_op)
-FUNC_OP_CREATE(ulong, unsigned long, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(longlong, long long, max, shmem_internal_max_op)
-FUNC_OP_CREATE(longlong, long long, min, shmem_internal_min_op)
-FUNC_OP_CREATE(longlong, long long, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(longlong, long long, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(longlong, long long, and, shmem_internal_and_op)
-FUNC_OP_CREATE(longlong, long long, or, shmem_internal_or_op)
-FUNC_OP_CREATE(longlong, long long, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(ulonglong, unsigned long long, max, shmem_internal_max_op)
-FUNC_OP_CREATE(ulonglong, unsigned long long, min, shmem_internal_min_op)
-FUNC_OP_CREATE(ulonglong, unsigned long long, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(ulonglong, unsigned long long, prod, shmem_internal_prod_op)
-FUNC_OP_CREATE(ulonglong, unsigned long long, and, shmem_internal_and_op)
-FUNC_OP_CREATE(ulonglong, unsigned long long, or, shmem_internal_or_op)
-FUNC_OP_CREATE(ulonglong, unsigned long long, xor, shmem_internal_xor_op)
-
-FUNC_OP_CREATE(float, float, max, shmem_internal_max_op)
-FUNC_OP_CREATE(float, float, min, shmem_internal_min_op)
-FUNC_OP_CREATE(float, float, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(float, float, prod, shmem_internal_prod_op)
-
-FUNC_OP_CREATE(double, double, max, shmem_internal_max_op)
-FUNC_OP_CREATE(double, double, min, shmem_internal_min_op)
-FUNC_OP_CREATE(double, double, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(double, double, prod, shmem_internal_prod_op)
-
-FUNC_OP_CREATE(long_double, long double, max, shmem_internal_max_op)
-FUNC_OP_CREATE(long_double, long double, min, shmem_internal_min_op)
-FUNC_OP_CREATE(long_double, long double, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(long_double, long double, prod, shmem_internal_prod_op)
-
-FUNC_OP_CREATE(double_complex, double _Complex, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(double_complex, double _Complex, prod, shmem_internal_prod_op)
-
-FUNC_OP_CREATE(float_complex, float _Complex, sum, shmem_internal_sum_op)
-FUNC_OP_CREATE(float_complex, float _Complex, prod, shmem_internal_prod_op)
+static inline void
+shmem_internal_op_kernel(shmem_internal_op_kernel_t *kernel, const void *in,
+                         void *inout, size_t count)
+{
+    if (0 == (((uintptr_t) in | (uintptr_t) inout) & (shmem_internal_op_kernel_align - 1)))
+        kernel[1](in, inout, count);
+    else
+        kernel[0](in, inout, count);
+}
 
-#define REDUCE_LOCAL_DTYPE_CASE_FP(dtype, dtype_name, c_type)                             \
-    case dtype:                                                                           \
-        switch(op) {                                                                      \
-            case SHM_INTERNAL_MIN:                                                        \
-                shmem_op_##dtype_name##_min_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_MAX:                                                        \
-                shmem_op_##dtype_name##_max_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_SUM:                                                        \
-                shmem_op_##dtype_name##_sum_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_PROD:                                                       \
-                shmem_op_##dtype_name##_prod_func((c_type *) in, (c_type *) inout, count);\
-                break;                                                                    \
-            default:                                                                      \
-                RAISE_ERROR_STR("unsupported reduction on " # c_type);                    \
-        }                                                                                 \
+#define REDUCE_LOCAL_DTYPE_CASE_FP(dtype, dtype_name, c_type)                                      \
+    case dtype:                                                                                    \
+        switch(op) {                                                                               \
+            case SHM_INTERNAL_MIN:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_min_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_MAX:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_max_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_SUM:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_sum_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_PROD:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_prod_kernel, in, inout, count);   \
+                break;                                                                             \
+            default:                                                                               \
+                RAISE_ERROR_STR("unsupported reduction on " # c_type);                             \
+        }                                                                                          \
         break;
 
-#define REDUCE_LOCAL_DTYPE_CASE_CPLX(dtype, dtype_name, c_type)                           \
-    case dtype:                                                                           \
-        switch(op) {                                                                      \
-            case SHM_INTERNAL_SUM:                                                        \
-                shmem_op_##dtype_name##_sum_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_PROD:                                                       \
-                shmem_op_##dtype_name##_prod_func((c_type *) in, (c_type *) inout, count);\
-                break;                                                                    \
-            default:                                                                      \
-                RAISE_ERROR_STR("unsupported reduction on " # c_type);                    \
-        }                                                                                 \
+#define REDUCE_LOCAL_DTYPE_CASE_CPLX(dtype, dtype_name, c_type)                                    \
+    case dtype:                                                                                    \
+        switch(op) {                                                                               \
+            case SHM_INTERNAL_SUM:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_sum_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_PROD:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_prod_kernel, in, inout, count);   \
+                break;                                                                             \
+            default:                                                                               \
+                RAISE_ERROR_STR("unsupported reduction on " # c_type);                             \
+        }                                                                                          \
         break;
 
-#define REDUCE_LOCAL_DTYPE_CASE_INT(dtype, dtype_name, c_type)                            \
-    case dtype:                                                                           \
-        switch(op) {                                                                      \
-            case SHM_INTERNAL_MIN:                                                        \
-                shmem_op_##dtype_name##_min_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_MAX:                                                        \
-                shmem_op_##dtype_name##_max_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_SUM:                                                        \
-                shmem_op_##dtype_name##_sum_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_PROD:                                                       \
-                shmem_op_##dtype_name##_prod_func((c_type *) in, (c_type *) inout, count);\
-                break;                                                                    \
-            case SHM_INTERNAL_BAND:                                                       \
-                shmem_op_##dtype_name##_and_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_BOR:                                                        \
-                shmem_op_##dtype_name##_or_func((c_type *) in, (c_type *) inout, count);  \
-                break;                                                                    \
-            case SHM_INTERNAL_BXOR:                                                       \
-                shmem_op_##dtype_name##_xor_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            default:                                                                      \
-                RAISE_ERROR_STR("unsupported reduction on " # c_type);                    \
-        }                                                                                 \
+#define REDUCE_LOCAL_DTYPE_CASE_INT(dtype, dtype_name, c_type)                                     \
+    case dtype:                                                                                    \
+        switch(op) {                                                                               \
+            case SHM_INTERNAL_MIN:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_min_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_MAX:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_max_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_SUM:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_sum_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_PROD:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_prod_kernel, in, inout, count);   \
+                break;                                                                             \
+            case SHM_INTERNAL_BAND:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_and_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_BOR:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_or_kernel, in, inout, count);     \
+                break;                                                                             \
+            case SHM_INTERNAL_BXOR:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_xor_kernel, in, inout, count);    \
+                break;                                                                             \
+            default:                                                                               \
+                RAISE_ERROR_STR("unsupported reduction on " # c_type);                             \
+        }                                                                                          \
         break;
 
-#define REDUCE_LOCAL_DTYPE_CASE_AND_OR_XOR(dtype, dtype_name, c_type)                     \
-    case dtype:                                                                           \
-        switch(op) {                                                                      \
-            case SHM_INTERNAL_BAND:                                                       \
-                shmem_op_##dtype_name##_and_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            case SHM_INTERNAL_BOR:                                                        \
-                shmem_op_##dtype_name##_or_func((c_type *) in, (c_type *) inout, count);  \
-                break;                                                                    \
-            case SHM_INTERNAL_BXOR:                                                       \
-                shmem_op_##dtype_name##_xor_func((c_type *) in, (c_type *) inout, count); \
-                break;                                                                    \
-            default:                                                                      \
-                RAISE_ERROR_STR("unsupported reduction on " # c_type);                    \
-        }                                                                                 \
+#define REDUCE_LOCAL_DTYPE_CASE_AND_OR_XOR(dtype, dtype_name, c_type)                              \
+    case dtype:                                                                                    \
+        switch(op) {                                                                               \
+            case SHM_INTERNAL_BAND:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_and_kernel, in, inout, count);    \
+                break;                                                                             \
+            case SHM_INTERNAL_BOR:                                                                 \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_or_kernel, in, inout, count);     \
+                break;                                                                             \
+            case SHM_INTERNAL_BXOR:                                                                \
+                shmem_internal_op_kernel(shmem_op_##dtype_name##_xor_kernel, in, inout, count);    \
+                break;                                                                             \
+            default:                                                                               \
+                RAISE_ERROR_STR("unsupported reduction on " # c_type);                             \
+        }                                                                                          \
         break;
 
 static inline void shmem_internal_reduce_local(shm_internal_op_t op,
-                                shm_internal_datatype_t datatype, int count,
+                                shm_internal_datatype_t datatype, size_t count,
                                 void *in, void *inout) {
     switch(datatype) {
         REDUCE_LOCAL_DTYPE_CASE_INT(SHM_INTERNAL_INT32, int32, int32_t);
@@ -256,3 +290,6 @@ static inline void shmem_internal_reduce_local(shm_internal_op_t op,
 #undef REDUCE_LOCAL_DTYPE_CASE_FP
 #undef REDUCE_LOCAL_DTYPE_CASE_CPLX
 #undef REDUCE_LOCAL_DTYPE_CASE_INT
+#undef REDUCE_LOCAL_DTYPE_CASE_AND_OR_XOR
+
+#endif
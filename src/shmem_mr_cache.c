@@ -0,0 +1,419 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define SHMEM_INTERNAL_INCLUDE
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_atomic.h"
+#include "shmem_mr_cache.h"
+
+/* The hooks apply to the whole process, including memory that SHMEM never
+ * registers, so they are only built on request (--enable-mr-cache-hooks) */
+#if defined(ENABLE_MR_CACHE_HOOKS) && defined(__linux__) && defined(__GLIBC__) && defined(SYS_munmap)
+#define SHMEM_MR_CACHE_HAVE_HOOKS 1
+#endif
+
+/* Registrations are kept in an AVL tree ordered by (start, end).  Each node
+ * also records the largest end address in its subtree, which bounds the
+ * containment and overlap searches. */
+typedef struct shmem_internal_mr_cache_entry_t {
+    uintptr_t start;
+    uintptr_t end;
+    uintptr_t max_end;
+    int height;
+    struct shmem_internal_mr_cache_entry_t *left;
+    struct shmem_internal_mr_cache_entry_t *right;
+    void *handle;
+    void *desc;
+} shmem_internal_mr_cache_entry_t;
+
+static shmem_internal_mr_cache_entry_t *mr_cache_root = NULL;
+static long mr_cache_nentries = 0;
+static long mr_cache_max_entries = 0;
+static uintptr_t mr_cache_page_mask = 0;
+static shmem_internal_mr_cache_reg_fn_t mr_cache_reg_fn = NULL;
+static shmem_internal_mr_cache_dereg_fn_t mr_cache_dereg_fn = NULL;
+
+/* munmap may be called by any thread, independent of the thread level */
+static shmem_spinlock_t mr_cache_lock;
+static int mr_cache_active = 0;
+
+/* Set while the cache calls into the transport, whose own munmap calls must
+ * not reenter the cache */
+static __thread int mr_cache_busy = 0;
+
+static uint64_t mr_cache_nhits = 0;
+static uint64_t mr_cache_nmisses = 0;
+static uint64_t mr_cache_ninval = 0;
+
+
+static inline int
+mr_cache_height(shmem_internal_mr_cache_entry_t *n)
+{
+    return n ? n->height : 0;
+}
+
+
+static inline void
+mr_cache_update(shmem_internal_mr_cache_entry_t *n)
+{
+    int hl = mr_cache_height(n->left), hr = mr_cache_height(n->right);
+
+    n->height  = 1 + (hl > hr ? hl : hr);
+    n->max_end = n->end;
+    if (n->left && n->left->max_end > n->max_end)
+        n->max_end = n->left->max_end;
+    if (n->right && n->right->max_end > n->max_end)
+        n->max_end = n->right->max_end;
+}
+
+
+static shmem_internal_mr_cache_entry_t *
+mr_cache_rotate_right(shmem_internal_mr_cache_entry_t *y)
+{
+    shmem_internal_mr_cache_entry_t *x = y->left;
+
+    y->left  = x->right;
+    x->right = y;
+    mr_cache_update(y);
+    mr_cache_update(x);
+
+    return x;
+}
+
+
+static shmem_internal_mr_cache_entry_t *
+mr_cache_rotate_left(shmem_internal_mr_cache_entry_t *x)
+{
+    shmem_internal_mr_cache_entry_t *y = x->right;
+
+    x->right = y->left;
+    y->left  = x;
+    mr_cache_update(x);
+    mr_cache_update(y);
+
+    return y;
+}
+
+
+static shmem_internal_mr_cache_entry_t *
+mr_cache_balance(shmem_internal_mr_cache_entry_t *n)
+{
+    int bf;
+
+    mr_cache_update(n);
+    bf = mr_cache_height(n->left) - mr_cache_height(n->right);
+
+    if (bf > 1) {
+        if (mr_cache_height(n->left->left) < mr_cache_height(n->left->right))
+            n->left = mr_cache_rotate_left(n->left);
+        return mr_cache_rotate_right(n);
+    } else if (bf < -1) {
+        if (mr_cache_height(n->right->right) < mr_cache_height(n->right->left))
+            n->right = mr_cache_rotate_right(n->right);
+        return mr_cache_rotate_left(n);
+    }
+
+    return n;
+}
+
+
+static inline int
+mr_cache_cmp(shmem_internal_mr_cache_entry_t *a, shmem_internal_mr_cache_entry_t *b)
+{
+    if (a->start != b->start)
+        return a->start < b->start ? -1 : 1;
+    if (a->end != b->end)
+        return a->end < b->end ? -1 : 1;
+    return 0;
+}
+
+
+static shmem_internal_mr_cache_entry_t *
+mr_cache_insert(shmem_internal_mr_cache_entry_t *root, shmem_internal_mr_cache_entry_t *e)
+{
+    if (root == NULL)
+        return e;
+
+    if (mr_cache_cmp(e, root) < 0)
+        root->left = mr_cache_insert(root->left, e);
+    else
+        root->right = mr_cache_insert(root->right, e);
+
+    return mr_cache_balance(root);
+}
+
+
+static shmem_internal_mr_cache_entry_t *
+mr_cache_remove_min(shmem_internal_mr_cache_entry_t *n, shmem_internal_mr_cache_entry_t **min)
+{
+    if (n->left == NULL) {
+        *min = n;
+        return n->right;
+    }
+
+    n->left = mr_cache_remove_min(n->left, min);
+    return mr_cache_balance(n);
+}
+
+
+/* Keys are unique: a range is only inserted after no entry contained it */
+static shmem_internal_mr_cache_entry_t *
+mr_cache_remove(shmem_internal_mr_cache_entry_t *root, shmem_internal_mr_cache_entry_t *e)
+{
+    int c;
+
+    if (root == NULL)
+        return NULL;
+
+    c = mr_cache_cmp(e, root);
+    if (c < 0) {
+        root->left = mr_cache_remove(root->left, e);
+    } else if (c > 0) {
+        root->right = mr_cache_remove(root->right, e);
+    } else {
+        shmem_internal_mr_cache_entry_t *l = root->left, *r = root->right, *min;
+
+        if (r == NULL)
+            return l;
+
+        r = mr_cache_remove_min(r, &min);
+        min->left  = l;
+        min->right = r;
+        return mr_cache_balance(min);
+    }
+
+    return mr_cache_balance(root);
+}
+
+
+/* Find an entry with start <= a and end >= b */
+static shmem_internal_mr_cache_entry_t *
+mr_cache_find_containing(shmem_internal_mr_cache_entry_t *n, uintptr_t a, uintptr_t b)
+{
+    shmem_internal_mr_cache_entry_t *r;
+
+    if (n == NULL || n->max_end < b)
+        return NULL;
+
+    r = mr_cache_find_containing(n->left, a, b);
+    if (r) return r;
+
+    /* Entries to the right start no earlier than this one */
+    if (n->start > a)
+        return NULL;
+    if (n->end >= b)
+        return n;
+
+    return mr_cache_find_containing(n->right, a, b);
+}
+
+
+/* Find an entry overlapping [a, b) */
+static shmem_internal_mr_cache_entry_t *
+mr_cache_find_overlap(shmem_internal_mr_cache_entry_t *n, uintptr_t a, uintptr_t b)
+{
+    shmem_internal_mr_cache_entry_t *r;
+
+    if (n == NULL || n->max_end <= a)
+        return NULL;
+
+    r = mr_cache_find_overlap(n->left, a, b);
+    if (r) return r;
+
+    if (n->start >= b)
+        return NULL;
+    if (n->end > a)
+        return n;
+
+    return mr_cache_find_overlap(n->right, a, b);
+}
+
+
+static void
+mr_cache_release(shmem_internal_mr_cache_entry_t *e)
+{
+    mr_cache_busy++;
+    mr_cache_dereg_fn(e->handle);
+    mr_cache_busy--;
+    free(e);
+}
+
+
+static void
+mr_cache_release_all(shmem_internal_mr_cache_entry_t *n)
+{
+    if (n == NULL)
+        return;
+
+    mr_cache_release_all(n->left);
+    mr_cache_release_all(n->right);
+    mr_cache_release(n);
+}
+
+
+int
+shmem_internal_mr_cache_init(long max_entries,
+                             shmem_internal_mr_cache_reg_fn_t reg_fn,
+                             shmem_internal_mr_cache_dereg_fn_t dereg_fn)
+{
+#ifdef SHMEM_MR_CACHE_HAVE_HOOKS
+    if (max_entries <= 0)
+        return 1;
+
+    mr_cache_max_entries = max_entries;
+    mr_cache_page_mask   = (uintptr_t) sysconf(_SC_PAGESIZE) - 1;
+    mr_cache_reg_fn      = reg_fn;
+    mr_cache_dereg_fn    = dereg_fn;
+    shmem_spinlock_init(&mr_cache_lock);
+
+    /* Keep freed memory mapped, so that free() cannot release a registered
+     * buffer to the OS without passing through the munmap hook */
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    __atomic_store_n(&mr_cache_active, 1, __ATOMIC_RELEASE);
+
+    return 0;
+#else
+    RAISE_WARN_STR("Registration cache requires --enable-mr-cache-hooks, Linux and glibc, disabling");
+    return 1;
+#endif
+}
+
+
+void
+shmem_internal_mr_cache_fini(void)
+{
+    if (!__atomic_load_n(&mr_cache_active, __ATOMIC_ACQUIRE))
+        return;
+
+    shmem_spinlock_lock(&mr_cache_lock);
+    __atomic_store_n(&mr_cache_active, 0, __ATOMIC_RELEASE);
+
+    DEBUG_MSG("hits = %"PRIu64", misses = %"PRIu64", invalidated = %"PRIu64", entries = %ld\n",
+              mr_cache_nhits, mr_cache_nmisses, mr_cache_ninval, mr_cache_nentries);
+
+    mr_cache_release_all(mr_cache_root);
+    mr_cache_root = NULL;
+    mr_cache_nentries = 0;
+    shmem_spinlock_unlock(&mr_cache_lock);
+}
+
+
+void *
+shmem_internal_mr_cache_lookup(const void *addr, size_t len)
+{
+    uintptr_t start = (uintptr_t) addr & ~mr_cache_page_mask;
+    uintptr_t end   = ((uintptr_t) addr + len + mr_cache_page_mask) & ~mr_cache_page_mask;
+    shmem_internal_mr_cache_entry_t *e;
+    void *desc = NULL;
+    int ret;
+
+    if (len == 0)
+        return NULL;
+
+    shmem_spinlock_lock(&mr_cache_lock);
+
+    e = mr_cache_find_containing(mr_cache_root, start, end);
+    if (e) {
+        mr_cache_nhits++;
+        desc = e->desc;
+        goto out;
+    }
+
+    mr_cache_nmisses++;
+    if (mr_cache_nentries >= mr_cache_max_entries)
+        goto out;
+
+    e = malloc(sizeof(shmem_internal_mr_cache_entry_t));
+    if (e == NULL)
+        goto out;
+
+    mr_cache_busy++;
+    ret = mr_cache_reg_fn((void *) start, end - start, &e->handle, &e->desc);
+    mr_cache_busy--;
+
+    if (ret) {
+        DEBUG_MSG("Registration of [%p, %p) failed (%d)\n",
+                  (void *) start, (void *) end, ret);
+        free(e);
+        goto out;
+    }
+
+    e->start   = start;
+    e->end     = end;
+    e->max_end = end;
+    e->height  = 1;
+    e->left    = NULL;
+    e->right   = NULL;
+
+    mr_cache_root = mr_cache_insert(mr_cache_root, e);
+    mr_cache_nentries++;
+    desc = e->desc;
+
+out:
+    shmem_spinlock_unlock(&mr_cache_lock);
+    return desc;
+}
+
+
+void
+shmem_internal_mr_cache_invalidate(const void *addr, size_t len)
+{
+    uintptr_t start = (uintptr_t) addr & ~mr_cache_page_mask;
+    uintptr_t end   = ((uintptr_t) addr + len + mr_cache_page_mask) & ~mr_cache_page_mask;
+    shmem_internal_mr_cache_entry_t *e;
+
+    if (!__atomic_load_n(&mr_cache_active, __ATOMIC_ACQUIRE) || mr_cache_busy || len == 0)
+        return;
+
+    shmem_spinlock_lock(&mr_cache_lock);
+
+    while ((e = mr_cache_find_overlap(mr_cache_root, start, end)) != NULL) {
+        mr_cache_root = mr_cache_remove(mr_cache_root, e);
+        mr_cache_nentries--;
+        mr_cache_ninval++;
+        mr_cache_release(e);
+    }
+
+    shmem_spinlock_unlock(&mr_cache_lock);
+}
+
+
+#ifdef SHMEM_MR_CACHE_HAVE_HOOKS
+/* Drop the registrations of memory that is unmapped, before a later mapping
+ * can reuse the addresses.  Exported, so that it also interposes the munmap
+ * calls of the application and of other libraries. */
+int SHMEM_FUNCTION_ATTRIBUTES
+munmap(void *addr, size_t len)
+{
+    shmem_internal_mr_cache_invalidate(addr, len);
+    return (int) syscall(SYS_munmap, addr, len);
+}
+#endif
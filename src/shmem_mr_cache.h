@@ -0,0 +1,48 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#ifndef SHMEM_MR_CACHE_H
+#define SHMEM_MR_CACHE_H
+
+#include <stddef.h>
+
+/* Cache of transport registrations for local (non-symmetric) buffers.
+ * Registrations cover whole pages and are kept in an interval tree, so that
+ * a buffer reuses any cached registration that contains it.  Entries stay
+ * cached until the memory is unmapped; the library interposes munmap and
+ * stops the C library from returning freed memory to the OS while a cache
+ * is active.  Once the cache is full, further buffers are not registered
+ * and the lookup returns NULL. */
+
+/* Register [addr, addr + len).  Returns zero on success and sets the
+ * transport handle used for deregistration and the descriptor returned by
+ * lookups. */
+typedef int (*shmem_internal_mr_cache_reg_fn_t)(void *addr, size_t len,
+                                                void **handle, void **desc);
+typedef void (*shmem_internal_mr_cache_dereg_fn_t)(void *handle);
+
+int shmem_internal_mr_cache_init(long max_entries,
+                                 shmem_internal_mr_cache_reg_fn_t reg_fn,
+                                 shmem_internal_mr_cache_dereg_fn_t dereg_fn);
+void shmem_internal_mr_cache_fini(void);
+
+/* Return the descriptor of a registration covering the buffer, registering
+ * it on a miss.  Returns NULL when the buffer could not be registered. */
+void *shmem_internal_mr_cache_lookup(const void *addr, size_t len);
+
+/* Drop all registrations overlapping [addr, addr + len) */
+void shmem_internal_mr_cache_invalidate(const void *addr, size_t len);
+
+#endif
@@ -19,6 +19,7 @@
 #include "shmem_atomic.h"
 #include "shmem_comm.h"
 #include "transport.h"
+#include "shmem_wait.h"
 
 static inline void
 shmem_internal_quiet(shmem_ctx_t ctx)
@@ -28,6 +29,8 @@ shmem_internal_quiet(shmem_ctx_t ctx)
     if (ctx == SHMEM_CTX_INVALID)
         return;
 
+    shmem_shr_transport_quiet(ctx);
+
     ret = shmem_transport_quiet((shmem_transport_ctx_t *)ctx);
     if (0 != ret) { RAISE_ERROR(ret); }
 
@@ -49,6 +52,8 @@ shmem_internal_fence(shmem_ctx_t ctx)
     if (ctx == SHMEM_CTX_INVALID)
         return;
 
+    shmem_shr_transport_fence(ctx);
+
     ret = shmem_transport_fence((shmem_transport_ctx_t *)ctx);
     if (0 != ret) { RAISE_ERROR(ret); }
 
@@ -85,7 +90,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
         }                                                \
     } while(0)
 
-#ifdef USE_SHR_ATOMICS
+#if defined(USE_SHR_ATOMICS) || defined(USE_CMA)
 #define SYNC_LOAD(var) __atomic_load_n(var, __ATOMIC_ACQUIRE)
 #else
 #define SYNC_LOAD(var) *(var)
@@ -96,6 +101,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
 #define SHMEM_WAIT_POLL(var, value)                      \
     do {                                                 \
         while (SYNC_LOAD(var) == value) {                \
+            shmem_shr_transport_probe();                 \
             shmem_transport_probe();                     \
             SPINLOCK_BODY(); }                           \
     } while(0)
@@ -106,6 +112,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
                                                          \
         COMP(cond, SYNC_LOAD(var), value, cmpret);       \
         while (!cmpret) {                                \
+            shmem_shr_transport_probe();                 \
             shmem_transport_probe();                     \
             SPINLOCK_BODY();                             \
             COMP(cond, SYNC_LOAD(var), value, cmpret);   \
@@ -116,6 +123,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
     do {                                                                \
         uint64_t target_cntr;                                           \
                                                                         \
+        shmem_shr_transport_probe();                                    \
         while (SYNC_LOAD(var) == value) {                               \
             target_cntr = shmem_transport_received_cntr_get();          \
             COMPILER_FENCE();                                           \
@@ -129,6 +137,7 @@ shmem_internal_fence(shmem_ctx_t ctx)
         uint64_t target_cntr;                                           \
         int cmpret;                                                     \
                                                                         \
+        shmem_shr_transport_probe();                                    \
         COMP(cond, SYNC_LOAD(var), value, cmpret);                      \
         while (!cmpret) {                                               \
             target_cntr = shmem_transport_received_cntr_get();          \
@@ -140,15 +149,39 @@ shmem_internal_fence(shmem_ctx_t ctx)
         }                                                               \
     } while(0)
 
+/* Spin with backoff for the learned completion time, then block */
+#define SHMEM_WAIT_UNTIL_ADAPTIVE(var, cond, value)                     \
+    do {                                                                \
+        shmem_internal_wait_t wait =                                    \
+            SHMEM_INTERNAL_WAIT_INITIALIZER(&shmem_internal_wait_stats); \
+        int blocked;                                                    \
+        int cmpret;                                                     \
+                                                                        \
+        COMP(cond, SYNC_LOAD(var), value, cmpret);                      \
+        while (!cmpret && shmem_internal_wait_spin(&wait)) {            \
+            shmem_shr_transport_probe();                                \
+            shmem_transport_probe();                                    \
+            COMP(cond, SYNC_LOAD(var), value, cmpret);                  \
+        }                                                               \
+        blocked = !cmpret;                                              \
+        if (blocked)                                                    \
+            SHMEM_WAIT_UNTIL_BLOCK(var, cond, value);                   \
+        shmem_internal_wait_end(&wait, blocked);                        \
+    } while(0)
+
 #if defined(ENABLE_HARD_POLLING)
 #define SHMEM_INTERNAL_WAIT_UNTIL(var, cond, value)                     \
     SHMEM_WAIT_UNTIL_POLL(var, cond, value)
 #else
+/* Adaptive waiting only replaces the blocking path; polling waits are
+ * unchanged */
 #define SHMEM_INTERNAL_WAIT_UNTIL(var, cond, value)                     \
-    if (shmem_internal_thread_level == SHMEM_THREAD_SINGLE) {           \
-        SHMEM_WAIT_UNTIL_BLOCK(var, cond, value);                       \
-    } else {                                                            \
+    if (shmem_internal_thread_level != SHMEM_THREAD_SINGLE) {           \
         SHMEM_WAIT_UNTIL_POLL(var, cond, value);                        \
+    } else if (shmem_internal_wait_adaptive) {                          \
+        SHMEM_WAIT_UNTIL_ADAPTIVE(var, cond, value);                    \
+    } else {                                                            \
+        SHMEM_WAIT_UNTIL_BLOCK(var, cond, value);                       \
     }
 #endif
 
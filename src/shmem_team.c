@@ -23,7 +23,7 @@
 #define SHMEM_TEAMS_MIN          2
 
 #define N_PSYNC_BYTES             8
-#define PSYNC_CHUNK_SIZE          (N_PSYNCS_PER_TEAM * SHMEM_SYNC_SIZE)
+#define PSYNC_CHUNK_SIZE          (shmem_internal_params.TEAM_PSYNC_DEPTH * SHMEM_SYNC_SIZE)
 
 
 shmem_internal_team_t shmem_internal_team_world;
@@ -35,12 +35,18 @@ shmem_team_t SHMEM_TEAM_SHARED = (shmem_team_t) &shmem_internal_team_shared;
 shmem_internal_team_t **shmem_internal_team_pool;
 long *shmem_internal_psync_pool;
 long *shmem_internal_psync_barrier_pool;
+long *shmem_internal_nbc_psync_pool;
 static unsigned char *psync_pool_avail;
 static unsigned char *psync_pool_avail_reduced;
 
 static int *team_ret_val;
 static int *team_ret_val_reduced;
 
+/* pSyncs reserved by persistent collectives, one SHMEM_SYNC_SIZE slot each */
+static long *coll_req_psync_pool;
+static unsigned char *coll_req_psync_avail;
+static unsigned char *coll_req_psync_avail_reduced;
+
 /* Checks whether a PE has a consistent stride given (start, stride, size).
  * This function is useful within a loop across PE IDs, and sets 'start',
  * 'stride' and 'size' accordingly upon exiting the loop. It also assumes
@@ -78,9 +84,16 @@ int shmem_internal_team_init(void)
     shmem_internal_team_world.my_pe          = shmem_internal_my_pe;
     shmem_internal_team_world.config_mask    = 0;
     shmem_internal_team_world.contexts_len   = 0;
+    shmem_internal_team_world.ctx_pool_len   = 0;
+    shmem_internal_team_world.ctx_pool       = NULL;
+    shmem_internal_team_world.ctx_pool_head  = 0;
+    shmem_internal_team_world.nbc_posted     = 0;
+    shmem_internal_team_world.nbc_completed  = 0;
+    shmem_internal_team_world.nbc_up         = 0;
+    shmem_internal_team_world.nbc_down       = 0;
     memset(&shmem_internal_team_world.config, 0, sizeof(shmem_team_config_t));
-    for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-        shmem_internal_team_world.psync_avail[i] = 1;
+    shmem_internal_team_world.psync_seq = 0;
+    shmem_internal_team_world.psync_done = 0;
     SHMEM_TEAM_WORLD = (shmem_team_t) &shmem_internal_team_world;
 
     /* Initialize SHMEM_TEAM_SHARED */
@@ -88,9 +101,16 @@ int shmem_internal_team_init(void)
     shmem_internal_team_shared.my_pe         = shmem_internal_my_pe;
     shmem_internal_team_shared.config_mask   = 0;
     shmem_internal_team_shared.contexts_len  = 0;
+    shmem_internal_team_shared.ctx_pool_len  = 0;
+    shmem_internal_team_shared.ctx_pool      = NULL;
+    shmem_internal_team_shared.ctx_pool_head = 0;
+    shmem_internal_team_shared.nbc_posted    = 0;
+    shmem_internal_team_shared.nbc_completed = 0;
+    shmem_internal_team_shared.nbc_up        = 0;
+    shmem_internal_team_shared.nbc_down      = 0;
     memset(&shmem_internal_team_shared.config, 0, sizeof(shmem_team_config_t));
-    for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-        shmem_internal_team_shared.psync_avail[i] = 1;
+    shmem_internal_team_shared.psync_seq = 0;
+    shmem_internal_team_shared.psync_done = 0;
     SHMEM_TEAM_SHARED = (shmem_team_t) &shmem_internal_team_shared;
 
     if (shmem_internal_params.TEAM_SHARED_ONLY_SELF) {
@@ -132,6 +152,9 @@ int shmem_internal_team_init(void)
     if (shmem_internal_params.TEAMS_MAX < SHMEM_TEAMS_MIN)
         shmem_internal_params.TEAMS_MAX = SHMEM_TEAMS_MIN;
 
+    if (shmem_internal_params.TEAM_PSYNC_DEPTH < 1)
+        shmem_internal_params.TEAM_PSYNC_DEPTH = 1;
+
     shmem_internal_team_pool = malloc(shmem_internal_params.TEAMS_MAX *
                                       sizeof(shmem_internal_team_t*));
 
@@ -142,11 +165,11 @@ int shmem_internal_team_init(void)
     shmem_internal_team_pool[SHMEM_TEAM_SHARED_INDEX] = &shmem_internal_team_shared;
 
     /* Allocate pSync pool, each with the maximum possible size requirement */
-    /* Create two pSyncs per team for back-to-back collectives and one for barriers.
-     * Array organization:
+    /* Create a ring of TEAM_PSYNC_DEPTH pSyncs per team for back-to-back
+     * collectives and one pSync per team for barriers.  Array organization:
      *
      * [ (world) (shared) (team 1) (team 2) ...  (world) (shared) (team 1) (team 2) ... ]
-     *  <----------- groups 1 & 2-------------->|<------------- group 3 ---------------->
+     *  <------ groups 1 .. depth ------------->|<------------- last group --------------->
      *  <--- (bcast, collect, reduce, etc.) --->|<------ (barriers and syncs) ---------->
      * */
     long psync_len = shmem_internal_params.TEAMS_MAX * (PSYNC_CHUNK_SIZE + SHMEM_SYNC_SIZE);
@@ -157,10 +180,16 @@ int shmem_internal_team_init(void)
         shmem_internal_psync_pool[i] = SHMEM_SYNC_VALUE;
     }
 
-    /* Convenience pointer to the group-3 pSync array (for barriers and syncs): */
+    /* Convenience pointer to the last pSync group (for barriers and syncs): */
     shmem_internal_psync_barrier_pool = &shmem_internal_psync_pool[PSYNC_CHUNK_SIZE *
                                                          shmem_internal_params.TEAMS_MAX];
 
+    /* Non-blocking collectives count up and down messages on each team */
+    long nbc_psync_len = shmem_internal_params.TEAMS_MAX * N_NBC_PSYNCS;
+    shmem_internal_nbc_psync_pool = shmem_internal_shmalloc(sizeof(long) * nbc_psync_len);
+    if (NULL == shmem_internal_nbc_psync_pool) goto cleanup;
+    memset(shmem_internal_nbc_psync_pool, 0, sizeof(long) * nbc_psync_len);
+
     psync_pool_avail = shmem_internal_shmalloc(2 * N_PSYNC_BYTES);
     if (NULL == psync_pool_avail) goto cleanup;
     psync_pool_avail_reduced = &psync_pool_avail[N_PSYNC_BYTES];
@@ -180,6 +209,30 @@ int shmem_internal_team_init(void)
     if (NULL == team_ret_val) goto cleanup;
     team_ret_val_reduced = &team_ret_val[1];
 
+    if (shmem_internal_params.COLL_REQS_MAX > N_PSYNC_BYTES * CHAR_BIT) {
+        RETURN_ERROR_MSG("Requested %ld persistent collectives, but only %d are supported\n",
+                         shmem_internal_params.COLL_REQS_MAX, N_PSYNC_BYTES * CHAR_BIT);
+        goto cleanup;
+    }
+
+    coll_req_psync_avail = shmem_internal_shmalloc(2 * N_PSYNC_BYTES);
+    if (NULL == coll_req_psync_avail) goto cleanup;
+    coll_req_psync_avail_reduced = &coll_req_psync_avail[N_PSYNC_BYTES];
+    memset(coll_req_psync_avail, 0, 2 * N_PSYNC_BYTES);
+
+    if (shmem_internal_params.COLL_REQS_MAX > 0) {
+        long coll_req_psync_len = shmem_internal_params.COLL_REQS_MAX * SHMEM_SYNC_SIZE;
+
+        coll_req_psync_pool = shmem_internal_shmalloc(sizeof(long) * coll_req_psync_len);
+        if (NULL == coll_req_psync_pool) goto cleanup;
+
+        for (long i = 0; i < coll_req_psync_len; i++)
+            coll_req_psync_pool[i] = SHMEM_SYNC_VALUE;
+
+        for (size_t i = 0; i < (size_t) shmem_internal_params.COLL_REQS_MAX; i++)
+            shmem_internal_bit_set(coll_req_psync_avail, N_PSYNC_BYTES, i);
+    }
+
     return 0;
 
 cleanup:
@@ -191,6 +244,10 @@ cleanup:
         shmem_internal_free(shmem_internal_psync_pool);
         shmem_internal_psync_pool = NULL;
     }
+    if (shmem_internal_nbc_psync_pool) {
+        shmem_internal_free(shmem_internal_nbc_psync_pool);
+        shmem_internal_nbc_psync_pool = NULL;
+    }
     if (psync_pool_avail) {
         shmem_internal_free(psync_pool_avail);
         psync_pool_avail = NULL;
@@ -199,6 +256,14 @@ cleanup:
         shmem_internal_free(team_ret_val);
         team_ret_val = NULL;
     }
+    if (coll_req_psync_avail) {
+        shmem_internal_free(coll_req_psync_avail);
+        coll_req_psync_avail = NULL;
+    }
+    if (coll_req_psync_pool) {
+        shmem_internal_free(coll_req_psync_pool);
+        coll_req_psync_pool = NULL;
+    }
 
     return -1;
 }
@@ -213,8 +278,12 @@ void shmem_internal_team_fini(void)
 
     free(shmem_internal_team_pool);
     shmem_internal_free(shmem_internal_psync_pool);
+    shmem_internal_free(shmem_internal_nbc_psync_pool);
     shmem_internal_free(psync_pool_avail);
     shmem_internal_free(team_ret_val);
+    shmem_internal_free(coll_req_psync_avail);
+    if (coll_req_psync_pool)
+        shmem_internal_free(coll_req_psync_pool);
 
     return;
 }
@@ -227,12 +296,12 @@ int shmem_internal_team_translate_pe(shmem_internal_team_t *src_team, int src_pe
     if (src_team == SHMEM_TEAM_INVALID || dest_team == SHMEM_TEAM_INVALID)
         return -1;
 
-    if (src_pe > src_team->size)
+    if (src_pe < 0 || src_pe >= src_team->size)
         return -1;
 
-    src_pe_world = src_team->start + src_pe * src_team->stride;
+    src_pe_world = shmem_internal_team_pe(src_team, src_pe);
 
-    shmem_internal_assert(src_pe_world >= src_team->start && src_pe_world < shmem_internal_num_pes);
+    shmem_internal_assert(src_pe_world >= 0 && src_pe_world < shmem_internal_num_pes);
 
     dest_pe = shmem_internal_pe_in_active_set(src_pe_world, dest_team->start, dest_team->stride,
                                               dest_team->size);
@@ -240,36 +309,103 @@ int shmem_internal_team_translate_pe(shmem_internal_team_t *src_team, int src_pe
     return dest_pe;
 }
 
-int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE_start, int PE_stride,
-                                      int PE_size, const shmem_team_config_t *config, long config_mask,
-                                      shmem_internal_team_t **new_team)
+/* Allocate the local handle for a new team.  The caller assigns its pSync. */
+static shmem_internal_team_t *team_alloc(int my_pe, int start, int stride, int size,
+                                         const shmem_team_config_t *config, long config_mask)
 {
+    shmem_internal_team_t *team = calloc(1, sizeof(shmem_internal_team_t));
+
+    team->my_pe       = my_pe;
+    team->start       = start;
+    team->stride      = stride;
+    team->size        = size;
+    if (config) {
+        team->config      = *config;
+        team->config_mask = config_mask;
+    }
+    team->contexts_len = 0;
+    team->psync_idx = -1;
 
-    *new_team = SHMEM_TEAM_INVALID;
+    return team;
+}
 
-    if (parent_team == SHMEM_TEAM_INVALID) {
-        return 1;
+/* Attach a sorted list of global PEs to the team and build its reverse map.
+ * The team takes ownership of the list. */
+static void team_set_pe_list(shmem_internal_team_t *team, int *pe_list)
+{
+    team->pe_list = pe_list;
+    team->rank_map = NULL;
+    team->rank_entries = malloc(team->size * sizeof(shmem_internal_team_rank_t));
+    if (NULL == team->rank_entries) {
+        RAISE_ERROR_STR("Out of memory allocating team PE map");
     }
 
-    int global_PE_start = shmem_internal_team_pe(parent_team, PE_start);
-    int global_PE_end   = global_PE_start + PE_stride * (PE_size -1);
-
-    if (PE_start < 0 || PE_start >= parent_team->size ||
-        PE_size <= 0 || PE_size > parent_team->size   ||
-        PE_stride < 1) {
-        RAISE_WARN_MSG("Invalid <start, stride, size>: child <%d, %d, %d>, parent <%d, %d, %d>\n",
-                       PE_start, PE_stride, PE_size,
-                       parent_team->start, parent_team->stride, parent_team->size);
-        return -1;
+    for (int i = 0; i < team->size; i++) {
+        team->rank_entries[i].pe = pe_list[i];
+        team->rank_entries[i].rank = i;
+        HASH_ADD_INT(team->rank_map, pe, &team->rank_entries[i]);
     }
+}
 
-    if (global_PE_start >= shmem_internal_num_pes ||
-        global_PE_end >= shmem_internal_num_pes) {
-        RAISE_WARN_MSG("Starting PE (%d) or ending PE (%d) is invalid\n",
-                       global_PE_start, global_PE_end);
-        return -1;
+int shmem_internal_team_list_pe(int team_idx, int rank)
+{
+    shmem_internal_team_t *team = shmem_internal_team_pool[team_idx];
+
+    shmem_internal_assert(team != NULL && rank >= 0 && rank < team->size);
+
+    return team->pe_list[rank];
+}
+
+int shmem_internal_team_list_rank(int team_idx, int global_pe)
+{
+    shmem_internal_team_t *team = shmem_internal_team_pool[team_idx];
+    shmem_internal_team_rank_t *entry;
+
+    shmem_internal_assert(team != NULL);
+
+    HASH_FIND_INT(team->rank_map, &global_pe, entry);
+
+    return entry ? entry->rank : -1;
+}
+
+/* Return a new list of the global PEs with the given strided ranks in a list team */
+static int *team_sublist(shmem_internal_team_t *team, int start, int stride, int size)
+{
+    int *pes = malloc(size * sizeof(int));
+    if (NULL == pes) {
+        RAISE_ERROR_STR("Out of memory allocating team PE list");
     }
 
+    for (int i = 0; i < size; i++)
+        pes[i] = team->pe_list[start + i * stride];
+
+    return pes;
+}
+
+static int compare_pes(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/* Reserve pSync slot idx for the new team on this PE */
+static void team_set_psync(shmem_internal_team_t *team, int idx)
+{
+    shmem_internal_bit_clear(psync_pool_avail, N_PSYNC_BYTES, idx);
+
+    team->psync_idx  = idx;
+    team->psync_seq  = 0;
+    team->psync_done = 0;
+
+    shmem_internal_team_pool[idx] = team;
+}
+
+/* Create a strided team with the given global <start, stride, size> from the
+ * parent team.  The pSync slot is agreed upon by the members of the new team,
+ * followed by a barrier and a reduction over the parent team. */
+static int team_split_triplet(shmem_internal_team_t *parent_team, int global_PE_start,
+                              int PE_stride, int PE_size, const shmem_team_config_t *config,
+                              long config_mask, shmem_internal_team_t **new_team)
+{
     int my_pe = shmem_internal_pe_in_active_set(shmem_internal_my_pe,
                                                 global_PE_start, PE_stride, PE_size);
 
@@ -281,18 +417,8 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
     if (my_pe != -1) {
         char bit_str[SHMEM_INTERNAL_DIAG_STRLEN];
 
-        myteam = calloc(1, sizeof(shmem_internal_team_t));
-
-        myteam->my_pe       = my_pe;
-        myteam->start       = global_PE_start;
-        myteam->stride      = PE_stride;
-        myteam->size        = PE_size;
-        if (config) {
-            myteam->config      = *config;
-            myteam->config_mask = config_mask;
-        }
-        myteam->contexts_len = 0;
-        myteam->psync_idx = -1;
+        myteam = team_alloc(my_pe, global_PE_start, PE_stride, PE_size,
+                            config, config_mask);
 
         shmem_internal_op_to_all(psync_pool_avail_reduced,
                                  psync_pool_avail, N_PSYNC_BYTES, 1,
@@ -300,7 +426,8 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
                                  psync, SHM_INTERNAL_BAND, SHM_INTERNAL_UCHAR);
 
         /* We cannot release the psync here, because this reduction may not
-         * have been performed on the entire parent team. */
+         * have been performed on the entire parent team.  The parent team
+         * barrier below releases it. */
 
         shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
                                      psync_pool_avail_reduced, N_PSYNC_BYTES);
@@ -322,19 +449,12 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
             *team_ret_val = 1;
         } else {
             /* Set the selected psync bit to 0, reserving that slot */
-            shmem_internal_bit_clear(psync_pool_avail, N_PSYNC_BYTES, myteam->psync_idx);
-
-            for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++)
-                myteam->psync_avail[i] = 1;
+            team_set_psync(myteam, myteam->psync_idx);
 
             *new_team = myteam;
-
-            shmem_internal_team_pool[myteam->psync_idx] = *new_team;
         }
     }
 
-    shmem_internal_team_release_psyncs(parent_team, REDUCE);
-
     /* This barrier on the parent team eliminates problematic race conditions
      * during psync allocation between back-to-back team creations. */
     psync = shmem_internal_team_choose_psync(parent_team, SYNC);
@@ -361,6 +481,174 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
     return *team_ret_val_reduced;
 }
 
+int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE_start, int PE_stride,
+                                      int PE_size, const shmem_team_config_t *config, long config_mask,
+                                      shmem_internal_team_t **new_team)
+{
+
+    *new_team = SHMEM_TEAM_INVALID;
+
+    if (parent_team == SHMEM_TEAM_INVALID) {
+        return 1;
+    }
+
+    if (PE_start < 0 || PE_start >= parent_team->size ||
+        PE_size <= 0 || PE_size > parent_team->size   ||
+        PE_stride < 1) {
+        RAISE_WARN_MSG("Invalid <start, stride, size>: child <%d, %d, %d>, parent <%d, %d, %d>\n",
+                       PE_start, PE_stride, PE_size,
+                       parent_team->start, parent_team->stride, parent_team->size);
+        return -1;
+    }
+
+    /* A strided subset of a list team is, in general, another list team */
+    if (parent_team->stride == SHMEM_INTERNAL_STRIDE_LIST) {
+        int *ranks, ret;
+
+        if (PE_start + (long) PE_stride * (PE_size - 1) >= parent_team->size) {
+            RAISE_WARN_MSG("Invalid <start, stride, size>: child <%d, %d, %d>, parent list team of size %d\n",
+                           PE_start, PE_stride, PE_size, parent_team->size);
+            return -1;
+        }
+
+        ranks = malloc(PE_size * sizeof(int));
+        if (NULL == ranks) {
+            RAISE_ERROR_STR("Out of memory allocating team PE list");
+        }
+
+        for (int i = 0; i < PE_size; i++)
+            ranks[i] = PE_start + i * PE_stride;
+
+        ret = shmem_internal_team_split_list(parent_team, ranks, PE_size, config,
+                                             config_mask, new_team);
+        free(ranks);
+        return ret;
+    }
+
+    int global_PE_start = shmem_internal_team_pe(parent_team, PE_start);
+    int global_PE_end   = global_PE_start + PE_stride * (PE_size -1);
+
+    if (global_PE_start >= shmem_internal_num_pes ||
+        global_PE_end >= shmem_internal_num_pes) {
+        RAISE_WARN_MSG("Starting PE (%d) or ending PE (%d) is invalid\n",
+                       global_PE_start, global_PE_end);
+        return -1;
+    }
+
+    return team_split_triplet(parent_team, global_PE_start, PE_stride, PE_size,
+                              config, config_mask, new_team);
+}
+
+/* Create a team from an arbitrary list of PEs, given by their index in the
+ * parent team.  All PEs in the parent team must pass the same list.  Lists
+ * that turn out to be evenly spaced create an ordinary strided team. */
+int shmem_internal_team_split_list(shmem_internal_team_t *parent_team, const int *pe_list,
+                                   int npes, const shmem_team_config_t *config, long config_mask,
+                                   shmem_internal_team_t **new_team)
+{
+    char bit_str[SHMEM_INTERNAL_DIAG_STRLEN];
+    int *pes, stride, my_pe, idx;
+
+    *new_team = SHMEM_TEAM_INVALID;
+
+    if (parent_team == SHMEM_TEAM_INVALID) {
+        return 1;
+    }
+
+    if (npes <= 0 || npes > parent_team->size) {
+        RAISE_WARN_MSG("Invalid team size %d, parent team size is %d\n", npes,
+                       parent_team->size);
+        return -1;
+    }
+
+    pes = malloc(npes * sizeof(int));
+    if (NULL == pes) {
+        RAISE_ERROR_STR("Out of memory allocating team PE list");
+    }
+
+    for (int i = 0; i < npes; i++) {
+        if (pe_list[i] < 0 || pe_list[i] >= parent_team->size) {
+            RAISE_WARN_MSG("Invalid PE %d in team PE list, parent team size is %d\n",
+                           pe_list[i], parent_team->size);
+            free(pes);
+            return -1;
+        }
+        pes[i] = shmem_internal_team_pe(parent_team, pe_list[i]);
+    }
+
+    qsort(pes, npes, sizeof(int), compare_pes);
+
+    stride = (npes > 1) ? pes[1] - pes[0] : 1;
+
+    for (int i = 1; i < npes; i++) {
+        if (pes[i] == pes[i-1]) {
+            RAISE_WARN_MSG("PE %d appears more than once in team PE list\n", pes[i]);
+            free(pes);
+            return -1;
+        }
+        if (pes[i] - pes[i-1] != stride)
+            stride = SHMEM_INTERNAL_STRIDE_LIST;
+    }
+
+    if (stride != SHMEM_INTERNAL_STRIDE_LIST) {
+        int start = pes[0];
+        free(pes);
+        return team_split_triplet(parent_team, start, stride, npes, config,
+                                  config_mask, new_team);
+    }
+
+    /* The new team's pSync slot is indexed through the team pool to locate its
+     * PE list, so the slot must be known before any collective can run over
+     * the new team.  Select the slot with a reduction over the parent team,
+     * whose result is the same on all PEs.  The reduction also ensures that all
+     * parent PEs have finished with any team that previously held the slot. */
+    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+
+    long *psync = shmem_internal_team_choose_psync(parent_team, REDUCE);
+
+    shmem_internal_op_to_all(psync_pool_avail_reduced,
+                             psync_pool_avail, N_PSYNC_BYTES, 1,
+                             parent_team->start, parent_team->stride, parent_team->size, NULL,
+                             psync, SHM_INTERNAL_BAND, SHM_INTERNAL_UCHAR);
+
+    shmem_internal_team_release_psyncs(parent_team, REDUCE);
+
+    idx = shmem_internal_bit_1st_nonzero(psync_pool_avail_reduced, N_PSYNC_BYTES);
+
+    shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
+                                 psync_pool_avail_reduced, N_PSYNC_BYTES);
+    DEBUG_MSG("All pSyncs [ %s ], allocated %d\n", bit_str, idx);
+
+    if (idx == -1 || idx >= shmem_internal_params.TEAMS_MAX) {
+        RAISE_WARN_MSG("No more teams available (max = %ld), try increasing SHMEM_TEAMS_MAX\n",
+                       shmem_internal_params.TEAMS_MAX);
+        free(pes);
+        return 1;
+    }
+
+    my_pe = -1;
+    for (int i = 0; i < npes; i++) {
+        if (pes[i] == shmem_internal_my_pe) {
+            my_pe = i;
+            break;
+        }
+    }
+
+    if (my_pe == -1) {
+        free(pes);
+        return 0;
+    }
+
+    shmem_internal_team_t *myteam = team_alloc(my_pe, idx, SHMEM_INTERNAL_STRIDE_LIST,
+                                               npes, config, config_mask);
+    team_set_pe_list(myteam, pes);
+    team_set_psync(myteam, idx);
+
+    *new_team = myteam;
+
+    return 0;
+}
+
 int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
                                  const shmem_team_config_t *xaxis_config, long xaxis_mask,
                                  shmem_internal_team_t **xaxis_team, const shmem_team_config_t *yaxis_config,
@@ -377,58 +665,82 @@ int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
         xrange = parent_team->size;
     }
 
-    const int parent_start = parent_team->start;
-    const int parent_stride = parent_team->stride;
     const int parent_size = parent_team->size;
     const int num_xteams = ceil( parent_size / (float)xrange );
-    const int num_yteams = xrange;
+    const int my_parent_pe = parent_team->my_pe;
+    char bit_str[SHMEM_INTERNAL_DIAG_STRLEN];
+    int xidx, yidx;
+
+    /* The x-axis teams are disjoint, as are the y-axis teams, so every x-axis
+     * team can share one pSync slot and every y-axis team another.  A single
+     * reduction over the parent selects two slots that are free on all parent
+     * PEs.  Since every PE sees the same result, each PE then creates its own
+     * teams without further communication.  The reduction also ensures that
+     * all parent PEs have finished with any team that previously held these
+     * slots. */
+    shmem_internal_quiet(SHMEM_CTX_DEFAULT);
 
-    int start = 0;
-    int ret = 0;
+    long *psync = shmem_internal_team_choose_psync(parent_team, REDUCE);
 
-    for (int i = 0; i < num_xteams; i++) {
-        shmem_internal_team_t *my_xteam;
-        int xsize = (i == num_xteams - 1 && parent_size % xrange) ? parent_size % xrange : xrange;
+    shmem_internal_op_to_all(psync_pool_avail_reduced,
+                             psync_pool_avail, N_PSYNC_BYTES, 1,
+                             parent_team->start, parent_team->stride, parent_size, NULL,
+                             psync, SHM_INTERNAL_BAND, SHM_INTERNAL_UCHAR);
 
-        ret = shmem_internal_team_split_strided(parent_team, start, parent_stride,
-                                                xsize, xaxis_config, xaxis_mask, &my_xteam);
-        if (ret) {
-            RAISE_ERROR_MSG("Creation of x-axis team %d of %d failed\n", i+1, num_xteams);
-        }
-        start += xrange;
+    shmem_internal_team_release_psyncs(parent_team, REDUCE);
 
-        if (my_xteam != SHMEM_TEAM_INVALID) {
-            shmem_internal_assert(*xaxis_team == SHMEM_TEAM_INVALID);
-            *xaxis_team = my_xteam;
-        }
+    shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
+                                 psync_pool_avail_reduced, N_PSYNC_BYTES);
+    DEBUG_MSG("All pSyncs [ %s ]\n", bit_str);
+
+    xidx = shmem_internal_bit_1st_nonzero(psync_pool_avail_reduced, N_PSYNC_BYTES);
+    if (xidx != -1)
+        shmem_internal_bit_clear(psync_pool_avail_reduced, N_PSYNC_BYTES, xidx);
+    yidx = shmem_internal_bit_1st_nonzero(psync_pool_avail_reduced, N_PSYNC_BYTES);
+
+    if (xidx == -1 || xidx >= shmem_internal_params.TEAMS_MAX ||
+        yidx == -1 || yidx >= shmem_internal_params.TEAMS_MAX) {
+        RAISE_WARN_MSG("No more teams available (max = %ld), try increasing SHMEM_TEAMS_MAX\n",
+                       shmem_internal_params.TEAMS_MAX);
+        RAISE_WARN_MSG("Team split 2d failed: xrange %d, parent <%d, %d, %d>\n", xrange,
+                       parent_team->start, parent_team->stride, parent_size);
+        return 1;
     }
 
-    start = 0;
-
-    for (int i = 0; i < num_yteams; i++) {
-        shmem_internal_team_t *my_yteam;
-        int remainder = parent_size % xrange;
-        int yrange = parent_size / xrange;
-        int ysize = (remainder && i < remainder) ? yrange + 1 : yrange;
+    DEBUG_MSG("Allocated x-axis pSync %d, y-axis pSync %d\n", xidx, yidx);
 
-        ret = shmem_internal_team_split_strided(parent_team, start, xrange*parent_stride,
-                                        ysize, yaxis_config, yaxis_mask, &my_yteam);
-        if (ret) {
-            RAISE_ERROR_MSG("Creation of y-axis team %d of %d failed\n", i+1, num_yteams);
-        }
-        start += 1;
+    /* This PE is in row (my_parent_pe / xrange) and column (my_parent_pe % xrange) */
+    int xteam_idx = my_parent_pe / xrange;
+    int xstart = xteam_idx * xrange;
+    int xsize = (xteam_idx == num_xteams - 1 && parent_size % xrange) ?
+                parent_size % xrange : xrange;
 
-        if (my_yteam != SHMEM_TEAM_INVALID) {
-            shmem_internal_assert(*yaxis_team == SHMEM_TEAM_INVALID);
-            *yaxis_team = my_yteam;
-        }
+    if (parent_team->stride == SHMEM_INTERNAL_STRIDE_LIST) {
+        *xaxis_team = team_alloc(my_parent_pe % xrange, xidx, SHMEM_INTERNAL_STRIDE_LIST,
+                                 xsize, xaxis_config, xaxis_mask);
+        team_set_pe_list(*xaxis_team, team_sublist(parent_team, xstart, 1, xsize));
+    } else {
+        *xaxis_team = team_alloc(my_parent_pe % xrange,
+                                 shmem_internal_team_pe(parent_team, xstart),
+                                 parent_team->stride, xsize, xaxis_config, xaxis_mask);
     }
+    team_set_psync(*xaxis_team, xidx);
 
-    long *psync = shmem_internal_team_choose_psync(parent_team, SYNC);
+    int yteam_idx = my_parent_pe % xrange;
+    int remainder = parent_size % xrange;
+    int yrange = parent_size / xrange;
+    int ysize = (remainder && yteam_idx < remainder) ? yrange + 1 : yrange;
 
-    shmem_internal_barrier(parent_start, parent_stride, parent_size, psync);
-
-    shmem_internal_team_release_psyncs(parent_team, SYNC);
+    if (parent_team->stride == SHMEM_INTERNAL_STRIDE_LIST) {
+        *yaxis_team = team_alloc(my_parent_pe / xrange, yidx, SHMEM_INTERNAL_STRIDE_LIST,
+                                 ysize, yaxis_config, yaxis_mask);
+        team_set_pe_list(*yaxis_team, team_sublist(parent_team, yteam_idx, xrange, ysize));
+    } else {
+        *yaxis_team = team_alloc(my_parent_pe / xrange,
+                                 shmem_internal_team_pe(parent_team, yteam_idx),
+                                 xrange * parent_team->stride, ysize, yaxis_config, yaxis_mask);
+    }
+    team_set_psync(*yaxis_team, yidx);
 
     return 0;
 }
@@ -444,18 +756,40 @@ int shmem_internal_team_destroy(shmem_internal_team_t *team)
         shmem_internal_bit_set(psync_pool_avail, N_PSYNC_BYTES, team->psync_idx);
     }
 
+    /* Drop the context pool first, so that the destroy calls below release
+     * pooled and active contexts instead of returning them to the pool */
+    free(team->ctx_pool);
+    team->ctx_pool = NULL;
+    team->ctx_pool_len = 0;
+    team->ctx_pool_head = 0;
+
     /* Destroy all undestroyed shareable contexts on this team */
     for (size_t i = 0; i < team->contexts_len; i++) {
         if (team->contexts[i] != NULL) {
             if (team->contexts[i]->options & SHMEM_CTX_PRIVATE)
                 RAISE_WARN_MSG("Destroying team with unfreed private context (%zu)\n", i);
+            shmem_shr_transport_ctx_destroy((shmem_ctx_t) team->contexts[i]);
             shmem_transport_quiet(team->contexts[i]);
             shmem_transport_ctx_destroy(team->contexts[i]);
         }
     }
+    /* Once its non-blocking collectives complete, every message destined
+     * to this PE has arrived and the counters can be reused by a new team */
+    shmem_internal_coll_nbc_drain(team);
+
+    long *nbc_psync = shmem_internal_team_nbc_psync(team);
+    for (int i = 0; i < N_NBC_PSYNCS; i++)
+        nbc_psync[i] = 0;
+
     shmem_internal_team_pool[team->psync_idx] = NULL;
     free(team->contexts);
 
+    if (team->pe_list) {
+        HASH_CLEAR(hh, team->rank_map);
+        free(team->rank_entries);
+        free(team->pe_list);
+    }
+
     if (team != &shmem_internal_team_world && team != &shmem_internal_team_shared) {
         free(team);
     }
@@ -464,36 +798,40 @@ int shmem_internal_team_destroy(shmem_internal_team_t *team)
 }
 
 /* Returns a psync from the given team that can be safely used for the
- * specified collective operation. */
+ * specified collective operation.
+ *
+ * Collective pSyncs are taken round-robin from the team's ring.  psync_seq
+ * counts the collectives issued on the team and psync_done counts those known
+ * to have completed on every PE, so the slot of collective psync_seq was last
+ * used by collective psync_seq - depth and can be reused once that collective
+ * is done.  The team only synchronizes when the ring wraps onto a slot that
+ * may still be in use. */
 long * shmem_internal_team_choose_psync(shmem_internal_team_t *team, shmem_internal_team_op_t op)
 {
+    long depth = shmem_internal_params.TEAM_PSYNC_DEPTH;
+    long *psync;
 
     switch (op) {
         case SYNC:
             return &shmem_internal_psync_barrier_pool[team->psync_idx * SHMEM_SYNC_SIZE];
 
         default:
-            for (int i = 0; i < N_PSYNCS_PER_TEAM; i++) {
-                if (team->psync_avail[i]) {
-                    team->psync_avail[i] = 0;
-                    return &shmem_internal_psync_pool[(team->psync_idx + i) * PSYNC_CHUNK_SIZE];
-                }
-            }
-
-            /* No psync is available, so we must quiesce communication across all psyncs on this team. */
-            /* Currently, all collectives on all teams are done on the default context. */
-            shmem_internal_quiet(SHMEM_CTX_DEFAULT);
+            if (team->psync_seq - team->psync_done >= depth) {
+                /* The ring is exhausted, so we must quiesce communication across all psyncs on this team. */
+                /* Currently, all collectives on all teams are done on the default context. */
+                shmem_internal_quiet(SHMEM_CTX_DEFAULT);
 
-            size_t psync = team->psync_idx * SHMEM_SYNC_SIZE;
-            shmem_internal_sync(team->start, team->stride, team->size,
-                                &shmem_internal_psync_barrier_pool[psync]);
+                shmem_internal_sync(team->start, team->stride, team->size,
+                                    &shmem_internal_psync_barrier_pool[team->psync_idx * SHMEM_SYNC_SIZE]);
 
-            for (int i = 0; i < N_PSYNCS_PER_TEAM; i++) {
-                team->psync_avail[i] = 1;
+                team->psync_done = team->psync_seq;
             }
-            team->psync_avail[0] = 0;
 
-            return &shmem_internal_psync_pool[psync];
+            psync = &shmem_internal_psync_pool[team->psync_idx * PSYNC_CHUNK_SIZE +
+                                               (team->psync_seq % depth) * SHMEM_SYNC_SIZE];
+            team->psync_seq++;
+
+            return psync;
     }
 }
 
@@ -501,13 +839,67 @@ void shmem_internal_team_release_psyncs(shmem_internal_team_t *team, shmem_inter
 {
     switch (op) {
         case SYNC:
-            for (size_t i = 0; i < N_PSYNCS_PER_TEAM; i++) {
-                team->psync_avail[i] = 1;
-            }
+            /* Every collective issued before the sync has completed */
+            team->psync_done = team->psync_seq;
+            break;
+        case REDUCE:
+        case COLLECT:
+        case ALLTOALL:
+            /* These collectives complete only after every PE has entered them,
+             * and hence every PE has completed the previous collective.  This
+             * does not hold when they return without communicating (zero
+             * length or a single PE), so callers release them only when the
+             * operation synchronized the team. */
+            if (team->psync_done < team->psync_seq - 1)
+                team->psync_done = team->psync_seq - 1;
             break;
         default:
+            /* A broadcast can complete before the other PEs have entered it */
             break;
     }
 
     return;
 }
+
+/* Reserve a pSync for a persistent collective on the team.  All PEs in the
+ * team select the lowest slot that is free on every PE, so this must be
+ * called collectively.  Returns NULL on all PEs when no slot is left. */
+long * shmem_internal_team_reserve_psync(shmem_internal_team_t *team, int *psync_idx)
+{
+    char bit_str[SHMEM_INTERNAL_DIAG_STRLEN];
+    long *psync = shmem_internal_team_choose_psync(team, REDUCE);
+    int idx;
+
+    shmem_internal_op_to_all(coll_req_psync_avail_reduced,
+                             coll_req_psync_avail, N_PSYNC_BYTES, 1,
+                             team->start, team->stride, team->size, NULL,
+                             psync, SHM_INTERNAL_BAND, SHM_INTERNAL_UCHAR);
+
+    shmem_internal_team_release_psyncs(team, REDUCE);
+
+    idx = shmem_internal_bit_1st_nonzero(coll_req_psync_avail_reduced, N_PSYNC_BYTES);
+
+    shmem_internal_bit_to_string(bit_str, SHMEM_INTERNAL_DIAG_STRLEN,
+                                 coll_req_psync_avail_reduced, N_PSYNC_BYTES);
+    DEBUG_MSG("Persistent pSyncs [ %s ], allocated %d\n", bit_str, idx);
+
+    /* Peers may still be reading our availability bits */
+    psync = shmem_internal_team_choose_psync(team, SYNC);
+    shmem_internal_sync(team->start, team->stride, team->size, psync);
+    shmem_internal_team_release_psyncs(team, SYNC);
+
+    if (idx == -1 || idx >= shmem_internal_params.COLL_REQS_MAX) {
+        *psync_idx = -1;
+        return NULL;
+    }
+
+    shmem_internal_bit_clear(coll_req_psync_avail, N_PSYNC_BYTES, idx);
+    *psync_idx = idx;
+
+    return &coll_req_psync_pool[idx * SHMEM_SYNC_SIZE];
+}
+
+void shmem_internal_team_unreserve_psync(int psync_idx)
+{
+    shmem_internal_bit_set(coll_req_psync_avail, N_PSYNC_BYTES, psync_idx);
+}
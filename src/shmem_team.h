@@ -15,23 +15,47 @@
 #include "transport.h"
 #include "uthash.h"
 
-#define N_PSYNCS_PER_TEAM   2
+#define N_NBC_PSYNCS        2
 
+/* Reverse map from global PE to team PE for teams with an arbitrary PE list */
+struct shmem_internal_team_rank_t {
+    int                            pe;
+    int                            rank;
+    UT_hash_handle                 hh;
+};
+typedef struct shmem_internal_team_rank_t shmem_internal_team_rank_t;
+
+/* Teams are described by a <start, stride, size> triplet of global PEs, or
+ * by a sorted list of global PEs.  A list team has a stride of
+ * SHMEM_INTERNAL_STRIDE_LIST and a start equal to its psync_idx, so that its
+ * triplet can be passed to the collectives like that of any other team. */
 struct shmem_internal_team_t {
     int                            my_pe;
     int                            start, stride, size;
+    int                           *pe_list;
+    shmem_internal_team_rank_t    *rank_map, *rank_entries;
     int                            psync_idx;
-    int                            psync_avail[N_PSYNCS_PER_TEAM];
+    long                           psync_seq, psync_done;
+    long                           nbc_posted, nbc_completed;
+    long                           nbc_up, nbc_down;
     shmem_team_config_t           config;
     long                           config_mask;
     size_t                         contexts_len;
     struct shmem_transport_ctx_t **contexts;
+    /* Destroyed shareable contexts kept for reuse.  The pool is a lock-free
+     * LIFO; ctx_pool_head holds an ABA tag in its upper 32 bits and the top
+     * slot plus one (zero when empty) in its lower 32 bits. */
+    size_t                         ctx_pool_len;
+    struct shmem_transport_ctx_t **ctx_pool;
+    uint64_t                       ctx_pool_head;
 };
 typedef struct shmem_internal_team_t shmem_internal_team_t;
 
 extern shmem_internal_team_t shmem_internal_team_world;
 extern shmem_internal_team_t shmem_internal_team_shared;
 
+extern long *shmem_internal_nbc_psync_pool;
+
 enum shmem_internal_team_op_t {
     SYNC = 0,
     BCAST,
@@ -59,6 +83,10 @@ int shmem_internal_team_split_strided(shmem_internal_team_t *parent_team, int PE
                                       int PE_size, const shmem_team_config_t *config, long config_mask,
                                       shmem_internal_team_t **new_team);
 
+int shmem_internal_team_split_list(shmem_internal_team_t *parent_team, const int *pe_list,
+                                   int npes, const shmem_team_config_t *config, long config_mask,
+                                   shmem_internal_team_t **new_team);
+
 int shmem_internal_team_split_2d(shmem_internal_team_t *parent_team, int xrange,
                                  const shmem_team_config_t *xaxis_config, long xaxis_mask, shmem_internal_team_t **xaxis_team,
                                  const shmem_team_config_t *yaxis_config, long yaxis_mask, shmem_internal_team_t **yaxis_team);
@@ -73,10 +101,22 @@ long * shmem_internal_team_choose_psync(shmem_internal_team_t *team, shmem_inter
 
 void shmem_internal_team_release_psyncs(shmem_internal_team_t *team, shmem_internal_team_op_t op);
 
+long * shmem_internal_team_reserve_psync(shmem_internal_team_t *team, int *psync_idx);
+
+void shmem_internal_team_unreserve_psync(int psync_idx);
+
+/* Returns the team's non-blocking collective counters, which are only ever
+ * incremented while the team exists */
+static inline
+long * shmem_internal_team_nbc_psync(shmem_internal_team_t *team)
+{
+    return &shmem_internal_nbc_psync_pool[team->psync_idx * N_NBC_PSYNCS];
+}
+
 static inline
 int shmem_internal_team_pe(shmem_internal_team_t *team, int pe)
 {
-    return team->start + team->stride * pe;
+    return shmem_internal_active_set_pe(pe, team->start, team->stride);
 }
 
 #endif
@@ -0,0 +1,55 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#include <inttypes.h>
+
+#define SHMEM_INTERNAL_INCLUDE
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_wait.h"
+
+int shmem_internal_wait_adaptive = 0;
+uint64_t shmem_internal_wait_spin_max = 0;
+
+/* Statistics for point-to-point synchronization waits, which are not
+ * associated with a context */
+shmem_internal_wait_stats_t shmem_internal_wait_stats;
+
+int
+shmem_internal_wait_init(void)
+{
+    if (shmem_internal_params.WAIT_SPIN_MAX < 0) {
+        RETURN_ERROR_MSG("Invalid SHMEM_WAIT_SPIN_MAX (%ld)\n",
+                         shmem_internal_params.WAIT_SPIN_MAX);
+        return 1;
+    }
+
+    shmem_internal_wait_adaptive = shmem_internal_params.WAIT_ADAPTIVE;
+    shmem_internal_wait_spin_max = (uint64_t) shmem_internal_params.WAIT_SPIN_MAX * 1000;
+
+    return 0;
+}
+
+void
+shmem_internal_wait_fini(void)
+{
+    if (shmem_internal_wait_adaptive) {
+        DEBUG_MSG("wait_until: waits = %"PRIu64", blocked = %"PRIu64", est_ns = %"PRIu64"\n",
+                  shmem_internal_wait_stats.nwaits, shmem_internal_wait_stats.nblocks,
+                  shmem_internal_wait_stats.est_ns);
+    }
+}
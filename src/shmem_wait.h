@@ -0,0 +1,138 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#ifndef SHMEM_WAIT_H
+#define SHMEM_WAIT_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "config.h"
+#include "shmem_atomic.h"
+
+/* Adaptive spin-then-block waiting.  Each waiter keeps a running average of
+ * how long its waits take to complete.  A wait spins with exponential
+ * backoff for up to twice that time (bounded by SHMEM_WAIT_SPIN_MAX) and then
+ * falls back to the blocking path.  Waits that usually outlast the spin limit
+ * block immediately.  Adaptive waiting is enabled by SHMEM_WAIT_ADAPTIVE;
+ * otherwise none of the code below is reached. */
+
+/* Maximum number of SPINLOCK_BODY calls between completion checks */
+#define SHMEM_INTERNAL_WAIT_BACKOFF_MAX 32
+
+/* Minimum spin time, in nanoseconds, for waiters that complete quickly */
+#define SHMEM_INTERNAL_WAIT_SPIN_MIN    1000
+
+typedef struct shmem_internal_wait_stats_t {
+    uint64_t est_ns;    /* Running average of the wait completion time */
+    uint64_t nwaits;    /* Waits that did not complete immediately */
+    uint64_t nblocks;   /* Waits that exhausted the spin budget */
+} shmem_internal_wait_stats_t;
+
+typedef struct shmem_internal_wait_t {
+    shmem_internal_wait_stats_t *stats;
+    uint64_t start;
+    uint64_t budget;
+    unsigned int delay;
+} shmem_internal_wait_t;
+
+#define SHMEM_INTERNAL_WAIT_INITIALIZER(stats_ptr) { (stats_ptr), 0, 0, 0 }
+
+extern int shmem_internal_wait_adaptive;
+extern uint64_t shmem_internal_wait_spin_max;
+extern shmem_internal_wait_stats_t shmem_internal_wait_stats;
+
+int shmem_internal_wait_init(void);
+void shmem_internal_wait_fini(void);
+
+static inline uint64_t
+shmem_internal_wait_now(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint64_t) tv.tv_sec * 1000000000 + tv.tv_nsec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t) tv.tv_sec * 1000000000 + tv.tv_usec * 1000;
+#endif
+}
+
+/* Statistics may be shared by threads using the same context; relaxed
+ * accesses are sufficient, since they only steer the spin heuristic. */
+static inline uint64_t
+shmem_internal_wait_budget(shmem_internal_wait_stats_t *stats)
+{
+    uint64_t est = __atomic_load_n(&stats->est_ns, __ATOMIC_RELAXED);
+    uint64_t budget;
+
+    if (est > shmem_internal_wait_spin_max)
+        return 0;
+
+    budget = 2 * est;
+    if (budget < SHMEM_INTERNAL_WAIT_SPIN_MIN)
+        budget = SHMEM_INTERNAL_WAIT_SPIN_MIN;
+    if (budget > shmem_internal_wait_spin_max)
+        budget = shmem_internal_wait_spin_max;
+
+    return budget;
+}
+
+/* Back off once.  Returns nonzero while the spin budget lasts and zero when
+ * the caller should block.  The first call starts the wait. */
+static inline int
+shmem_internal_wait_spin(shmem_internal_wait_t *wait)
+{
+    unsigned int i;
+
+    if (wait->delay == 0) {
+        wait->start  = shmem_internal_wait_now();
+        wait->budget = shmem_internal_wait_budget(wait->stats);
+        wait->delay  = 1;
+    }
+
+    if (shmem_internal_wait_now() - wait->start >= wait->budget)
+        return 0;
+
+    for (i = 0; i < wait->delay; i++)
+        SPINLOCK_BODY();
+
+    if (wait->delay < SHMEM_INTERNAL_WAIT_BACKOFF_MAX)
+        wait->delay <<= 1;
+
+    return 1;
+}
+
+/* Fold the completed wait into the waiter's statistics */
+static inline void
+shmem_internal_wait_end(shmem_internal_wait_t *wait, int blocked)
+{
+    shmem_internal_wait_stats_t *stats = wait->stats;
+    uint64_t elapsed, est;
+
+    if (wait->delay == 0)
+        return;
+
+    elapsed = shmem_internal_wait_now() - wait->start;
+    est = __atomic_load_n(&stats->est_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->est_ns, est - est / 8 + elapsed / 8, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->nwaits, 1, __ATOMIC_RELAXED);
+    if (blocked)
+        __atomic_fetch_add(&stats->nblocks, 1, __ATOMIC_RELAXED);
+}
+
+#endif
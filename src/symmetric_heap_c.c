@@ -168,6 +168,17 @@ static void *mmap_alloc(size_t bytes)
                   shmem_internal_data_length + 2 * ONEGIG) & ~(ONEGIG - 1));
     void *ret;
 
+#ifdef USE_SHM
+    /* The heap must be backed by a segment that on-node peers can map */
+    return shmem_transport_shm_heap_alloc(requested_base, bytes);
+#elif defined(USE_CMA)
+    /* Back the heap with a mappable segment for shared memory AMOs */
+    if (shmem_internal_params.CMA_ATOMICS) {
+        ret = shmem_transport_cma_heap_alloc(requested_base, bytes);
+        if (NULL != ret) return ret;
+    }
+#endif
+
 #ifdef __linux__
     /* huge page support only on Linux for now, default is to use 2MB large pages */
     if (shmem_internal_params.SYMMETRIC_HEAP_USE_HUGE_PAGES) {
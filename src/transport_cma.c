@@ -22,7 +22,13 @@
 #include <limits.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#ifdef HAVE_SCHED_GETAFFINITY
+#include <sched.h>
+#endif
 
 #define SHMEM_INTERNAL_INCLUDE
 #include "shmem.h"
@@ -33,18 +39,200 @@
 pid_t shmem_transport_cma_my_pid;
 pid_t *shmem_transport_cma_peers = NULL;
 
+int shmem_transport_cma_shr_atomics = 0;
+char **shmem_transport_cma_heaps = NULL;
+static int shmem_transport_cma_heap_fd = -1;
+
+int shmem_transport_cma_queues_pending = 0;
+static struct shmem_transport_cma_queue_t *shmem_transport_cma_queues = NULL;
+static int shmem_transport_cma_num_peers = 0;
+#ifdef ENABLE_THREADS
+static shmem_internal_mutex_t shmem_transport_cma_queues_lock;
+#endif
+
+/* Large transfers are split into chunks that are aligned on the remote
+ * buffer and copied concurrently by the calling thread and a pool of helper
+ * threads.  One large transfer is in flight at a time; callers that find the
+ * pool busy copy their transfer on their own. */
+struct shmem_transport_cma_large_t {
+    pid_t               pid;
+    int                 write;
+    char               *local;
+    char               *remote;
+    size_t              len;
+    size_t              first;      /* Length of the first chunk */
+    size_t              nchunks;
+    size_t              next;       /* Next chunk to claim */
+    size_t              done;       /* Bytes copied */
+    int                 error;
+};
+
+static struct shmem_transport_cma_large_t shmem_transport_cma_large_xfer;
+static pthread_mutex_t shmem_transport_cma_large_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t shmem_transport_cma_helper_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t shmem_transport_cma_helper_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t shmem_transport_cma_done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *shmem_transport_cma_helpers = NULL;
+static int shmem_transport_cma_num_helpers = 0;
+static unsigned long shmem_transport_cma_large_gen = 0;
+static int shmem_transport_cma_helpers_exit = 0;
+
 typedef struct pmi_shmem_data {
     pid_t           lpid;   /* OS specific */
+    int             heap_fd;
 } pmi_cma_data_t;
 
 
+void *
+shmem_transport_cma_heap_alloc(void *requested_base, size_t len)
+{
+#ifdef HAVE_MEMFD_CREATE
+    void *ret;
+    int fd;
+
+    /* Huge page heaps keep using the private mapping */
+    if (shmem_internal_params.SYMMETRIC_HEAP_USE_HUGE_PAGES)
+        return NULL;
+
+    fd = memfd_create("sos-heap", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    if (0 != ftruncate(fd, len)) {
+        close(fd);
+        return NULL;
+    }
+
+    ret = mmap(requested_base, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ret == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    shmem_transport_cma_heap_fd = fd;
+    return ret;
+#else
+    return NULL;
+#endif
+}
+
+
+/* Copy bytes [off, off+len) of a large transfer, retrying partial copies.
+ * Returns 0 on success, or an errno value. */
+static int
+shmem_transport_cma_large_copy(struct shmem_transport_cma_large_t *xfer,
+                               size_t off, size_t len)
+{
+    struct iovec local, remote;
+    ssize_t bytes;
+
+    while (len > 0) {
+        local.iov_base  = xfer->local + off;
+        remote.iov_base = xfer->remote + off;
+        local.iov_len   = remote.iov_len = len;
+
+        if (xfer->write)
+            bytes = process_vm_writev(xfer->pid, &local, 1, &remote, 1, 0);
+        else
+            bytes = process_vm_readv(xfer->pid, &local, 1, &remote, 1, 0);
+
+        if (bytes < 0) return errno;
+        if (bytes == 0) return EFAULT;
+
+        off += bytes;
+        len -= bytes;
+    }
+
+    return 0;
+}
+
+
+/* Claim and copy chunks of the current transfer until none are left.  Chunks
+ * are claimed under the helper lock so that a helper that wakes up late can
+ * never claim a chunk of a later transfer with stale parameters.  The helper
+ * lock is held on entry and on return. */
+static void
+shmem_transport_cma_large_work(struct shmem_transport_cma_large_t *xfer,
+                               unsigned long gen)
+{
+    size_t chunk_size = shmem_internal_params.CMA_LARGE_CHUNK;
+    struct shmem_transport_cma_large_t chunk;
+    size_t off, len;
+    int err;
+
+    while (gen == shmem_transport_cma_large_gen && xfer->next < xfer->nchunks) {
+        if (0 == xfer->next) {
+            off = 0;
+            len = xfer->first;
+        } else {
+            off = xfer->first + (xfer->next - 1) * chunk_size;
+            len = (xfer->len - off < chunk_size) ? xfer->len - off : chunk_size;
+        }
+        xfer->next++;
+        chunk = *xfer;
+        pthread_mutex_unlock(&shmem_transport_cma_helper_lock);
+
+        err = shmem_transport_cma_large_copy(&chunk, off, len);
+
+        pthread_mutex_lock(&shmem_transport_cma_helper_lock);
+        if (0 != err) xfer->error = err;
+        xfer->done += len;
+        if (xfer->done == xfer->len)
+            pthread_cond_signal(&shmem_transport_cma_done_cond);
+    }
+}
+
+
+static void *
+shmem_transport_cma_helper_func(void *arg)
+{
+    unsigned long gen = 0;
+
+    pthread_mutex_lock(&shmem_transport_cma_helper_lock);
+
+    for (;;) {
+        while (gen == shmem_transport_cma_large_gen && !shmem_transport_cma_helpers_exit)
+            pthread_cond_wait(&shmem_transport_cma_helper_cond,
+                              &shmem_transport_cma_helper_lock);
+
+        if (shmem_transport_cma_helpers_exit) break;
+
+        gen = shmem_transport_cma_large_gen;
+        shmem_transport_cma_large_work(&shmem_transport_cma_large_xfer, gen);
+    }
+
+    pthread_mutex_unlock(&shmem_transport_cma_helper_lock);
+
+    return NULL;
+}
+
+
 int
 shmem_transport_cma_init(void)
 {
     int ret;
+    long page_size = sysconf(_SC_PAGESIZE);
     pmi_cma_data_t cma_data;
 
     shmem_transport_cma_my_pid = cma_data.lpid = getpid();
+    cma_data.heap_fd = shmem_transport_cma_heap_fd;
+
+    /* Sanitize the batching limits; a batch must hold at least one put */
+    if (shmem_internal_params.CMA_BATCH_COUNT > IOV_MAX)
+        shmem_internal_params.CMA_BATCH_COUNT = IOV_MAX;
+
+    if (shmem_internal_params.CMA_BATCH_COUNT <= 0)
+        shmem_internal_params.CMA_BATCH_PUT_MAX = 0;
+
+    if (shmem_internal_params.CMA_BATCH_PUT_MAX > shmem_internal_params.CMA_BATCH_BYTES)
+        shmem_internal_params.CMA_BATCH_PUT_MAX = shmem_internal_params.CMA_BATCH_BYTES;
+
+    /* Large transfer chunks are a whole number of pages */
+    shmem_internal_params.CMA_LARGE_CHUNK =
+        ((shmem_internal_params.CMA_LARGE_CHUNK + page_size - 1) / page_size) * page_size;
+    if (0 == shmem_internal_params.CMA_LARGE_CHUNK)
+        shmem_internal_params.CMA_LARGE_CHUNK = page_size;
+
+    SHMEM_MUTEX_INIT(shmem_transport_cma_queues_lock);
 
     /* Share information */
     ret = shmem_runtime_put("cma-procid", &cma_data, sizeof(pmi_cma_data_t));
@@ -59,15 +247,27 @@ shmem_transport_cma_init(void)
 int
 shmem_transport_cma_startup(void)
 {
-    int i, ret, peer_num, num_on_node;
+    int i, ret, peer_num, num_on_node, shr_atomics;
+    long num_helpers;
     pmi_cma_data_t cma_data;
+    int *heap_fds;
 
     num_on_node = shmem_runtime_get_node_size();
+    shmem_transport_cma_num_peers = num_on_node;
 
     /* allocate space for local peers */
     shmem_transport_cma_peers = calloc(num_on_node, sizeof(pid_t));
     if (NULL == shmem_transport_cma_peers) return 1;
 
+    heap_fds = calloc(num_on_node, sizeof(int));
+    if (NULL == heap_fds) return 1;
+
+    /* Shared memory AMOs are only used when every PE is on this node; AMOs
+     * from off-node PEs would not be atomic with respect to them. */
+    shr_atomics = shmem_internal_params.CMA_ATOMICS &&
+                  num_on_node == shmem_internal_num_pes &&
+                  shmem_internal_num_pes > 1;
+
     /* get local peer pids */
     for (i = 0 ; i < shmem_internal_num_pes; ++i) {
         peer_num = shmem_runtime_get_node_rank(i);
@@ -82,6 +282,99 @@ shmem_transport_cma_startup(void)
 
         /* update the connectivity map... */
         shmem_transport_cma_peers[peer_num] = cma_data.lpid;
+        heap_fds[peer_num] = cma_data.heap_fd;
+
+        /* Every PE sees the same data, so all PEs make the same choice */
+        if (cma_data.heap_fd < 0) shr_atomics = 0;
+    }
+
+    if (shr_atomics) {
+        shmem_transport_cma_heaps = calloc(num_on_node, sizeof(char *));
+        if (NULL == shmem_transport_cma_heaps) {
+            free(heap_fds);
+            return 1;
+        }
+
+        for (i = 0 ; i < num_on_node; ++i) {
+            char path[64];
+            char errmsg[256];
+            void *ptr;
+            int fd;
+
+            if (shmem_transport_cma_peers[i] == shmem_transport_cma_my_pid) {
+                shmem_transport_cma_heaps[i] = shmem_internal_heap_base;
+                continue;
+            }
+
+            snprintf(path, sizeof(path), "/proc/%d/fd/%d",
+                     (int) shmem_transport_cma_peers[i], heap_fds[i]);
+            fd = open(path, O_RDWR);
+            if (fd < 0) {
+                RETURN_ERROR_MSG("could not open peer heap %s: %s\n", path,
+                                 shmem_util_strerror(errno, errmsg, 256));
+                free(heap_fds);
+                return 1;
+            }
+
+            ptr = mmap(NULL, shmem_internal_heap_length, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+            close(fd);
+            if (ptr == MAP_FAILED) {
+                RETURN_ERROR_MSG("could not map peer heap %s: %s\n", path,
+                                 shmem_util_strerror(errno, errmsg, 256));
+                free(heap_fds);
+                return 1;
+            }
+
+            shmem_transport_cma_heaps[i] = ptr;
+        }
+
+        shmem_transport_cma_shr_atomics = 1;
+        DEBUG_STR("CMA using shared memory atomics on the symmetric heap");
+    }
+
+    free(heap_fds);
+
+    /* Helpers are opt-in, and only useful when there are peers to copy to */
+    num_helpers = shmem_internal_params.CMA_LARGE_THREADS;
+    if (0 == shmem_internal_params.CMA_LARGE_MIN || num_on_node < 2)
+        num_helpers = 0;
+
+#ifdef HAVE_SCHED_GETAFFINITY
+    /* Do not oversubscribe the cores available to the PEs on this node */
+    if (num_helpers > 0) {
+        cpu_set_t my_set;
+        long free_cores;
+
+        CPU_ZERO(&my_set);
+        if (0 == sched_getaffinity(0, sizeof(my_set), &my_set)) {
+            /* Assume the cores are shared with the other PEs on the node,
+             * and keep one for the PE itself */
+            free_cores = CPU_COUNT(&my_set) / num_on_node - 1;
+
+            if (num_helpers > free_cores) {
+                DEBUG_MSG("Limiting CMA helper threads to %ld free cores\n",
+                          free_cores > 0 ? free_cores : 0);
+                num_helpers = free_cores > 0 ? free_cores : 0;
+            }
+        }
+    }
+#endif
+
+    if (num_helpers > 0) {
+        shmem_transport_cma_helpers = malloc(num_helpers * sizeof(pthread_t));
+        if (NULL == shmem_transport_cma_helpers) return 1;
+
+        for (i = 0; i < num_helpers; i++) {
+            ret = pthread_create(&shmem_transport_cma_helpers[i], NULL,
+                                 shmem_transport_cma_helper_func, NULL);
+            if (0 != ret) {
+                RAISE_WARN_MSG("Unable to create CMA helper thread (%d), using %d helpers\n",
+                               ret, i);
+                break;
+            }
+            shmem_transport_cma_num_helpers++;
+        }
     }
 
     return 0;
@@ -90,9 +383,325 @@ shmem_transport_cma_startup(void)
 int
 shmem_transport_cma_fini(void)
 {
+    struct shmem_transport_cma_queue_t *queue, *next;
+    int i;
+
+    if (shmem_transport_cma_num_helpers > 0) {
+        pthread_mutex_lock(&shmem_transport_cma_helper_lock);
+        shmem_transport_cma_helpers_exit = 1;
+        pthread_cond_broadcast(&shmem_transport_cma_helper_cond);
+        pthread_mutex_unlock(&shmem_transport_cma_helper_lock);
+
+        for (i = 0; i < shmem_transport_cma_num_helpers; i++)
+            pthread_join(shmem_transport_cma_helpers[i], NULL);
+
+        shmem_transport_cma_num_helpers = 0;
+    }
+    free(shmem_transport_cma_helpers);
+    shmem_transport_cma_helpers = NULL;
+
+    if (NULL != shmem_transport_cma_heaps) {
+        for (i = 0; i < shmem_transport_cma_num_peers; i++) {
+            if (shmem_transport_cma_peers[i] != shmem_transport_cma_my_pid &&
+                NULL != shmem_transport_cma_heaps[i])
+                munmap(shmem_transport_cma_heaps[i], shmem_internal_heap_length);
+        }
+        free(shmem_transport_cma_heaps);
+        shmem_transport_cma_heaps = NULL;
+        shmem_transport_cma_shr_atomics = 0;
+    }
+
+    if (-1 != shmem_transport_cma_heap_fd) {
+        close(shmem_transport_cma_heap_fd);
+        shmem_transport_cma_heap_fd = -1;
+    }
+
+    for (queue = shmem_transport_cma_queues; queue != NULL; queue = next) {
+        next = queue->next;
+
+        for (i = 0; i < shmem_transport_cma_num_peers; i++) {
+            if (queue->peers[i].count > 0)
+                RAISE_WARN_MSG("Discarding %zu unflushed CMA puts\n",
+                               queue->peers[i].count);
+            free(queue->peers[i].remote);
+            free(queue->peers[i].staging);
+        }
+
+        SHMEM_MUTEX_DESTROY(queue->lock);
+        free(queue->peers);
+        free(queue);
+    }
+    shmem_transport_cma_queues = NULL;
+
+    SHMEM_MUTEX_DESTROY(shmem_transport_cma_queues_lock);
+
     if (NULL != shmem_transport_cma_peers) {
         free(shmem_transport_cma_peers);
     }
 
     return 0;
 }
+
+
+/* Find the queue for the given context.  Queues are never unlinked, so the
+ * list can be traversed without holding the list lock. */
+static inline struct shmem_transport_cma_queue_t *
+shmem_transport_cma_queue_find(shmem_ctx_t ctx)
+{
+    struct shmem_transport_cma_queue_t *queue;
+
+    for (queue = __atomic_load_n(&shmem_transport_cma_queues, __ATOMIC_ACQUIRE);
+         queue != NULL; queue = queue->next) {
+        if (__atomic_load_n(&queue->ctx, __ATOMIC_ACQUIRE) == ctx)
+            return queue;
+    }
+
+    return NULL;
+}
+
+
+static struct shmem_transport_cma_queue_t *
+shmem_transport_cma_queue_get(shmem_ctx_t ctx)
+{
+    struct shmem_transport_cma_queue_t *queue;
+
+    queue = shmem_transport_cma_queue_find(ctx);
+    if (NULL != queue) return queue;
+
+    SHMEM_MUTEX_LOCK(shmem_transport_cma_queues_lock);
+
+    /* Another thread may have attached a queue to this context while we
+     * waited for the lock */
+    queue = shmem_transport_cma_queue_find(ctx);
+    if (NULL != queue) {
+        SHMEM_MUTEX_UNLOCK(shmem_transport_cma_queues_lock);
+        return queue;
+    }
+
+    /* Reuse a queue released by a destroyed context */
+    for (queue = shmem_transport_cma_queues; queue != NULL; queue = queue->next) {
+        if (queue->ctx == NULL) {
+            __atomic_store_n(&queue->ctx, ctx, __ATOMIC_RELEASE);
+            SHMEM_MUTEX_UNLOCK(shmem_transport_cma_queues_lock);
+            return queue;
+        }
+    }
+
+    queue = malloc(sizeof(struct shmem_transport_cma_queue_t));
+    if (NULL == queue)
+        RAISE_ERROR_STR("Out of memory allocating CMA queue");
+
+    queue->peers = calloc(shmem_transport_cma_num_peers,
+                          sizeof(struct shmem_transport_cma_batch_t));
+    if (NULL == queue->peers)
+        RAISE_ERROR_STR("Out of memory allocating CMA queue");
+
+    queue->ctx     = ctx;
+    queue->pending = 0;
+    SHMEM_MUTEX_INIT(queue->lock);
+    queue->next    = shmem_transport_cma_queues;
+    __atomic_store_n(&shmem_transport_cma_queues, queue, __ATOMIC_RELEASE);
+
+    SHMEM_MUTEX_UNLOCK(shmem_transport_cma_queues_lock);
+
+    return queue;
+}
+
+
+/* Write out a peer's batch.  Caller must hold the queue lock. */
+static void
+shmem_transport_cma_batch_flush(struct shmem_transport_cma_queue_t *queue,
+                                int noderank)
+{
+    struct shmem_transport_cma_batch_t *batch = &queue->peers[noderank];
+    struct iovec src;
+    ssize_t bytes;
+
+    if (0 == batch->count) return;
+
+    src.iov_base = batch->staging;
+    src.iov_len  = batch->bytes;
+
+    bytes = process_vm_writev(shmem_transport_cma_peers[noderank],
+                              (const struct iovec *)&src, 1,
+                              (const struct iovec *)batch->remote,
+                              batch->count, 0);
+
+    if (bytes < 0 || (size_t) bytes != batch->bytes) {
+        char errmsg[256];
+        RAISE_ERROR_MSG("process_vm_writev() failed (%s)\n",
+                        shmem_util_strerror(errno, errmsg, 256));
+    }
+
+    batch->count = 0;
+    batch->bytes = 0;
+
+    if (0 == --queue->pending)
+        __atomic_fetch_sub(&shmem_transport_cma_queues_pending, 1, __ATOMIC_RELEASE);
+}
+
+
+void
+shmem_transport_cma_enqueue(shmem_ctx_t ctx, void *target, const void *source,
+                            size_t len, int noderank)
+{
+    struct shmem_transport_cma_queue_t *queue;
+    struct shmem_transport_cma_batch_t *batch;
+
+    if (0 == len) return;
+
+    queue = shmem_transport_cma_queue_get(ctx);
+    batch = &queue->peers[noderank];
+
+    SHMEM_MUTEX_LOCK(queue->lock);
+
+    if (NULL == batch->staging) {
+        batch->staging = malloc(shmem_internal_params.CMA_BATCH_BYTES);
+        batch->remote  = malloc(shmem_internal_params.CMA_BATCH_COUNT *
+                                sizeof(struct iovec));
+        if (NULL == batch->staging || NULL == batch->remote)
+            RAISE_ERROR_STR("Out of memory allocating CMA staging buffer");
+    }
+
+    if (batch->bytes + len > shmem_internal_params.CMA_BATCH_BYTES)
+        shmem_transport_cma_batch_flush(queue, noderank);
+
+    memcpy(batch->staging + batch->bytes, source, len);
+
+    /* Merge with the previous entry when the targets are contiguous */
+    if (batch->count > 0 &&
+        (char *) batch->remote[batch->count-1].iov_base +
+        batch->remote[batch->count-1].iov_len == (char *) target) {
+        batch->remote[batch->count-1].iov_len += len;
+    } else {
+        batch->remote[batch->count].iov_base = target;
+        batch->remote[batch->count].iov_len  = len;
+        if (1 == ++batch->count && 1 == ++queue->pending)
+            __atomic_fetch_add(&shmem_transport_cma_queues_pending, 1, __ATOMIC_RELEASE);
+    }
+    batch->bytes += len;
+
+    if (batch->count == (size_t) shmem_internal_params.CMA_BATCH_COUNT)
+        shmem_transport_cma_batch_flush(queue, noderank);
+
+    SHMEM_MUTEX_UNLOCK(queue->lock);
+}
+
+
+void
+shmem_transport_cma_flush(shmem_ctx_t ctx, int noderank)
+{
+    struct shmem_transport_cma_queue_t *queue;
+    int i;
+
+    queue = shmem_transport_cma_queue_find(ctx);
+    if (NULL == queue) return;
+
+    SHMEM_MUTEX_LOCK(queue->lock);
+
+    if (noderank >= 0) {
+        shmem_transport_cma_batch_flush(queue, noderank);
+    } else {
+        for (i = 0; i < shmem_transport_cma_num_peers && queue->pending > 0; i++)
+            shmem_transport_cma_batch_flush(queue, i);
+    }
+
+    SHMEM_MUTEX_UNLOCK(queue->lock);
+}
+
+
+void
+shmem_transport_cma_flush_all(void)
+{
+    struct shmem_transport_cma_queue_t *queue;
+    int i;
+
+    for (queue = __atomic_load_n(&shmem_transport_cma_queues, __ATOMIC_ACQUIRE);
+         queue != NULL; queue = queue->next) {
+        SHMEM_MUTEX_LOCK(queue->lock);
+        for (i = 0; i < shmem_transport_cma_num_peers && queue->pending > 0; i++)
+            shmem_transport_cma_batch_flush(queue, i);
+        SHMEM_MUTEX_UNLOCK(queue->lock);
+    }
+}
+
+
+void
+shmem_transport_cma_ctx_release(shmem_ctx_t ctx)
+{
+    struct shmem_transport_cma_queue_t *queue;
+
+    queue = shmem_transport_cma_queue_find(ctx);
+    if (NULL == queue) return;
+
+    shmem_transport_cma_flush(ctx, -1);
+    __atomic_store_n(&queue->ctx, NULL, __ATOMIC_RELEASE);
+}
+
+
+void
+shmem_transport_cma_large(int write, void *local, void *remote, size_t len,
+                          int noderank)
+{
+    struct shmem_transport_cma_large_t *xfer = &shmem_transport_cma_large_xfer;
+    size_t chunk_size = shmem_internal_params.CMA_LARGE_CHUNK;
+    unsigned long gen;
+    char errmsg[256];
+    int err;
+
+    if (0 == shmem_transport_cma_num_helpers ||
+        0 != pthread_mutex_trylock(&shmem_transport_cma_large_lock)) {
+        struct shmem_transport_cma_large_t self;
+
+        self.pid    = shmem_transport_cma_peers[noderank];
+        self.write  = write;
+        self.local  = local;
+        self.remote = remote;
+
+        err = shmem_transport_cma_large_copy(&self, 0, len);
+        if (0 != err)
+            RAISE_ERROR_MSG("%s failed (%s)\n",
+                            write ? "process_vm_writev()" : "process_vm_readv()",
+                            shmem_util_strerror(err, errmsg, 256));
+        return;
+    }
+
+    pthread_mutex_lock(&shmem_transport_cma_helper_lock);
+
+    xfer->pid    = shmem_transport_cma_peers[noderank];
+    xfer->write  = write;
+    xfer->local  = local;
+    xfer->remote = remote;
+    xfer->len    = len;
+    xfer->next   = 0;
+    xfer->error  = 0;
+    xfer->done   = 0;
+
+    /* Align the remaining chunks on the remote buffer */
+    xfer->first = chunk_size - ((uintptr_t) remote % chunk_size);
+    if (xfer->first >= len) {
+        xfer->first   = len;
+        xfer->nchunks = 1;
+    } else {
+        xfer->nchunks = 1 + (len - xfer->first + chunk_size - 1) / chunk_size;
+    }
+
+    gen = ++shmem_transport_cma_large_gen;
+    pthread_cond_broadcast(&shmem_transport_cma_helper_cond);
+
+    shmem_transport_cma_large_work(xfer, gen);
+
+    /* Sleep until the helpers finish the chunks they claimed */
+    while (xfer->done < len)
+        pthread_cond_wait(&shmem_transport_cma_done_cond,
+                          &shmem_transport_cma_helper_lock);
+
+    err = xfer->error;
+    pthread_mutex_unlock(&shmem_transport_cma_helper_lock);
+    pthread_mutex_unlock(&shmem_transport_cma_large_lock);
+
+    if (0 != err)
+        RAISE_ERROR_MSG("%s failed (%s)\n",
+                        write ? "process_vm_writev()" : "process_vm_readv()",
+                        shmem_util_strerror(err, errmsg, 256));
+}
@@ -33,14 +33,68 @@
 #include <inttypes.h>
 
 #include "shmem_internal.h"
+#include "shmem_copy.h"
 
 extern pid_t shmem_transport_cma_my_pid;
 extern pid_t *shmem_transport_cma_peers;
 
+/* When all PEs share a node, the symmetric heap is allocated from a memfd
+ * segment that every PE maps, so AMOs on heap addresses can be performed with
+ * processor atomics.  Entries are indexed by node rank. */
+extern int shmem_transport_cma_shr_atomics;
+extern char **shmem_transport_cma_heaps;
+
+/* Small puts are copied into a per-context, per-peer staging buffer and the
+ * target ranges are recorded as an iovec list.  Each batch is written with a
+ * single process_vm_writev() when it fills, or when the context is quieted or
+ * fenced. */
+struct shmem_transport_cma_batch_t {
+    size_t                              count;
+    size_t                              bytes;
+    struct iovec                       *remote;
+    char                               *staging;
+};
+
+struct shmem_transport_cma_queue_t {
+    shmem_ctx_t                         ctx;
+    struct shmem_transport_cma_batch_t *peers;
+    int                                 pending;    /* Non-empty batches */
+#ifdef ENABLE_THREADS
+    shmem_internal_mutex_t              lock;
+#endif
+    struct shmem_transport_cma_queue_t *next;
+};
+
+/* Number of queues holding unflushed puts */
+extern int shmem_transport_cma_queues_pending;
+
 int shmem_transport_cma_init(void);
 int shmem_transport_cma_startup(void);
 int shmem_transport_cma_fini(void);
 
+/* Allocate the symmetric heap from a segment that peers can map.  Returns
+ * NULL when the segment cannot be created. */
+void *shmem_transport_cma_heap_alloc(void *requested_base, size_t len);
+
+void shmem_transport_cma_enqueue(shmem_ctx_t ctx, void *target,
+                                 const void *source, size_t len, int noderank);
+void shmem_transport_cma_flush(shmem_ctx_t ctx, int noderank);
+void shmem_transport_cma_flush_all(void);
+void shmem_transport_cma_ctx_release(shmem_ctx_t ctx);
+
+/* Copy a transfer of at least CMA_LARGE_MIN bytes in page-aligned chunks,
+ * spread over the calling thread and the CMA helper threads.  write selects
+ * process_vm_writev() (local to remote) or process_vm_readv(). */
+void shmem_transport_cma_large(int write, void *local, void *remote, size_t len,
+                               int noderank);
+
+static inline int
+shmem_transport_cma_use_large(size_t len)
+{
+    return shmem_internal_params.CMA_LARGE_MIN > 0 &&
+           len >= shmem_internal_params.CMA_LARGE_MIN;
+}
+
 /*
  * Validate address is within SHMEM bounds: data and/or symHeap.
  */
@@ -60,6 +114,30 @@ int shmem_transport_cma_fini(void);
 #define CHK_ACCESS(target,id)
 #endif
 
+static inline void *
+shmem_transport_cma_ptr(const void *target, int noderank)
+{
+    if (NULL == shmem_transport_cma_heaps ||
+        (char*) target < (char*) shmem_internal_heap_base ||
+        (char*) target >= (char*) shmem_internal_heap_base + shmem_internal_heap_length)
+        return NULL;
+
+    return shmem_transport_cma_heaps[noderank] +
+           ((char*) target - (char*) shmem_internal_heap_base);
+}
+
+
+/* AMOs on mapped heap addresses use processor atomics; all other AMOs use the
+ * network transport.  The choice depends only on the target address, so a
+ * given location is always updated through the same path. */
+static inline int
+shmem_transport_cma_use_atomic(const void *target, int noderank)
+{
+    return shmem_transport_cma_shr_atomics && -1 != noderank &&
+           (char*) target >= (char*) shmem_internal_heap_base &&
+           (char*) target < (char*) shmem_internal_heap_base + shmem_internal_heap_length;
+}
+
 #ifndef HAVE_LIBC_CMA
 
 static inline
@@ -96,7 +174,12 @@ shmem_transport_cma_put(void *target, const void *source, size_t len,
         CHK_ACCESS(target,"cma_put target");
 
         if ( target_pid == shmem_transport_cma_my_pid ) {
-            memcpy(target, source, len);
+            shmem_internal_copy(target, source, len);
+            return;
+        }
+
+        if (shmem_transport_cma_use_large(len)) {
+            shmem_transport_cma_large(1, (void *) source, target, len, noderank);
             return;
         }
 
@@ -116,6 +199,45 @@ shmem_transport_cma_put(void *target, const void *source, size_t len,
 }
 
 
+/* Flush the batch queued on ctx for the given peer, or for all peers when
+ * noderank is -1. */
+static inline void
+shmem_transport_cma_quiet(shmem_ctx_t ctx, int noderank)
+{
+    if (0 == __atomic_load_n(&shmem_transport_cma_queues_pending, __ATOMIC_ACQUIRE))
+        return;
+
+    shmem_transport_cma_flush(ctx, noderank);
+}
+
+
+static inline void
+shmem_transport_cma_probe(void)
+{
+    if (0 == __atomic_load_n(&shmem_transport_cma_queues_pending, __ATOMIC_ACQUIRE))
+        return;
+
+    shmem_transport_cma_flush_all();
+}
+
+
+/* Put that may be queued until the next flush of ctx */
+static inline void
+shmem_transport_cma_put_batch(shmem_ctx_t ctx, void *target, const void *source,
+                              size_t len, int pe, int noderank)
+{
+    if (len <= shmem_internal_params.CMA_BATCH_PUT_MAX &&
+        shmem_transport_cma_peers[noderank] != shmem_transport_cma_my_pid) {
+        CHK_ACCESS(target,"cma_put target");
+        shmem_transport_cma_enqueue(ctx, target, source, len, noderank);
+    } else {
+        /* Preserve ordering with respect to earlier batched puts */
+        shmem_transport_cma_quiet(ctx, noderank);
+        shmem_transport_cma_put(target, source, len, pe, noderank);
+    }
+}
+
+
 static inline void
 shmem_transport_cma_get(void *target, const void *source, size_t len, int pe,
                         int noderank)
@@ -127,7 +249,12 @@ shmem_transport_cma_get(void *target, const void *source, size_t len, int pe,
         CHK_ACCESS(source,"cma_get source");
 
         if ( target_pid == shmem_transport_cma_my_pid ) {
-            memcpy(target, source, len);
+            shmem_internal_copy(target, source, len);
+            return;
+        }
+
+        if (shmem_transport_cma_use_large(len)) {
+            shmem_transport_cma_large(0, target, (void *) source, len, noderank);
             return;
         }
 
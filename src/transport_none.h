@@ -40,6 +40,7 @@ struct shmem_transport_ctx_t {
     struct shmem_internal_team_t *team;
 };
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
+typedef int shmem_transport_req_t;
 
 int shmem_transport_init(void);
 
@@ -162,6 +163,43 @@ shmem_transport_get_wait(shmem_transport_ctx_t* ctx)
     /* Nop */
 }
 
+static inline
+void
+shmem_transport_put_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source, size_t len,
+                        int pe, shmem_transport_req_t **req)
+{
+    RAISE_ERROR_STR("No path to peer");
+}
+
+static inline
+void
+shmem_transport_get_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source, size_t len,
+                        int pe, shmem_transport_req_t **req)
+{
+    RAISE_ERROR_STR("No path to peer");
+}
+
+static inline
+int
+shmem_transport_req_test(shmem_transport_req_t *req)
+{
+    return 1;
+}
+
+static inline
+void
+shmem_transport_req_wait(shmem_transport_req_t *req)
+{
+    /* Nop */
+}
+
+static inline
+void
+shmem_transport_req_free(shmem_transport_req_t *req)
+{
+    /* Nop */
+}
+
 
 static inline
 void
@@ -88,6 +88,13 @@ size_t                          shmem_transport_ofi_max_buffered_send;
 size_t                          shmem_transport_ofi_max_msg_size;
 size_t                          shmem_transport_ofi_bounce_buffer_size;
 long                            shmem_transport_ofi_max_bounce_buffers;
+size_t                          shmem_transport_ofi_agg_max_iov;
+int                             shmem_transport_ofi_mr_cache;
+static uint64_t                 shmem_transport_ofi_mr_cache_key = 2;
+int                             shmem_transport_ofi_nrails = 1;
+size_t                          shmem_transport_ofi_stripe_min;
+shmem_transport_ofi_rail_t      *shmem_transport_ofi_rails = NULL;
+static char                     *shmem_transport_ofi_domain_list = NULL;
 size_t                          shmem_transport_ofi_addrlen;
 #ifdef ENABLE_MR_RMA_EVENT
 int                             shmem_transport_ofi_mr_rma_event;
@@ -715,6 +722,32 @@ int allocate_recv_cntr_mr(void)
     return ret;
 }
 
+/* Local registrations for the MR cache, called under the cache lock.  Keys 0
+ * and 1 are used by the data and heap segments and are ignored when the
+ * provider selects keys. */
+static
+int shmem_transport_ofi_mr_cache_reg(void *addr, size_t len, void **handle, void **desc)
+{
+    struct fid_mr *mr;
+    int ret;
+
+    ret = fi_mr_reg(shmem_transport_ofi_domainfd, addr, len, FI_READ | FI_WRITE,
+                    0, shmem_transport_ofi_mr_cache_key++, 0, &mr, NULL);
+    if (ret) return ret;
+
+    *handle = mr;
+    *desc   = fi_mr_desc(mr);
+
+    return 0;
+}
+
+static
+void shmem_transport_ofi_mr_cache_dereg(void *handle)
+{
+    int ret = fi_close(&((struct fid_mr *) handle)->fid);
+    OFI_CHECK_ERROR_MSG(ret, "Cached MR close failed (%s)\n", fi_strerror(errno));
+}
+
 static
 int publish_mr_info(void)
 {
@@ -1256,6 +1289,13 @@ int query_for_fabric(struct fabric_info *info)
 
     shmem_internal_assertp(info->p_info->tx_attr->inject_size >= shmem_transport_ofi_max_buffered_send);
     shmem_transport_ofi_max_buffered_send = info->p_info->tx_attr->inject_size;
+
+    /* Aggregated messages may target several remote segments when the
+     * provider supports it */
+    shmem_transport_ofi_agg_max_iov = MIN(info->p_info->tx_attr->rma_iov_limit,
+                                          SHMEM_TRANSPORT_OFI_AGG_MAX_IOV);
+    if (shmem_transport_ofi_agg_max_iov == 0)
+        shmem_transport_ofi_agg_max_iov = 1;
 #ifdef ENABLE_MR_RMA_EVENT
     shmem_transport_ofi_mr_rma_event = (info->p_info->domain_attr->mr_mode & FI_MR_RMA_EVENT) != 0;
 #endif
@@ -1316,6 +1356,471 @@ static int shmem_transport_ofi_target_ep_init(void)
     return 0;
 }
 
+/* Split a comma-separated SHMEM_OFI_DOMAIN into the primary domain and the
+ * domains of the additional rails */
+static
+int parse_rail_domains(struct fabric_info *info, const char *domains)
+{
+    char *saveptr = NULL, *name;
+    int i;
+
+    shmem_transport_ofi_domain_list = strdup(domains);
+    if (shmem_transport_ofi_domain_list == NULL) {
+        RAISE_WARN_STR("Out of memory when parsing OFI domain list");
+        return 1;
+    }
+
+    shmem_transport_ofi_nrails = 1;
+    for (i = 0; domains[i] != '\0'; i++)
+        if (domains[i] == ',') shmem_transport_ofi_nrails++;
+
+    shmem_transport_ofi_rails = calloc(shmem_transport_ofi_nrails,
+                                       sizeof(shmem_transport_ofi_rail_t));
+    if (shmem_transport_ofi_rails == NULL) {
+        RAISE_WARN_STR("Out of memory when allocating OFI rail table");
+        return 1;
+    }
+
+    i = 0;
+    for (name = strtok_r(shmem_transport_ofi_domain_list, ",", &saveptr); name != NULL;
+         name = strtok_r(NULL, ",", &saveptr))
+        shmem_transport_ofi_rails[i++].domain_name = name;
+
+    if (i != shmem_transport_ofi_nrails) {
+        RAISE_WARN_MSG("Empty entry in OFI domain list '%s'\n", domains);
+        return 1;
+    }
+
+    info->domain_name = shmem_transport_ofi_rails[0].domain_name;
+
+    return 0;
+}
+
+/* Open the fabric, domain, and AV of each additional rail.  Rails use the
+ * primary rail's provider and memory registration mode. */
+static
+int allocate_rail_resources(struct fabric_info *info)
+{
+    int ret = 0;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_t *rail = &shmem_transport_ofi_rails[i];
+        struct fi_av_attr av_attr = {0};
+        struct fi_info *cur_fabric;
+
+        for (cur_fabric = info->fabrics; cur_fabric; cur_fabric = cur_fabric->next) {
+            if (strcmp(cur_fabric->fabric_attr->prov_name,
+                       info->p_info->fabric_attr->prov_name) == 0 &&
+                cur_fabric->domain_attr->mr_mode == info->p_info->domain_attr->mr_mode &&
+                (info->fabric_name == NULL ||
+                 fnmatch(info->fabric_name, cur_fabric->fabric_attr->name, 0) == 0) &&
+                fnmatch(rail->domain_name, cur_fabric->domain_attr->name, 0) == 0)
+                break;
+        }
+
+        if (cur_fabric == NULL) {
+            RAISE_WARN_MSG("OFI transport, no valid fabric for rail %d (prov=%s, domain=%s)\n",
+                           i, info->p_info->fabric_attr->prov_name, rail->domain_name);
+            return 1;
+        }
+
+        rail->info = fi_dupinfo(cur_fabric);
+        if (rail->info == NULL) {
+            RAISE_WARN_STR("Out of memory when copying OFI rail info");
+            return 1;
+        }
+        rail->info->domain_attr->mr_key_size = info->p_info->domain_attr->mr_key_size;
+
+        /* Fragments must fit on every rail */
+        if (rail->info->ep_attr->max_msg_size > 0)
+            shmem_transport_ofi_max_msg_size = MIN(shmem_transport_ofi_max_msg_size,
+                                                   rail->info->ep_attr->max_msg_size);
+
+        ret = fi_fabric(rail->info->fabric_attr, &rail->fabfd, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail %d fabric initialization failed\n", i);
+
+        ret = fi_domain(rail->fabfd, rail->info, &rail->domainfd, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail %d domain initialization failed\n", i);
+
+#ifdef USE_AV_MAP
+        av_attr.type     = FI_AV_MAP;
+        rail->addr_table = (fi_addr_t*) malloc(info->npes * sizeof(fi_addr_t));
+        if (rail->addr_table == NULL) {
+            RAISE_WARN_STR("Out of memory when allocating OFI rail address table");
+            return 1;
+        }
+#else
+        av_attr.type     = FI_AV_TABLE;
+        rail->addr_table = NULL;
+#endif
+
+        ret = fi_av_open(rail->domainfd, &av_attr, &rail->avfd, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail %d AV creation failed\n", i);
+
+        DEBUG_MSG("OFI rail %d: fabric: %s, domain: %s\n", i,
+                  rail->info->fabric_attr->name, rail->info->domain_attr->name);
+    }
+
+    return ret;
+}
+
+/* Target endpoint, counter, and memory registrations of an additional rail,
+ * set up as for the primary rail */
+static
+int rail_target_ep_init(shmem_transport_ofi_rail_t *rail)
+{
+    int ret = 0;
+    uint64_t flags = 0;
+    struct fi_cq_attr cq_attr = {0};
+
+    rail->info->ep_attr->tx_ctx_cnt = 0;
+    rail->info->caps = FI_RMA | FI_REMOTE_READ | FI_REMOTE_WRITE;
+#if ENABLE_TARGET_CNTR
+    rail->info->caps |= FI_RMA_EVENT;
+#endif
+    rail->info->tx_attr->op_flags = 0;
+    rail->info->mode = 0;
+    rail->info->tx_attr->mode = 0;
+    rail->info->rx_attr->mode = 0;
+
+    ret = fi_endpoint(rail->domainfd, rail->info, &rail->target_ep, NULL);
+    OFI_CHECK_RETURN_MSG(ret, "rail target endpoint creation failed (%s)\n", fi_strerror(errno));
+
+    ret = fi_ep_bind(rail->target_ep, &rail->avfd->fid, 0);
+    OFI_CHECK_RETURN_STR(ret, "fi_ep_bind AV to rail target endpoint failed");
+
+#if ENABLE_TARGET_CNTR
+    {
+        struct fi_cntr_attr cntr_attr = {0};
+
+        cntr_attr.events   = FI_CNTR_EVENTS_COMP;
+        cntr_attr.wait_obj = FI_WAIT_UNSPEC;
+
+        ret = fi_cntr_open(rail->domainfd, &cntr_attr, &rail->target_cntrfd, NULL);
+        OFI_CHECK_RETURN_STR(ret, "rail target CNTR open failed");
+
+#ifdef ENABLE_MR_RMA_EVENT
+        if (shmem_transport_ofi_mr_rma_event)
+            flags |= FI_RMA_EVENT;
+#endif /* ENABLE_MR_RMA_EVENT */
+    }
+#endif
+
+#if defined(ENABLE_MR_SCALABLE) && defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING)
+    ret = fi_mr_reg(rail->domainfd, 0, UINT64_MAX,
+                    FI_REMOTE_READ | FI_REMOTE_WRITE, 0, 0ULL, flags,
+                    &rail->target_mrfd, NULL);
+    OFI_CHECK_RETURN_STR(ret, "rail target memory (all) registration failed");
+
+#if ENABLE_TARGET_CNTR
+    ret = fi_mr_bind(rail->target_mrfd, &rail->target_cntrfd->fid, FI_REMOTE_WRITE);
+    OFI_CHECK_RETURN_STR(ret, "rail target CNTR binding to MR failed");
+
+#ifdef ENABLE_MR_RMA_EVENT
+    if (shmem_transport_ofi_mr_rma_event) {
+        ret = fi_mr_enable(rail->target_mrfd);
+        OFI_CHECK_RETURN_STR(ret, "rail target MR enable failed");
+    }
+#endif /* ENABLE_MR_RMA_EVENT */
+#endif /* ENABLE_TARGET_CNTR */
+
+#else
+    ret = fi_mr_reg(rail->domainfd, shmem_internal_heap_base,
+                    shmem_internal_heap_length,
+                    FI_REMOTE_READ | FI_REMOTE_WRITE, 0, 1ULL, flags,
+                    &rail->target_heap_mrfd, NULL);
+    OFI_CHECK_RETURN_STR(ret, "rail target memory (heap) registration failed");
+
+    ret = fi_mr_reg(rail->domainfd, shmem_internal_data_base,
+                    shmem_internal_data_length,
+                    FI_REMOTE_READ | FI_REMOTE_WRITE, 0, 0ULL, flags,
+                    &rail->target_data_mrfd, NULL);
+    OFI_CHECK_RETURN_STR(ret, "rail target memory (data) registration failed");
+
+#if ENABLE_TARGET_CNTR
+    ret = fi_mr_bind(rail->target_heap_mrfd, &rail->target_cntrfd->fid, FI_REMOTE_WRITE);
+    OFI_CHECK_RETURN_STR(ret, "rail target CNTR binding to heap MR failed");
+
+    ret = fi_mr_bind(rail->target_data_mrfd, &rail->target_cntrfd->fid, FI_REMOTE_WRITE);
+    OFI_CHECK_RETURN_STR(ret, "rail target CNTR binding to data MR failed");
+
+#ifdef ENABLE_MR_RMA_EVENT
+    if (shmem_transport_ofi_mr_rma_event) {
+        ret = fi_mr_enable(rail->target_data_mrfd);
+        OFI_CHECK_RETURN_STR(ret, "rail target data MR enable failed");
+
+        ret = fi_mr_enable(rail->target_heap_mrfd);
+        OFI_CHECK_RETURN_STR(ret, "rail target heap MR enable failed");
+    }
+#endif /* ENABLE_MR_RMA_EVENT */
+#endif /* ENABLE_TARGET_CNTR */
+#endif
+
+    ret = fi_cq_open(rail->domainfd, &cq_attr, &rail->target_cq, NULL);
+    OFI_CHECK_RETURN_MSG(ret, "rail cq_open failed (%s)\n", fi_strerror(errno));
+
+    ret = fi_ep_bind(rail->target_ep, &rail->target_cq->fid, FI_RECV);
+    OFI_CHECK_RETURN_STR(ret, "fi_ep_bind CQ to rail target endpoint failed");
+
+    ret = fi_enable(rail->target_ep);
+    OFI_CHECK_RETURN_STR(ret, "fi_enable on rail target endpoint failed");
+
+    return 0;
+}
+
+/* Publish the endpoint name and memory keys of each additional rail */
+static
+int publish_rail_info(void)
+{
+    int ret = 0;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_t *rail = &shmem_transport_ofi_rails[i];
+        char   key[32];
+        char   epname[128];
+        size_t epnamelen = sizeof(epname);
+
+        ret = fi_getname((fid_t)rail->target_ep, epname, &epnamelen);
+        if (ret != 0 || epnamelen != shmem_transport_ofi_addrlen) {
+            RAISE_WARN_MSG("fi_getname failed on rail %d\n", i);
+            return 1;
+        }
+
+        snprintf(key, sizeof(key), "fi_epname_r%d", i);
+        ret = shmem_runtime_put(key, epname, epnamelen);
+        OFI_CHECK_RETURN_MSG(ret, "shmem_runtime_put %s failed\n", key);
+
+#ifndef ENABLE_MR_SCALABLE
+        uint64_t heap_key, data_key;
+
+        if (rail->info->domain_attr->mr_mode & FI_MR_PROV_KEY) {
+            heap_key = fi_mr_key(rail->target_heap_mrfd);
+            data_key = fi_mr_key(rail->target_data_mrfd);
+        } else {
+            heap_key = 1ULL;
+            data_key = 0ULL;
+        }
+
+        snprintf(key, sizeof(key), "fi_heap_key_r%d", i);
+        ret = shmem_runtime_put(key, &heap_key, sizeof(uint64_t));
+        OFI_CHECK_RETURN_MSG(ret, "shmem_runtime_put %s failed\n", key);
+
+        snprintf(key, sizeof(key), "fi_data_key_r%d", i);
+        ret = shmem_runtime_put(key, &data_key, sizeof(uint64_t));
+        OFI_CHECK_RETURN_MSG(ret, "shmem_runtime_put %s failed\n", key);
+#endif /* !ENABLE_MR_SCALABLE */
+    }
+
+    return ret;
+}
+
+/* Fill in the address vector and key tables of each additional rail */
+static
+int populate_rails(void)
+{
+    int ret;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_t *rail = &shmem_transport_ofi_rails[i];
+        char key[32];
+        char *alladdrs;
+
+        alladdrs = malloc(shmem_internal_num_pes * shmem_transport_ofi_addrlen);
+        if (alladdrs == NULL) {
+            RAISE_WARN_STR("Out of memory allocating rail 'alladdrs'");
+            return 1;
+        }
+
+        snprintf(key, sizeof(key), "fi_epname_r%d", i);
+        for (int pe = 0; pe < shmem_internal_num_pes; pe++) {
+            ret = shmem_runtime_get(pe, key, alladdrs + pe * shmem_transport_ofi_addrlen,
+                                    shmem_transport_ofi_addrlen);
+            if (ret != 0) {
+                RAISE_ERROR_MSG("Runtime get of '%s' failed\n", key);
+            }
+        }
+
+        ret = fi_av_insert(rail->avfd, alladdrs, shmem_internal_num_pes,
+                           rail->addr_table, 0, NULL);
+        if (ret != shmem_internal_num_pes) {
+            RAISE_WARN_MSG("av insert failed on rail %d\n", i);
+            return ret;
+        }
+
+        free(alladdrs);
+
+#ifndef ENABLE_MR_SCALABLE
+        rail->target_heap_keys = malloc(sizeof(uint64_t) * shmem_internal_num_pes);
+        rail->target_data_keys = malloc(sizeof(uint64_t) * shmem_internal_num_pes);
+        if (rail->target_heap_keys == NULL || rail->target_data_keys == NULL) {
+            RAISE_WARN_STR("Out of memory allocating rail keytable");
+            return 1;
+        }
+
+        for (int pe = 0; pe < shmem_internal_num_pes; pe++) {
+            snprintf(key, sizeof(key), "fi_heap_key_r%d", i);
+            ret = shmem_runtime_get(pe, key, &rail->target_heap_keys[pe], sizeof(uint64_t));
+            if (ret) {
+                RAISE_WARN_MSG("Get of '%s' from runtime KVS failed\n", key);
+                return 1;
+            }
+            snprintf(key, sizeof(key), "fi_data_key_r%d", i);
+            ret = shmem_runtime_get(pe, key, &rail->target_data_keys[pe], sizeof(uint64_t));
+            if (ret) {
+                RAISE_WARN_MSG("Get of '%s' from runtime KVS failed\n", key);
+                return 1;
+            }
+        }
+#endif /* !ENABLE_MR_SCALABLE */
+    }
+
+    return 0;
+}
+
+/* Open the context's endpoints on the additional rails.  They carry only
+ * puts and gets, and each uses its own transmit context. */
+static
+int shmem_transport_ofi_ctx_rails_init(shmem_transport_ctx_t *ctx,
+                                       struct fi_cntr_attr *cntr_put_attr,
+                                       struct fi_cntr_attr *cntr_get_attr,
+                                       struct fi_cq_attr *cq_attr)
+{
+    int ret = 0;
+
+    ctx->rails = calloc(shmem_transport_ofi_nrails, sizeof(shmem_transport_ofi_rail_ep_t));
+    if (ctx->rails == NULL)
+        RAISE_ERROR_STR("Out of memory when allocating OFI rail endpoints");
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_t *rail = &shmem_transport_ofi_rails[i];
+        shmem_transport_ofi_rail_ep_t *rail_ep = &ctx->rails[i];
+
+#ifndef USE_CTX_LOCK
+        shmem_internal_cntr_write(&rail_ep->pending_put_cntr, 0);
+        shmem_internal_cntr_write(&rail_ep->pending_get_cntr, 0);
+#endif
+
+        rail->info->ep_attr->tx_ctx_cnt = 0;
+        rail->info->caps = FI_RMA | FI_WRITE | FI_READ;
+        rail->info->tx_attr->op_flags = FI_DELIVERY_COMPLETE;
+        rail->info->mode = 0;
+        rail->info->tx_attr->mode = 0;
+        rail->info->rx_attr->mode = 0;
+
+        ret = fi_cntr_open(rail->domainfd, cntr_put_attr, &rail_ep->put_cntr, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail put_cntr creation failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_cntr_open(rail->domainfd, cntr_get_attr, &rail_ep->get_cntr, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail get_cntr creation failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_cq_open(rail->domainfd, cq_attr, &rail_ep->cq, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail cq_open failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_endpoint(rail->domainfd, rail->info, &rail_ep->ep, NULL);
+        OFI_CHECK_RETURN_MSG(ret, "rail ep creation failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_ep_bind(rail_ep->ep, &rail_ep->put_cntr->fid, FI_WRITE);
+        OFI_CHECK_RETURN_STR(ret, "fi_ep_bind put CNTR to rail endpoint failed");
+
+        ret = fi_ep_bind(rail_ep->ep, &rail_ep->get_cntr->fid, FI_READ);
+        OFI_CHECK_RETURN_STR(ret, "fi_ep_bind get CNTR to rail endpoint failed");
+
+        /* Only errors are reported on the CQ */
+        ret = fi_ep_bind(rail_ep->ep, &rail_ep->cq->fid,
+                         FI_SELECTIVE_COMPLETION | FI_TRANSMIT | FI_RECV);
+        OFI_CHECK_RETURN_STR(ret, "fi_ep_bind CQ to rail endpoint failed");
+
+        ret = fi_ep_bind(rail_ep->ep, &rail->avfd->fid, 0);
+        OFI_CHECK_RETURN_STR(ret, "fi_ep_bind AV to rail endpoint failed");
+
+        ret = fi_enable(rail_ep->ep);
+        OFI_CHECK_RETURN_STR(ret, "fi_enable on rail endpoint failed");
+    }
+
+    return ret;
+}
+
+static
+void shmem_transport_ofi_ctx_rails_fini(shmem_transport_ctx_t *ctx)
+{
+    int ret;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_ep_t *rail_ep = &ctx->rails[i];
+
+        if (rail_ep->ep) {
+            ret = fi_close(&rail_ep->ep->fid);
+            OFI_CHECK_ERROR_MSG(ret, "Context rail endpoint close failed (%s)\n", fi_strerror(errno));
+        }
+        if (rail_ep->put_cntr) {
+            ret = fi_close(&rail_ep->put_cntr->fid);
+            OFI_CHECK_ERROR_MSG(ret, "Context rail put CNTR close failed (%s)\n", fi_strerror(errno));
+        }
+        if (rail_ep->get_cntr) {
+            ret = fi_close(&rail_ep->get_cntr->fid);
+            OFI_CHECK_ERROR_MSG(ret, "Context rail get CNTR close failed (%s)\n", fi_strerror(errno));
+        }
+        if (rail_ep->cq) {
+            ret = fi_close(&rail_ep->cq->fid);
+            OFI_CHECK_ERROR_MSG(ret, "Context rail CQ close failed (%s)\n", fi_strerror(errno));
+        }
+    }
+
+    free(ctx->rails);
+    ctx->rails = NULL;
+}
+
+static
+void rails_fini(void)
+{
+    int ret;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_t *rail = &shmem_transport_ofi_rails[i];
+
+        ret = fi_close(&rail->target_ep->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail target endpoint close failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_close(&rail->target_cq->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail target CQ close failed (%s)\n", fi_strerror(errno));
+
+#if defined(ENABLE_MR_SCALABLE) && defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING)
+        ret = fi_close(&rail->target_mrfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail target MR close failed (%s)\n", fi_strerror(errno));
+#else
+        ret = fi_close(&rail->target_heap_mrfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail target heap MR close failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_close(&rail->target_data_mrfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail target data MR close failed (%s)\n", fi_strerror(errno));
+#endif
+
+#if ENABLE_TARGET_CNTR
+        ret = fi_close(&rail->target_cntrfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail target CT close failed (%s)\n", fi_strerror(errno));
+#endif
+
+        ret = fi_close(&rail->avfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail AV close failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_close(&rail->domainfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail domain close failed (%s)\n", fi_strerror(errno));
+
+        ret = fi_close(&rail->fabfd->fid);
+        OFI_CHECK_ERROR_MSG(ret, "Rail fabric close failed (%s)\n", fi_strerror(errno));
+
+#ifndef ENABLE_MR_SCALABLE
+        free(rail->target_heap_keys);
+        free(rail->target_data_keys);
+#endif
+        free(rail->addr_table);
+        fi_freeinfo(rail->info);
+    }
+
+    free(shmem_transport_ofi_rails);
+    free(shmem_transport_ofi_domain_list);
+}
+
 static int shmem_transport_ofi_ctx_init(shmem_transport_ctx_t *ctx, int id)
 {
     int ret = 0;
@@ -1387,7 +1892,12 @@ static int shmem_transport_ofi_ctx_init(shmem_transport_ctx_t *ctx, int id)
     ret = bind_enable_ep_resources(ctx);
     OFI_CHECK_RETURN_MSG(ret, "context bind/enable endpoint failed (%s)\n", fi_strerror(errno));
 
-    if (ctx->options & SHMEMX_CTX_BOUNCE_BUFFER &&
+    if (shmem_transport_ofi_nrails > 1) {
+        ret = shmem_transport_ofi_ctx_rails_init(ctx, &cntr_put_attr, &cntr_get_attr, &cq_attr);
+        if (ret != 0) return ret;
+    }
+
+    if (ctx->options & (SHMEMX_CTX_BOUNCE_BUFFER | SHMEMX_CTX_AGGREGATE) &&
         shmem_transport_ofi_bounce_buffer_size > 0 &&
         shmem_transport_ofi_max_bounce_buffers > 0)
     {
@@ -1397,10 +1907,29 @@ static int shmem_transport_ofi_ctx_init(shmem_transport_ctx_t *ctx, int id)
                                  init_bounce_buffer);
     }
     else {
-        ctx->options &= ~SHMEMX_CTX_BOUNCE_BUFFER;
+        ctx->options &= ~(SHMEMX_CTX_BOUNCE_BUFFER | SHMEMX_CTX_AGGREGATE);
         ctx->bounce_buffers = NULL;
     }
 
+#ifndef USE_CTX_LOCK
+    /* Batches are protected by the context lock; without it, only contexts
+     * used by a single thread at a time can aggregate */
+    if (ctx->options & SHMEMX_CTX_AGGREGATE &&
+        shmem_internal_thread_level == SHMEM_THREAD_MULTIPLE &&
+        !(ctx->options & (SHMEM_CTX_PRIVATE | SHMEM_CTX_SERIALIZED))) {
+        DEBUG_STR("Aggregation requires a private or serialized context; disabling");
+        ctx->options &= ~SHMEMX_CTX_AGGREGATE;
+    }
+#endif
+
+    if (ctx->options & SHMEMX_CTX_AGGREGATE) {
+        ctx->agg = calloc(shmem_internal_num_pes, sizeof(shmem_transport_ofi_agg_t *));
+        ctx->agg_dirty = malloc(shmem_internal_num_pes * sizeof(int));
+        if (ctx->agg == NULL || ctx->agg_dirty == NULL)
+            RAISE_ERROR_STR("Out of memory when allocating OFI aggregation state");
+        ctx->agg_ndirty = 0;
+    }
+
     return 0;
 }
 
@@ -1425,11 +1954,19 @@ int shmem_transport_init(void)
     else
         shmem_transport_ofi_info.fabric_name = NULL;
 
-    if (shmem_internal_params.OFI_DOMAIN_provided)
-        shmem_transport_ofi_info.domain_name = shmem_internal_params.OFI_DOMAIN;
-    else
+    if (shmem_internal_params.OFI_DOMAIN_provided) {
+        if (strchr(shmem_internal_params.OFI_DOMAIN, ',') != NULL) {
+            ret = parse_rail_domains(&shmem_transport_ofi_info,
+                                     shmem_internal_params.OFI_DOMAIN);
+            if (ret != 0) return ret;
+        } else {
+            shmem_transport_ofi_info.domain_name = shmem_internal_params.OFI_DOMAIN;
+        }
+    } else
         shmem_transport_ofi_info.domain_name = NULL;
 
+    shmem_transport_ofi_stripe_min = shmem_internal_params.OFI_STRIPE_MIN;
+
     /* Check STX resource settings */
     if ((shmem_internal_thread_level == SHMEM_THREAD_SINGLE ||
          shmem_internal_thread_level == SHMEM_THREAD_FUNNELED ) &&
@@ -1455,6 +1992,9 @@ int shmem_transport_init(void)
     ret = allocate_fabric_resources(&shmem_transport_ofi_info);
     if (ret != 0) return ret;
 
+    ret = allocate_rail_resources(&shmem_transport_ofi_info);
+    if (ret != 0) return ret;
+
     /* STX sharing settings */
     char *type = shmem_internal_params.OFI_STX_ALLOCATOR;
     if (0 == strcmp(type, "round-robin")) {
@@ -1504,9 +2044,30 @@ int shmem_transport_init(void)
     ret = publish_mr_info();
     if (ret != 0) return ret;
 
+    /* Endpoint-bound registrations would have to be bound to every context
+     * that uses them */
+    if (shmem_internal_params.OFI_MR_CACHE) {
+        if (shmem_transport_ofi_info.p_info->domain_attr->mr_mode & FI_MR_ENDPOINT) {
+            RAISE_WARN_STR("OFI provider uses FI_MR_ENDPOINT, disabling the MR cache");
+        } else {
+            shmem_transport_ofi_mr_cache =
+                !shmem_internal_mr_cache_init(shmem_internal_params.OFI_MR_CACHE_SIZE,
+                                              shmem_transport_ofi_mr_cache_reg,
+                                              shmem_transport_ofi_mr_cache_dereg);
+        }
+    }
+
     ret = publish_av_info(&shmem_transport_ofi_info);
     if (ret != 0) return ret;
 
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        ret = rail_target_ep_init(&shmem_transport_ofi_rails[i]);
+        if (ret != 0) return ret;
+    }
+
+    ret = publish_rail_info();
+    if (ret != 0) return ret;
+
     return 0;
 }
 
@@ -1575,6 +2136,7 @@ int shmem_transport_startup(void)
     }
 
     shmem_transport_ctx_default.team = &shmem_internal_team_world;
+    shmem_transport_ctx_default.pool_slot = -1;
 
     ret = shmem_transport_ofi_ctx_init(&shmem_transport_ctx_default, SHMEM_TRANSPORT_CTX_DEFAULT_ID);
     if (ret != 0) return ret;
@@ -1588,9 +2150,48 @@ int shmem_transport_startup(void)
     ret = populate_av();
     if (ret != 0) return ret;
 
+    ret = populate_rails();
+    if (ret != 0) return ret;
+
     return 0;
 }
 
+static inline
+void shmem_transport_ofi_ctx_pool_push(struct shmem_internal_team_t *team,
+                                       shmem_transport_ctx_t *ctx)
+{
+    uint64_t head, next;
+
+    head = __atomic_load_n(&team->ctx_pool_head, __ATOMIC_ACQUIRE);
+    do {
+        __atomic_store_n(&ctx->pool_next, (int) (head & 0xffffffffu) - 1, __ATOMIC_RELAXED);
+        next = (((head >> 32) + 1) << 32) | (uint64_t) (ctx->pool_slot + 1);
+    } while (!__atomic_compare_exchange_n(&team->ctx_pool_head, &head, next, 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+static inline
+shmem_transport_ctx_t *shmem_transport_ofi_ctx_pool_pop(struct shmem_internal_team_t *team)
+{
+    shmem_transport_ctx_t *ctx;
+    uint64_t head, next;
+
+    head = __atomic_load_n(&team->ctx_pool_head, __ATOMIC_ACQUIRE);
+    do {
+        if ((head & 0xffffffffu) == 0)
+            return NULL;
+
+        /* Pooled contexts are not freed while the team exists, and the tag
+         * rejects a stale link if the top was popped and pushed meanwhile */
+        ctx = team->ctx_pool[(head & 0xffffffffu) - 1];
+        next = (((head >> 32) + 1) << 32) |
+               (uint64_t) (__atomic_load_n(&ctx->pool_next, __ATOMIC_RELAXED) + 1);
+    } while (!__atomic_compare_exchange_n(&team->ctx_pool_head, &head, next, 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return ctx;
+}
+
 int shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options, shmem_transport_ctx_t **ctx)
 {
     int ret;
@@ -1599,6 +2200,21 @@ int shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options,
     if (team == NULL)
         RAISE_ERROR_STR("Context creation occured on a NULL team");
 
+    /* Reuse a pooled context without taking the transport lock.  Private
+     * contexts are bound to their creating thread and are never pooled. */
+    if (!shmem_transport_ofi_is_private(options)) {
+        shmem_transport_ctx_t *pooled = shmem_transport_ofi_ctx_pool_pop(team);
+
+        if (pooled != NULL) {
+            if (pooled->options == options) {
+                pooled->pooled = 0;
+                *ctx = pooled;
+                return 0;
+            }
+            shmem_transport_ofi_ctx_pool_push(team, pooled);
+        }
+    }
+
     SHMEM_MUTEX_LOCK(shmem_transport_ofi_lock);
 
     /* Look for an open slot in the contexts array */
@@ -1636,6 +2252,7 @@ int shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options,
 
     ctxp->stx_idx = -1;
     ctxp->options = options;
+    ctxp->pool_slot = -1;
 
     ctxp->team = team;
 
@@ -1645,6 +2262,22 @@ int shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options,
         shmem_transport_ctx_destroy(ctxp);
     } else {
         team->contexts[id] = ctxp;
+
+        /* Give shareable contexts a pool slot, so they are retained on
+         * destroy, until the team's pool is full */
+        if (!shmem_transport_ofi_is_private(options) &&
+            shmem_internal_params.OFI_CTX_POOL_SIZE > 0 &&
+            team->ctx_pool_len < (size_t) shmem_internal_params.OFI_CTX_POOL_SIZE) {
+            if (team->ctx_pool == NULL) {
+                team->ctx_pool = malloc(shmem_internal_params.OFI_CTX_POOL_SIZE *
+                                        sizeof(shmem_transport_ctx_t*));
+                if (team->ctx_pool == NULL)
+                    RAISE_ERROR_STR("Out of memory when allocating OFI ctx pool");
+            }
+            ctxp->pool_slot = team->ctx_pool_len++;
+            team->ctx_pool[ctxp->pool_slot] = ctxp;
+        }
+
         *ctx = ctxp;
     }
 
@@ -1660,13 +2293,24 @@ void shmem_transport_ctx_destroy(shmem_transport_ctx_t *ctx)
     if (ctx == NULL)
         return;
 
+    /* Return pooled contexts to their team.  The caller has already quieted
+     * the context, so it is ready for immediate reuse. */
+    if (ctx->id >= 0 && ctx->pool_slot >= 0 && !ctx->pooled &&
+        ctx->team->ctx_pool != NULL) {
+        ctx->pooled = 1;
+        shmem_transport_ofi_ctx_pool_push(ctx->team, ctx);
+        return;
+    }
+
     if(shmem_internal_params.DEBUG) {
         SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
         if (ctx->bounce_buffers) SHMEM_TRANSPORT_OFI_CTX_BB_LOCK(ctx);
         DEBUG_MSG("id = %d, options = %#0lx, stx_idx = %d\n"
                   RAISE_PE_PREFIX "pending_put_cntr = %9"PRIu64", completed_put_cntr = %9"PRIu64"\n"
                   RAISE_PE_PREFIX "pending_get_cntr = %9"PRIu64", completed_get_cntr = %9"PRIu64"\n"
-                  RAISE_PE_PREFIX "pending_bb_cntr  = %9"PRIu64", completed_bb_cntr  = %9"PRIu64"\n",
+                  RAISE_PE_PREFIX "pending_bb_cntr  = %9"PRIu64", completed_bb_cntr  = %9"PRIu64"\n"
+                  RAISE_PE_PREFIX "put_waits = %9"PRIu64", blocked = %9"PRIu64", est_ns = %9"PRIu64"\n"
+                  RAISE_PE_PREFIX "get_waits = %9"PRIu64", blocked = %9"PRIu64", est_ns = %9"PRIu64"\n",
                   ctx->id, (unsigned long) ctx->options, ctx->stx_idx,
                   shmem_internal_my_pe,
                   SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_put_cntr),
@@ -1675,7 +2319,13 @@ void shmem_transport_ctx_destroy(shmem_transport_ctx_t *ctx)
                   SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_get_cntr),
                   ctx->get_cntr ? fi_cntr_read(ctx->get_cntr) : 0,
                   shmem_internal_my_pe,
-                  ctx->pending_bb_cntr, ctx->completed_bb_cntr
+                  ctx->pending_bb_cntr, ctx->completed_bb_cntr,
+                  shmem_internal_my_pe,
+                  ctx->put_wait_stats.nwaits, ctx->put_wait_stats.nblocks,
+                  ctx->put_wait_stats.est_ns,
+                  shmem_internal_my_pe,
+                  ctx->get_wait_stats.nwaits, ctx->get_wait_stats.nblocks,
+                  ctx->get_wait_stats.est_ns
                  );
         if (ctx->bounce_buffers) SHMEM_TRANSPORT_OFI_CTX_BB_UNLOCK(ctx);
         SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
@@ -1686,6 +2336,18 @@ void shmem_transport_ctx_destroy(shmem_transport_ctx_t *ctx)
         OFI_CHECK_ERROR_MSG(ret, "Context endpoint close failed (%s)\n", fi_strerror(errno));
     }
 
+    if (ctx->rails) {
+        shmem_transport_ofi_ctx_rails_fini(ctx);
+    }
+
+    if (ctx->agg) {
+        /* The caller has quieted the context, so no batch is open */
+        for (int i = 0; i < shmem_internal_num_pes; i++)
+            free(ctx->agg[i]);
+        free(ctx->agg);
+        free(ctx->agg_dirty);
+    }
+
     if (ctx->bounce_buffers) {
         shmem_free_list_destroy(ctx->bounce_buffers);
     }
@@ -1786,6 +2448,11 @@ int shmem_transport_fini(void)
     ret = fi_close(&shmem_transport_ofi_target_cq->fid);
     OFI_CHECK_ERROR_MSG(ret, "Target CQ close failed (%s)\n", fi_strerror(errno));
 
+    if (shmem_transport_ofi_mr_cache)
+        shmem_internal_mr_cache_fini();
+
+    rails_fini();
+
 #if defined(ENABLE_MR_SCALABLE) && defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING)
     ret = fi_close(&shmem_transport_ofi_target_mrfd->fid);
     OFI_CHECK_ERROR_MSG(ret, "Target MR close failed (%s)\n", fi_strerror(errno));
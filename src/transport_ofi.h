@@ -31,6 +31,8 @@
 #include "shmem_internal.h"
 #include "shmem_atomic.h"
 #include "shmem_team.h"
+#include "shmem_wait.h"
+#include "shmem_mr_cache.h"
 #include <sys/types.h>
 
 
@@ -61,8 +63,12 @@ extern long                             shmem_transport_ofi_put_poll_limit;
 extern long                             shmem_transport_ofi_get_poll_limit;
 extern size_t                           shmem_transport_ofi_max_buffered_send;
 extern size_t                           shmem_transport_ofi_max_msg_size;
+extern int                              shmem_transport_ofi_mr_cache;
 extern size_t                           shmem_transport_ofi_bounce_buffer_size;
 extern long                             shmem_transport_ofi_max_bounce_buffers;
+extern size_t                           shmem_transport_ofi_agg_max_iov;
+extern int                              shmem_transport_ofi_nrails;
+extern size_t                           shmem_transport_ofi_stripe_min;
 
 extern pthread_mutex_t                  shmem_transport_ofi_progress_lock;
 
@@ -186,6 +192,24 @@ void shmem_transport_ofi_get_mr(const void *addr, int dest_pe,
 }
 #endif
 
+/* Descriptor for a local buffer, from the MR cache.  Symmetric buffers are
+ * covered by the target MRs, which are not registered for local access, and
+ * are used without a descriptor. */
+static inline
+void *shmem_transport_ofi_get_local_desc(const void *addr, size_t len)
+{
+    if (!shmem_transport_ofi_mr_cache)
+        return NULL;
+
+    if (((void*) addr >= shmem_internal_data_base &&
+         (uint8_t*) addr < (uint8_t*) shmem_internal_data_base + shmem_internal_data_length) ||
+        ((void*) addr >= shmem_internal_heap_base &&
+         (uint8_t*) addr < (uint8_t*) shmem_internal_heap_base + shmem_internal_heap_length))
+        return NULL;
+
+    return shmem_internal_mr_cache_lookup(addr, len);
+}
+
 /* Datatypes */
 extern int shmem_transport_dtype_table[];
 
@@ -204,6 +228,7 @@ typedef enum fi_op       shm_internal_op_t;
 
 #define SHMEM_TRANSPORT_OFI_TYPE_BOUNCE 0x01
 #define SHMEM_TRANSPORT_OFI_TYPE_LONG   0x02
+#define SHMEM_TRANSPORT_OFI_TYPE_REQ    0x03
 
 
 extern fi_addr_t *addr_table;
@@ -214,6 +239,46 @@ extern fi_addr_t *addr_table;
 #define GET_DEST(dest) ((fi_addr_t)(dest))
 #endif
 
+/* Additional rail: another domain (typically another NIC) of the primary
+ * provider, with its own target endpoint and memory registrations.  Rail 0 is
+ * the primary domain described by the shmem_transport_ofi_* globals, so entry
+ * 0 of the rail table is unused.  Rails share the primary's addressing mode,
+ * so remote addresses are the same on every rail and only the keys differ. */
+struct shmem_transport_ofi_rail_t {
+    char                           *domain_name;
+    struct fi_info                 *info;
+    struct fid_fabric              *fabfd;
+    struct fid_domain              *domainfd;
+    struct fid_av                  *avfd;
+    struct fid_ep                  *target_ep;
+    struct fid_cq                  *target_cq;
+#if ENABLE_TARGET_CNTR
+    struct fid_cntr                *target_cntrfd;
+#endif
+#if defined(ENABLE_MR_SCALABLE) && defined(ENABLE_REMOTE_VIRTUAL_ADDRESSING)
+    struct fid_mr                  *target_mrfd;
+#else
+    struct fid_mr                  *target_heap_mrfd;
+    struct fid_mr                  *target_data_mrfd;
+#endif
+#ifndef ENABLE_MR_SCALABLE
+    uint64_t                       *target_heap_keys;
+    uint64_t                       *target_data_keys;
+#endif
+    fi_addr_t                      *addr_table;
+};
+
+typedef struct shmem_transport_ofi_rail_t shmem_transport_ofi_rail_t;
+
+extern shmem_transport_ofi_rail_t *shmem_transport_ofi_rails;
+
+#ifdef USE_AV_MAP
+#define GET_RAIL_DEST(rail, dest)                                               \
+    ((rail) == 0 ? GET_DEST(dest) : shmem_transport_ofi_rails[(rail)].addr_table[(dest)])
+#else
+#define GET_RAIL_DEST(rail, dest) ((fi_addr_t)(dest))
+#endif
+
 
 struct shmem_transport_ofi_frag_t {
     shmem_free_list_item_t item;
@@ -229,6 +294,57 @@ struct shmem_transport_ofi_bounce_buffer_t {
 
 typedef struct shmem_transport_ofi_bounce_buffer_t shmem_transport_ofi_bounce_buffer_t;
 
+/* Handle for request-based RMA.  Its address is the operation context of
+ * every fragment of the transfer, so each CQ event retires one fragment. */
+struct shmem_transport_req_t {
+    shmem_transport_ofi_frag_t      frag;
+    struct shmem_transport_ctx_t   *ctx;
+    uint64_t                        pending;
+};
+
+typedef struct shmem_transport_req_t shmem_transport_req_t;
+
+/* Upper bound on the number of remote segments in one aggregated message; the
+ * provider's rma_iov_limit may lower it further */
+#define SHMEM_TRANSPORT_OFI_AGG_MAX_IOV 16
+
+/* Batch op value used for aggregated puts */
+#define SHMEM_TRANSPORT_OFI_AGG_PUT     (-1)
+
+/* Per-peer batch of small puts or non-fetching atomics on an aggregating
+ * context.  Payloads are packed into a bounce buffer, and each entry of rma_iov
+ * describes one contiguous run of the target. */
+struct shmem_transport_ofi_agg_t {
+    shmem_transport_ofi_bounce_buffer_t *buff;
+    size_t                               len;
+    size_t                               max_len;
+    int                                  op;
+    int                                  dt;
+    int                                  dirty;
+    size_t                               niov;
+    struct fi_rma_iov                    rma_iov[];
+};
+
+typedef struct shmem_transport_ofi_agg_t shmem_transport_ofi_agg_t;
+
+/* A context's endpoint on an additional rail.  Only puts and gets are issued
+ * here, so completions are tracked by counters alone. */
+struct shmem_transport_ofi_rail_ep_t {
+    struct fid_ep*                  ep;
+    struct fid_cntr*                put_cntr;
+    struct fid_cntr*                get_cntr;
+    struct fid_cq*                  cq;
+#ifdef USE_CTX_LOCK
+    uint64_t                        pending_put_cntr;
+    uint64_t                        pending_get_cntr;
+#else
+    shmem_internal_cntr_t           pending_put_cntr;
+    shmem_internal_cntr_t           pending_get_cntr;
+#endif
+};
+
+typedef struct shmem_transport_ofi_rail_ep_t shmem_transport_ofi_rail_ep_t;
+
 typedef int shmem_transport_ct_t;
 
 enum shmem_internal_tid_t { tid_is_pid_t, tid_is_uint64_t };
@@ -267,6 +383,22 @@ struct shmem_transport_ctx_t {
     int                             stx_idx;
     struct shmem_internal_tid       tid;
     struct shmem_internal_team_t   *team;
+    /* Slot in the team's context pool (-1 if none) and link to the next
+     * pooled context while this context sits in the pool */
+    int                             pool_slot;
+    int                             pool_next;
+    int                             pooled;
+    /* Per-peer batches (NULL unless SHMEMX_CTX_AGGREGATE is active) and the
+     * list of peers holding an open batch */
+    shmem_transport_ofi_agg_t     **agg;
+    int                            *agg_dirty;
+    int                             agg_ndirty;
+    /* Completion wait statistics used by SHMEM_WAIT_ADAPTIVE */
+    shmem_internal_wait_stats_t     put_wait_stats;
+    shmem_internal_wait_stats_t     get_wait_stats;
+    /* Endpoints on the additional rails, indexed by rail (NULL with a single
+     * rail) */
+    shmem_transport_ofi_rail_ep_t  *rails;
 };
 
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
@@ -321,6 +453,11 @@ void shmem_transport_probe(void)
         int ret = fi_cq_read(shmem_transport_ofi_target_cq, &buf, 1);
         if (ret == 1)
             RAISE_WARN_STR("Unexpected event");
+        for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+            ret = fi_cq_read(shmem_transport_ofi_rails[i].target_cq, &buf, 1);
+            if (ret == 1)
+                RAISE_WARN_STR("Unexpected event");
+        }
 #  ifdef USE_THREAD_COMPLETION
         pthread_mutex_unlock(&shmem_transport_ofi_progress_lock);
     }
@@ -330,6 +467,102 @@ void shmem_transport_probe(void)
     return;
 }
 
+/* Select the rail of the first fragment of a put or get and the fragment
+ * size.  Transfers of at least SHMEM_OFI_STRIPE_MIN bytes are split evenly
+ * across the rails, starting from the target PE's rail; smaller transfers
+ * use the target PE's rail only.  Returns nonzero when the transfer is
+ * striped. */
+static inline
+int shmem_transport_ofi_rail_select(int pe, size_t len, int *rail, size_t *frag_max)
+{
+    int nrails = shmem_transport_ofi_nrails;
+
+    *rail     = pe % nrails;
+    *frag_max = shmem_transport_ofi_max_msg_size;
+
+    if (nrails == 1 || len < shmem_transport_ofi_stripe_min)
+        return 0;
+
+    *frag_max = MIN(*frag_max, (len + nrails - 1) / nrails);
+
+    return 1;
+}
+
+/* Key of a symmetric address on the given rail.  Scalable registrations use
+ * the same requested keys on every rail. */
+static inline
+uint64_t shmem_transport_ofi_rail_key(const void *addr, int pe, int rail, uint64_t key)
+{
+#ifndef ENABLE_MR_SCALABLE
+    if (rail > 0) {
+        if ((void*) addr >= shmem_internal_data_base &&
+            (uint8_t*) addr < (uint8_t*) shmem_internal_data_base + shmem_internal_data_length)
+            return shmem_transport_ofi_rails[rail].target_data_keys[pe];
+        else
+            return shmem_transport_ofi_rails[rail].target_heap_keys[pe];
+    }
+#endif
+    return key;
+}
+
+/* Wait for the puts (or gets) issued on the additional rails to complete.
+ * The caller must hold the context lock. */
+static inline
+void shmem_transport_ofi_rails_wait(shmem_transport_ctx_t *ctx, int get)
+{
+    long poll_limit = get ? shmem_transport_ofi_get_poll_limit :
+                            shmem_transport_ofi_put_poll_limit;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_ep_t *rail = &ctx->rails[i];
+        struct fid_cntr *cntr = get ? rail->get_cntr : rail->put_cntr;
+        uint64_t cnt = get ? SHMEM_TRANSPORT_OFI_CNTR_READ(&rail->pending_get_cntr) :
+                             SHMEM_TRANSPORT_OFI_CNTR_READ(&rail->pending_put_cntr);
+        long poll_count = 0;
+
+        while (fi_cntr_read(cntr) < cnt) {
+            uint64_t fail = fi_cntr_readerr(cntr);
+
+            if (fail) {
+                RAISE_ERROR_MSG("Operations completed in error on rail %d (%" PRIu64 ")\n",
+                                i, fail);
+            }
+            else if (poll_limit >= 0 && poll_count >= poll_limit) {
+                int ret = fi_cntr_wait(cntr, cnt, -1);
+                OFI_CHECK_ERROR(ret);
+                break;
+            }
+
+            shmem_transport_probe();
+            SPINLOCK_BODY();
+            poll_count++;
+        }
+    }
+}
+
+/* Sum of the issued (or completed) puts or gets on the additional rails, for
+ * the performance counters.  The caller must hold the context lock. */
+static inline
+uint64_t shmem_transport_ofi_rails_cntr(shmem_transport_ctx_t *ctx, int get, int completed)
+{
+    uint64_t cnt = 0;
+
+    if (ctx->rails == NULL)
+        return 0;
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++) {
+        shmem_transport_ofi_rail_ep_t *rail = &ctx->rails[i];
+
+        if (completed)
+            cnt += fi_cntr_read(get ? rail->get_cntr : rail->put_cntr);
+        else
+            cnt += get ? SHMEM_TRANSPORT_OFI_CNTR_READ(&rail->pending_get_cntr) :
+                         SHMEM_TRANSPORT_OFI_CNTR_READ(&rail->pending_put_cntr);
+    }
+
+    return cnt;
+}
+
 int shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options, shmem_transport_ctx_t **ctx);
 void shmem_transport_ctx_destroy(shmem_transport_ctx_t *ctx);
 
@@ -340,9 +573,10 @@ int shmem_transport_fini(void);
 extern size_t SHMEM_Dtsize[FI_DATATYPE_LAST];
 
 static inline void shmem_transport_get_wait(shmem_transport_ctx_t* ctx);
+static inline void shmem_transport_ofi_agg_flush(shmem_transport_ctx_t *ctx);
 
 /* Drain all available events from the CQ.  Note, ctx->bounce_buffers must be
- * locked before calling this routine */
+ * locked before calling this routine, if the context has bounce buffers */
 static inline
 void shmem_transport_ofi_drain_cq(shmem_transport_ctx_t *ctx)
 {
@@ -362,6 +596,9 @@ void shmem_transport_ofi_drain_cq(shmem_transport_ctx_t *ctx)
                 shmem_free_list_free(ctx->bounce_buffers,
                                      (shmem_transport_ofi_bounce_buffer_t *) frag);
                 ctx->completed_bb_cntr++;
+            } else if (SHMEM_TRANSPORT_OFI_TYPE_REQ == frag->mytype) {
+                __atomic_fetch_sub(&((shmem_transport_req_t *) frag)->pending, 1,
+                                   __ATOMIC_RELEASE);
             } else {
                 RAISE_ERROR_STR("Unrecognized completion object");
             }
@@ -412,6 +649,9 @@ void shmem_transport_put_quiet(shmem_transport_ctx_t* ctx)
 {
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
 
+    if (ctx->agg)
+        shmem_transport_ofi_agg_flush(ctx);
+
     /* Wait for bounce buffered operations to complete */
     if (ctx->bounce_buffers) {
         SHMEM_TRANSPORT_OFI_CTX_BB_LOCK(ctx);
@@ -423,6 +663,9 @@ void shmem_transport_put_quiet(shmem_transport_ctx_t* ctx)
         SHMEM_TRANSPORT_OFI_CTX_BB_UNLOCK(ctx);
     }
 
+    if (ctx->rails)
+        shmem_transport_ofi_rails_wait(ctx, 0);
+
     /* wait for put counter to meet outstanding count value */
 
     /* Note: the communication routines increment pending put counters before
@@ -433,7 +676,12 @@ void shmem_transport_put_quiet(shmem_transport_ctx_t* ctx)
      */
     uint64_t success, fail, cnt, cnt_new;
     long poll_count = 0;
-    while (poll_count < shmem_transport_ofi_put_poll_limit ||
+    /* Adaptive waiting replaces the polling limit when blocking is allowed */
+    int adaptive = shmem_internal_wait_adaptive &&
+                   shmem_transport_ofi_put_poll_limit >= 0;
+    shmem_internal_wait_t wait = SHMEM_INTERNAL_WAIT_INITIALIZER(&ctx->put_wait_stats);
+
+    while (adaptive || poll_count < shmem_transport_ofi_put_poll_limit ||
            shmem_transport_ofi_put_poll_limit < 0) {
         success = fi_cntr_read(ctx->put_cntr);
         fail = fi_cntr_readerr(ctx->put_cntr);
@@ -442,12 +690,18 @@ void shmem_transport_put_quiet(shmem_transport_ctx_t* ctx)
         shmem_transport_probe();
 
         if (success < cnt && fail == 0) {
+            int spin = 1;
             SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
-            SPINLOCK_BODY();
+            if (adaptive)
+                spin = shmem_internal_wait_spin(&wait);
+            else
+                SPINLOCK_BODY();
             SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+            if (!spin) break;
         } else if (fail) {
             RAISE_ERROR_MSG("Operations completed in error (%" PRIu64 ")\n", fail);
         } else {
+            if (adaptive) shmem_internal_wait_end(&wait, 0);
             SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
             return;
         }
@@ -461,6 +715,7 @@ void shmem_transport_put_quiet(shmem_transport_ctx_t* ctx)
         OFI_CTX_CHECK_ERROR(ctx, ret);
     } while (cnt < cnt_new);
     shmem_internal_assert(cnt == cnt_new);
+    if (adaptive) shmem_internal_wait_end(&wait, 1);
 
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
 }
@@ -479,10 +734,23 @@ int shmem_transport_quiet(shmem_transport_ctx_t* ctx)
 static inline
 int shmem_transport_fence(shmem_transport_ctx_t* ctx)
 {
+    if (ctx->agg) {
+        SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+        shmem_transport_ofi_agg_flush(ctx);
+        SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+    }
+
 #if WANT_TOTAL_DATA_ORDERING == 0
     /* Communication is unordered; must wait for puts and buffered (injected)
      * non-fetching atomics to be completed in order to ensure ordering. */
     shmem_transport_put_quiet(ctx);
+#else
+    /* Rails are not ordered with respect to each other */
+    if (ctx->rails) {
+        SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+        shmem_transport_ofi_rails_wait(ctx, 0);
+        SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+    }
 #endif
     /* Complete fetching ops; needed to support nonblocking fetch-atomics */
     shmem_transport_get_wait(ctx);
@@ -499,22 +767,15 @@ int try_again(shmem_transport_ctx_t *ctx, const int ret, uint64_t *polled) {
 
     if (ret) {
         if (ret == -FI_EAGAIN) {
+            /* Reclaim bounce buffers and retire requests; this also pokes
+             * the CQ for errors to encourage progress */
             if (ctx->bounce_buffers) {
                 SHMEM_TRANSPORT_OFI_CTX_BB_LOCK(ctx);
                 shmem_transport_ofi_drain_cq(ctx);
                 SHMEM_TRANSPORT_OFI_CTX_BB_UNLOCK(ctx);
             }
             else {
-                /* Poke CQ for errors to encourage progress */
-                struct fi_cq_err_entry e = {0};
-                ssize_t ret = fi_cq_readerr(ctx->cq, (void *)&e, 0);
-                if (ret == 1) {
-                    const char *errmsg = fi_cq_strerror(ctx->cq, e.prov_errno,
-                                                        e.err_data, NULL, 0);
-                    RAISE_ERROR_MSG("Error in operation: %s\n", errmsg);
-                } else if (ret && ret != -FI_EAGAIN) {
-                    RAISE_ERROR_MSG("Error reading from CQ (%zd)\n", ret);
-                }
+                shmem_transport_ofi_drain_cq(ctx);
             }
 
             shmem_transport_probe();
@@ -538,6 +799,163 @@ int try_again(shmem_transport_ctx_t *ctx, const int ret, uint64_t *polled) {
 }
 
 
+/* Issue the open batch for the given peer as a single message.  The caller
+ * must hold the context lock. */
+static inline
+void shmem_transport_ofi_agg_flush_pe(shmem_transport_ctx_t *ctx, int pe)
+{
+    shmem_transport_ofi_agg_t *agg = ctx->agg[pe];
+    uint64_t dst = (uint64_t) pe;
+    uint64_t polled = 0;
+    int ret = 0;
+
+    if (agg == NULL || agg->buff == NULL)
+        return;
+
+    SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
+
+    if (agg->op == SHMEM_TRANSPORT_OFI_AGG_PUT) {
+        const struct iovec      msg_iov = { .iov_base = agg->buff->data, .iov_len = agg->len };
+        const struct fi_msg_rma msg     = {
+                                            .msg_iov       = &msg_iov,
+                                            .desc          = NULL,
+                                            .iov_count     = 1,
+                                            .addr          = GET_DEST(dst),
+                                            .rma_iov       = agg->rma_iov,
+                                            .rma_iov_count = agg->niov,
+                                            .context       = agg->buff,
+                                            .data          = 0
+                                          };
+        do {
+            ret = fi_writemsg(ctx->ep, &msg, FI_COMPLETION | FI_DELIVERY_COMPLETE);
+        } while (try_again(ctx, ret, &polled));
+    } else {
+        struct fi_rma_ioc rma_ioc[SHMEM_TRANSPORT_OFI_AGG_MAX_IOV];
+        size_t dtsize = SHMEM_Dtsize[agg->dt];
+
+        for (size_t i = 0; i < agg->niov; i++) {
+            rma_ioc[i].addr  = agg->rma_iov[i].addr;
+            rma_ioc[i].count = agg->rma_iov[i].len / dtsize;
+            rma_ioc[i].key   = agg->rma_iov[i].key;
+        }
+
+        const struct fi_ioc        msg_iov = { .addr = agg->buff->data, .count = agg->len / dtsize };
+        const struct fi_msg_atomic msg     = {
+                                               .msg_iov       = &msg_iov,
+                                               .desc          = NULL,
+                                               .iov_count     = 1,
+                                               .addr          = GET_DEST(dst),
+                                               .rma_iov       = rma_ioc,
+                                               .rma_iov_count = agg->niov,
+                                               .datatype      = agg->dt,
+                                               .op            = agg->op,
+                                               .context       = agg->buff,
+                                               .data          = 0
+                                             };
+        do {
+            ret = fi_atomicmsg(ctx->ep, &msg, FI_COMPLETION | FI_DELIVERY_COMPLETE);
+        } while (try_again(ctx, ret, &polled));
+    }
+
+    agg->buff = NULL;
+}
+
+/* Issue the open batches for all peers.  The caller must hold the context
+ * lock. */
+static inline
+void shmem_transport_ofi_agg_flush(shmem_transport_ctx_t *ctx)
+{
+    for (int i = 0; i < ctx->agg_ndirty; i++) {
+        shmem_transport_ofi_agg_flush_pe(ctx, ctx->agg_dirty[i]);
+        ctx->agg[ctx->agg_dirty[i]]->dirty = 0;
+    }
+
+    ctx->agg_ndirty = 0;
+}
+
+/* Operations that are not aggregated must not pass a batched operation to
+ * the same peer. */
+#define SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe)                                   do {                                                                                if ((ctx)->agg && (ctx)->agg[pe] && (ctx)->agg[pe]->buff)                           shmem_transport_ofi_agg_flush_pe(ctx, pe);                              } while (0)
+
+/* Add a put (op is SHMEM_TRANSPORT_OFI_AGG_PUT) or a non-fetching atomic to
+ * the peer's batch.  Returns 0, leaving the operation to the caller, when it
+ * cannot be batched.  The caller must hold the context lock. */
+static inline
+int shmem_transport_ofi_agg_append(shmem_transport_ctx_t *ctx, uint8_t *addr,
+                                   uint64_t key, const void *source, size_t len,
+                                   int pe, int op, int dt)
+{
+    shmem_transport_ofi_agg_t *agg = ctx->agg[pe];
+
+    if (agg == NULL) {
+        agg = malloc(sizeof(shmem_transport_ofi_agg_t) +
+                     shmem_transport_ofi_agg_max_iov * sizeof(struct fi_rma_iov));
+        if (agg == NULL)
+            RAISE_ERROR_STR("Out of memory when allocating OFI aggregation buffer");
+        agg->buff  = NULL;
+        agg->dirty = 0;
+        ctx->agg[pe] = agg;
+    }
+
+    if (agg->buff) {
+        struct fi_rma_iov *last = &agg->rma_iov[agg->niov - 1];
+
+        if (agg->op == op && agg->dt == dt && agg->len + len <= agg->max_len) {
+            if (last->addr + last->len == (uint64_t) addr && last->key == key) {
+                memcpy(agg->buff->data + agg->len, source, len);
+                agg->len  += len;
+                last->len += len;
+                return 1;
+            } else if (agg->niov < shmem_transport_ofi_agg_max_iov) {
+                memcpy(agg->buff->data + agg->len, source, len);
+                agg->len += len;
+                agg->rma_iov[agg->niov].addr = (uint64_t) addr;
+                agg->rma_iov[agg->niov].len  = len;
+                agg->rma_iov[agg->niov].key  = key;
+                agg->niov++;
+                return 1;
+            }
+        }
+
+        /* The batch cannot take this operation; issue it and start anew */
+        shmem_transport_ofi_agg_flush_pe(ctx, pe);
+    }
+
+    agg->max_len = shmem_transport_ofi_bounce_buffer_size;
+
+    if (op != SHMEM_TRANSPORT_OFI_AGG_PUT) {
+        size_t max_count = 0;
+        int ret = fi_atomicvalid(ctx->ep, dt, op, &max_count);
+
+        if (ret || max_count == 0)
+            return 0;
+        agg->max_len = MIN(agg->max_len, max_count * SHMEM_Dtsize[dt]);
+    }
+
+    if (len > agg->max_len)
+        return 0;
+
+    /* Open batches hold bounce buffers that only complete once issued */
+    if (ctx->bounce_buffers->nalloc >= (uint64_t) shmem_transport_ofi_max_bounce_buffers)
+        shmem_transport_ofi_agg_flush(ctx);
+
+    if (!agg->dirty) {
+        ctx->agg_dirty[ctx->agg_ndirty++] = pe;
+        agg->dirty = 1;
+    }
+
+    agg->buff = create_bounce_buffer(ctx, source, len);
+    agg->len  = len;
+    agg->op   = op;
+    agg->dt   = dt;
+    agg->niov = 1;
+    agg->rma_iov[0].addr = (uint64_t) addr;
+    agg->rma_iov[0].len  = len;
+    agg->rma_iov[0].key  = key;
+
+    return 1;
+}
+
 static inline
 void shmem_transport_put_scalar(shmem_transport_ctx_t* ctx, void *target, const
                                void *source, size_t len, int pe)
@@ -553,6 +971,13 @@ void shmem_transport_put_scalar(shmem_transport_ctx_t* ctx, void *target, const
     shmem_internal_assert(len <= shmem_transport_ofi_max_buffered_send);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+
+    if (ctx->agg && shmem_transport_ofi_agg_append(ctx, addr, key, source, len, pe,
+                                                   SHMEM_TRANSPORT_OFI_AGG_PUT, 0)) {
+        SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+        return;
+    }
+
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
 
     do {
@@ -583,26 +1008,46 @@ void shmem_transport_ofi_put_large(shmem_transport_ctx_t* ctx, void *target, con
     uint8_t *frag_source = (uint8_t *) source;
     uint64_t frag_target = (uint64_t) addr;
     size_t frag_len = len;
+    size_t frag_max;
+    int rail;
+    int stripe = shmem_transport_ofi_rail_select(pe, len, &rail, &frag_max);
+    /* Cached registrations belong to the primary rail's domain */
+    void *desc = shmem_transport_ofi_get_local_desc(source, len);
 
     /* operation generates counting events and must be completed by
      * quiet. */
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     while (frag_source < ((uint8_t *) source) + len) {
-        frag_len = MIN(shmem_transport_ofi_max_msg_size,
+        frag_len = MIN(frag_max,
                        (size_t) (((uint8_t *) source) + len - frag_source));
         polled = 0;
 
-        SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
+        if (rail == 0) {
+            SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
 
-        do {
-            ret = fi_write(ctx->ep,
-                           frag_source, frag_len, NULL,
-                           GET_DEST(dst), frag_target,
-                           key, NULL);
-        } while (try_again(ctx, ret, &polled));
+            do {
+                ret = fi_write(ctx->ep,
+                               frag_source, frag_len, desc,
+                               GET_DEST(dst), frag_target,
+                               key, NULL);
+            } while (try_again(ctx, ret, &polled));
+        } else {
+            SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->rails[rail].pending_put_cntr);
+
+            do {
+                ret = fi_write(ctx->rails[rail].ep,
+                               frag_source, frag_len, NULL,
+                               GET_RAIL_DEST(rail, dst), frag_target,
+                               shmem_transport_ofi_rail_key(target, pe, rail, key),
+                               NULL);
+            } while (try_again(ctx, ret, &polled));
+        }
 
         frag_source += frag_len;
         frag_target += frag_len;
+        if (stripe)
+            rail = (rail + 1) % shmem_transport_ofi_nrails;
     }
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
 }
@@ -626,6 +1071,7 @@ void shmem_transport_put_nb(shmem_transport_ctx_t* ctx, void *target, const void
     } else if (len <= shmem_transport_ofi_bounce_buffer_size && ctx->bounce_buffers) {
 
         SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+        SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
         SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
         shmem_transport_ofi_get_mr(target, pe, &addr, &key);
 
@@ -672,6 +1118,7 @@ void shmem_transport_put_signal_nbi(shmem_transport_ctx_t* ctx, void *target, co
         uint8_t *src_buf = (uint8_t *) source;
 
         SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+        SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
         SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
 
         const struct iovec msg_iov = {
@@ -725,6 +1172,7 @@ void shmem_transport_put_signal_nbi(shmem_transport_ctx_t* ctx, void *target, co
                                 };
 
         SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+        SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
         while (frag_source < (((uint8_t *) source) + len)) {
             frag_len = MIN(shmem_transport_ofi_max_msg_size, 
                           (size_t) (((uint8_t *) source) + len - frag_source));
@@ -768,6 +1216,7 @@ void shmem_transport_put_signal_nbi(shmem_transport_ctx_t* ctx, void *target, co
     int atomic_op = (sig_op == SHMEM_SIGNAL_ADD) ? FI_SUM : FI_ATOMIC_WRITE;
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
 
     const struct fi_ioc msg_iov_signal = {
@@ -837,15 +1286,24 @@ void shmem_transport_get(shmem_transport_ctx_t* ctx, void *target, const void *s
 
     shmem_transport_ofi_get_mr(source, pe, &addr, &key);
 
+    /* Small gets do not amortize a registration */
+    void *desc = (len > shmem_transport_ofi_bounce_buffer_size) ?
+        shmem_transport_ofi_get_local_desc(target, len) : NULL;
+
+    size_t frag_max;
+    int rail;
+    int stripe = shmem_transport_ofi_rail_select(pe, len, &rail, &frag_max);
+
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
-    if (len <= shmem_transport_ofi_max_msg_size) {
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
+    if (len <= frag_max && rail == 0) {
 
         SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
         do {
             ret = fi_read(ctx->ep,
                           target,
                           len,
-                          NULL,
+                          desc,
                           GET_DEST(dst),
                           (uint64_t) addr,
                           key,
@@ -858,21 +1316,35 @@ void shmem_transport_get(shmem_transport_ctx_t* ctx, void *target, const void *s
         size_t frag_len = len;
 
         while (frag_target < ((uint8_t *) target) + len) {
-            frag_len = MIN(shmem_transport_ofi_max_msg_size,
+            frag_len = MIN(frag_max,
                            (size_t) (((uint8_t *) target) + len - frag_target));
             polled = 0;
 
-            SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
+            if (rail == 0) {
+                SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
 
-            do {
-                ret = fi_read(ctx->ep,
-                              frag_target, frag_len, NULL,
-                              GET_DEST(dst), frag_source,
-                              key, NULL);
-            } while (try_again(ctx, ret, &polled));
+                do {
+                    ret = fi_read(ctx->ep,
+                                  frag_target, frag_len, desc,
+                                  GET_DEST(dst), frag_source,
+                                  key, NULL);
+                } while (try_again(ctx, ret, &polled));
+            } else {
+                SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->rails[rail].pending_get_cntr);
+
+                do {
+                    ret = fi_read(ctx->rails[rail].ep,
+                                  frag_target, frag_len, NULL,
+                                  GET_RAIL_DEST(rail, dst), frag_source,
+                                  shmem_transport_ofi_rail_key(source, pe, rail, key),
+                                  NULL);
+                } while (try_again(ctx, ret, &polled));
+            }
 
             frag_source += frag_len;
             frag_target += frag_len;
+            if (stripe)
+                rail = (rail + 1) % shmem_transport_ofi_nrails;
         }
     }
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
@@ -892,10 +1364,16 @@ void shmem_transport_get_wait(shmem_transport_ctx_t* ctx)
      */
     uint64_t success, fail, cnt, cnt_new;
     long poll_count = 0;
+    int adaptive = shmem_internal_wait_adaptive &&
+                   shmem_transport_ofi_get_poll_limit >= 0;
+    shmem_internal_wait_t wait = SHMEM_INTERNAL_WAIT_INITIALIZER(&ctx->get_wait_stats);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
 
-    while (poll_count < shmem_transport_ofi_get_poll_limit ||
+    if (ctx->rails)
+        shmem_transport_ofi_rails_wait(ctx, 1);
+
+    while (adaptive || poll_count < shmem_transport_ofi_get_poll_limit ||
            shmem_transport_ofi_get_poll_limit < 0) {
         success = fi_cntr_read(ctx->get_cntr);
         fail = fi_cntr_readerr(ctx->get_cntr);
@@ -904,12 +1382,18 @@ void shmem_transport_get_wait(shmem_transport_ctx_t* ctx)
         shmem_transport_probe();
 
         if (success < cnt && fail == 0) {
+            int spin = 1;
             SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
-            SPINLOCK_BODY();
+            if (adaptive)
+                spin = shmem_internal_wait_spin(&wait);
+            else
+                SPINLOCK_BODY();
             SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+            if (!spin) break;
         } else if (fail) {
             RAISE_ERROR_MSG("Operations completed in error (%" PRIu64 ")\n", fail);
         } else {
+            if (adaptive) shmem_internal_wait_end(&wait, 0);
             SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
             return;
         }
@@ -923,11 +1407,160 @@ void shmem_transport_get_wait(shmem_transport_ctx_t* ctx)
         OFI_CTX_CHECK_ERROR(ctx, ret);
     } while (cnt < cnt_new);
     shmem_internal_assert(cnt == cnt_new);
+    if (adaptive) shmem_internal_wait_end(&wait, 1);
 
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
 }
 
 
+static inline
+shmem_transport_req_t *shmem_transport_ofi_req_alloc(shmem_transport_ctx_t *ctx, size_t len,
+                                                     size_t max)
+{
+    shmem_transport_req_t *req = malloc(sizeof(shmem_transport_req_t));
+
+    if (req == NULL)
+        RAISE_ERROR_STR("Out of memory when allocating OFI RMA request");
+
+    req->frag.mytype = SHMEM_TRANSPORT_OFI_TYPE_REQ;
+    req->ctx = ctx;
+    /* One event per fragment.  max_msg_size may be SIZE_MAX, so len + max - 1
+     * would overflow. */
+    req->pending = len / max + (len % max != 0);
+
+    return req;
+}
+
+/* Put whose completion is reported on the CQ to the returned request, in
+ * addition to the put counter used by quiet. */
+static inline
+void shmem_transport_put_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source,
+                             size_t len, int pe, shmem_transport_req_t **reqp)
+{
+    int ret = 0;
+    uint64_t dst = (uint64_t) pe;
+    uint64_t polled;
+    uint64_t key;
+    uint8_t *addr;
+    size_t max = shmem_transport_ofi_max_msg_size;
+
+    shmem_transport_ofi_get_mr(target, pe, &addr, &key);
+
+    shmem_transport_req_t *req = shmem_transport_ofi_req_alloc(ctx, len, max);
+    void *desc = shmem_transport_ofi_get_local_desc(source, len);
+
+    SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
+
+    for (size_t off = 0; off < len; off += max) {
+        const struct iovec      msg_iov = { .iov_base = (uint8_t *) source + off,
+                                            .iov_len  = MIN(max, len - off) };
+        const struct fi_rma_iov rma_iov = { .addr = (uint64_t) addr + off,
+                                            .len  = msg_iov.iov_len, .key = key };
+        const struct fi_msg_rma msg     = {
+                                            .msg_iov       = &msg_iov,
+                                            .desc          = desc ? &desc : NULL,
+                                            .iov_count     = 1,
+                                            .addr          = GET_DEST(dst),
+                                            .rma_iov       = &rma_iov,
+                                            .rma_iov_count = 1,
+                                            .context       = req,
+                                            .data          = 0
+                                          };
+        polled = 0;
+        SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
+        do {
+            ret = fi_writemsg(ctx->ep, &msg, FI_COMPLETION | FI_DELIVERY_COMPLETE);
+        } while (try_again(ctx, ret, &polled));
+    }
+    SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+
+    *reqp = req;
+}
+
+static inline
+void shmem_transport_get_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source,
+                             size_t len, int pe, shmem_transport_req_t **reqp)
+{
+    int ret = 0;
+    uint64_t dst = (uint64_t) pe;
+    uint64_t polled;
+    uint64_t key;
+    uint8_t *addr;
+    size_t max = shmem_transport_ofi_max_msg_size;
+
+    shmem_transport_ofi_get_mr(source, pe, &addr, &key);
+
+    shmem_transport_req_t *req = shmem_transport_ofi_req_alloc(ctx, len, max);
+    void *desc = shmem_transport_ofi_get_local_desc(target, len);
+
+    SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
+
+    for (size_t off = 0; off < len; off += max) {
+        const struct iovec      msg_iov = { .iov_base = (uint8_t *) target + off,
+                                            .iov_len  = MIN(max, len - off) };
+        const struct fi_rma_iov rma_iov = { .addr = (uint64_t) addr + off,
+                                            .len  = msg_iov.iov_len, .key = key };
+        const struct fi_msg_rma msg     = {
+                                            .msg_iov       = &msg_iov,
+                                            .desc          = desc ? &desc : NULL,
+                                            .iov_count     = 1,
+                                            .addr          = GET_DEST(dst),
+                                            .rma_iov       = &rma_iov,
+                                            .rma_iov_count = 1,
+                                            .context       = req,
+                                            .data          = 0
+                                          };
+        polled = 0;
+        SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
+        do {
+            ret = fi_readmsg(ctx->ep, &msg, FI_COMPLETION);
+        } while (try_again(ctx, ret, &polled));
+    }
+    SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+
+    *reqp = req;
+}
+
+/* Returns nonzero once every fragment of the request has completed.  Only
+ * the CQ is polled; other operations on the context are not waited for. */
+static inline
+int shmem_transport_req_test(shmem_transport_req_t *req)
+{
+    shmem_transport_ctx_t *ctx = req->ctx;
+
+    if (__atomic_load_n(&req->pending, __ATOMIC_ACQUIRE) == 0)
+        return 1;
+
+    SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    if (ctx->bounce_buffers) {
+        SHMEM_TRANSPORT_OFI_CTX_BB_LOCK(ctx);
+        shmem_transport_ofi_drain_cq(ctx);
+        SHMEM_TRANSPORT_OFI_CTX_BB_UNLOCK(ctx);
+    } else {
+        shmem_transport_ofi_drain_cq(ctx);
+    }
+    SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+
+    return __atomic_load_n(&req->pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+static inline
+void shmem_transport_req_wait(shmem_transport_req_t *req)
+{
+    while (!shmem_transport_req_test(req)) {
+        shmem_transport_probe();
+        SPINLOCK_BODY();
+    }
+}
+
+static inline
+void shmem_transport_req_free(shmem_transport_req_t *req)
+{
+    free(req);
+}
+
 static inline
 void shmem_transport_cswap(shmem_transport_ctx_t* ctx, void *target, const void *source, void *dest,
                            const void *operand, size_t len, int pe, int datatype)
@@ -944,6 +1577,7 @@ void shmem_transport_cswap(shmem_transport_ctx_t* ctx, void *target, const void
     shmem_internal_assert(SHMEM_Dtsize[SHMEM_TRANSPORT_DTYPE(datatype)] == len);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
 
     do {
@@ -999,6 +1633,7 @@ void shmem_transport_cswap_nbi(shmem_transport_ctx_t* ctx, void *target, const
                                };
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
 
     do {
@@ -1033,6 +1668,7 @@ void shmem_transport_mswap(shmem_transport_ctx_t* ctx, void *target, const void
     shmem_internal_assert(SHMEM_Dtsize[SHMEM_TRANSPORT_DTYPE(datatype)] == len);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
 
     do {
@@ -1070,6 +1706,13 @@ void shmem_transport_atomic(shmem_transport_ctx_t* ctx, void *target, const void
     shmem_internal_assert(SHMEM_Dtsize[SHMEM_TRANSPORT_DTYPE(datatype)] == len);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+
+    if (ctx->agg && shmem_transport_ofi_agg_append(ctx, addr, key, source, len, pe,
+                                                   op, SHMEM_TRANSPORT_DTYPE(datatype))) {
+        SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
+        return;
+    }
+
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_put_cntr);
 
     do {
@@ -1103,6 +1746,7 @@ void shmem_transport_atomicv(shmem_transport_ctx_t* ctx, void *target, const voi
     shmem_internal_assert(SHMEM_Dtsize[dt] * len == full_len);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     ret = fi_atomicvalid(ctx->ep, dt, op,
                          &max_atomic_size);
     max_atomic_size = max_atomic_size * SHMEM_Dtsize[dt];
@@ -1209,6 +1853,7 @@ void shmem_transport_fetch_atomic(shmem_transport_ctx_t* ctx, void *target,
     shmem_internal_assert(SHMEM_Dtsize[SHMEM_TRANSPORT_DTYPE(datatype)] == len);
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
 
     do {
@@ -1264,6 +1909,7 @@ void shmem_transport_fetch_atomic_nbi(shmem_transport_ctx_t* ctx, void *target,
                                };
 
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
+    SHMEM_TRANSPORT_OFI_AGG_FLUSH_PE(ctx, pe);
     SHMEM_TRANSPORT_OFI_CNTR_INC(&ctx->pending_get_cntr);
 
     do {
@@ -1400,7 +2046,12 @@ uint64_t shmem_transport_received_cntr_get(void)
     shmem_internal_assert(shmem_internal_thread_level == SHMEM_THREAD_SINGLE);
     /* NOTE-MT: This is only reachable in single-threaded runs, otherwise
      * we would need a mutex to support FI_THREAD_COMPLETION builds. */
-    return fi_cntr_read(shmem_transport_ofi_target_cntrfd);
+    uint64_t cnt = fi_cntr_read(shmem_transport_ofi_target_cntrfd);
+
+    for (int i = 1; i < shmem_transport_ofi_nrails; i++)
+        cnt += fi_cntr_read(shmem_transport_ofi_rails[i].target_cntrfd);
+
+    return cnt;
 #else
     RAISE_ERROR_STR("OFI transport configured for hard polling");
     return 0;
@@ -1414,6 +2065,16 @@ void shmem_transport_received_cntr_wait(uint64_t ge_val)
     shmem_internal_assert(shmem_internal_thread_level == SHMEM_THREAD_SINGLE);
     /* NOTE-MT: This is only reachable in single-threaded runs, otherwise
      * we would need a mutex to support FI_THREAD_COMPLETION builds. */
+    if (shmem_transport_ofi_nrails > 1) {
+        /* Writes may arrive on any rail, so no single counter can be waited
+         * on */
+        while (shmem_transport_received_cntr_get() < ge_val) {
+            shmem_transport_probe();
+            SPINLOCK_BODY();
+        }
+        return;
+    }
+
     int ret = fi_cntr_wait(shmem_transport_ofi_target_cntrfd, ge_val, -1);
 
     OFI_CHECK_ERROR(ret);
@@ -1437,6 +2098,7 @@ uint64_t shmem_transport_pcntr_get_issued_write(shmem_transport_ctx_t *ctx)
     uint64_t cnt;
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
     cnt = SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_put_cntr);
+    cnt += shmem_transport_ofi_rails_cntr(ctx, 0, 0);
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
 
     if (ctx->options & SHMEMX_CTX_BOUNCE_BUFFER) {
@@ -1453,6 +2115,7 @@ uint64_t shmem_transport_pcntr_get_issued_read(shmem_transport_ctx_t *ctx)
     uint64_t cnt;
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
     cnt = SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_get_cntr);
+    cnt += shmem_transport_ofi_rails_cntr(ctx, 1, 0);
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
     return cnt;
 }
@@ -1463,6 +2126,7 @@ uint64_t shmem_transport_pcntr_get_completed_write(shmem_transport_ctx_t *ctx)
     uint64_t cnt;
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
     cnt = fi_cntr_read(ctx->put_cntr);
+    cnt += shmem_transport_ofi_rails_cntr(ctx, 0, 1);
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
 
     if (ctx->options & SHMEMX_CTX_BOUNCE_BUFFER) {
@@ -1479,6 +2143,7 @@ uint64_t shmem_transport_pcntr_get_completed_read(shmem_transport_ctx_t *ctx)
     uint64_t cnt;
     SHMEM_TRANSPORT_OFI_CTX_LOCK(ctx);
     cnt = fi_cntr_read(ctx->get_cntr);
+    cnt += shmem_transport_ofi_rails_cntr(ctx, 1, 1);
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
     return cnt;
 }
@@ -1492,6 +2157,8 @@ uint64_t shmem_transport_pcntr_get_completed_target(void)
     if (0 == pthread_mutex_lock(&shmem_transport_ofi_progress_lock)) {
 #  endif
         cnt = fi_cntr_read(shmem_transport_ofi_target_cntrfd);
+        for (int i = 1; i < shmem_transport_ofi_nrails; i++)
+            cnt += fi_cntr_read(shmem_transport_ofi_rails[i].target_cntrfd);
 #  ifdef USE_THREAD_COMPLETION
         pthread_mutex_unlock(&shmem_transport_ofi_progress_lock);
     }
@@ -1515,11 +2182,15 @@ void shmem_transport_pcntr_get_all(shmem_transport_ctx_t *ctx, shmemx_pcntr_t *p
         pcntr->pending_put = ctx->pending_bb_cntr;
         SHMEM_TRANSPORT_OFI_CTX_BB_UNLOCK(ctx);
     }
-    pcntr->completed_put += fi_cntr_read(ctx->put_cntr);
-    pcntr->completed_get = fi_cntr_read(ctx->get_cntr);
-
-    pcntr->pending_put += SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_put_cntr);
-    pcntr->pending_get = SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_get_cntr);
+    pcntr->completed_put += fi_cntr_read(ctx->put_cntr) +
+                            shmem_transport_ofi_rails_cntr(ctx, 0, 1);
+    pcntr->completed_get = fi_cntr_read(ctx->get_cntr) +
+                           shmem_transport_ofi_rails_cntr(ctx, 1, 1);
+
+    pcntr->pending_put += SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_put_cntr) +
+                          shmem_transport_ofi_rails_cntr(ctx, 0, 0);
+    pcntr->pending_get = SHMEM_TRANSPORT_OFI_CNTR_READ(&ctx->pending_get_cntr) +
+                         shmem_transport_ofi_rails_cntr(ctx, 1, 0);
 
     SHMEM_TRANSPORT_OFI_CTX_UNLOCK(ctx);
     pcntr->target = shmem_transport_pcntr_get_completed_target();
@@ -147,6 +147,12 @@ struct shmem_transport_ctx_t {
 
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
 extern shmem_transport_ctx_t shmem_transport_ctx_default;
+
+/* Request-based RMA is completed through a quiet on the issuing context */
+struct shmem_transport_req_t {
+    shmem_transport_ctx_t *ctx;
+};
+typedef struct shmem_transport_req_t shmem_transport_req_t;
 int shmem_transport_ctx_create(struct shmem_internal_team_t *team, long options, shmem_transport_ctx_t **ctx);
 void shmem_transport_ctx_destroy(shmem_transport_ctx_t *ctx);
 
@@ -715,6 +721,65 @@ shmem_transport_get_wait(shmem_transport_ctx_t* ctx)
 }
 
 
+static inline
+shmem_transport_req_t *
+shmem_transport_portals4_req_alloc(shmem_transport_ctx_t *ctx)
+{
+    shmem_transport_req_t *req = malloc(sizeof(shmem_transport_req_t));
+
+    if (req == NULL)
+        RAISE_ERROR_STR("Out of memory when allocating Portals RMA request");
+    req->ctx = ctx;
+
+    return req;
+}
+
+
+static inline
+void
+shmem_transport_put_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source, size_t len,
+                        int pe, shmem_transport_req_t **req)
+{
+    shmem_transport_put_nbi(ctx, target, source, len, pe);
+    *req = shmem_transport_portals4_req_alloc(ctx);
+}
+
+
+static inline
+void
+shmem_transport_get_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source, size_t len,
+                        int pe, shmem_transport_req_t **req)
+{
+    shmem_transport_get(ctx, target, source, len, pe);
+    *req = shmem_transport_portals4_req_alloc(ctx);
+}
+
+
+static inline
+int
+shmem_transport_req_test(shmem_transport_req_t *req)
+{
+    shmem_transport_quiet(req->ctx);
+    return 1;
+}
+
+
+static inline
+void
+shmem_transport_req_wait(shmem_transport_req_t *req)
+{
+    shmem_transport_quiet(req->ctx);
+}
+
+
+static inline
+void
+shmem_transport_req_free(shmem_transport_req_t *req)
+{
+    free(req);
+}
+
+
 static inline
 void
 shmem_transport_swap(shmem_transport_ctx_t* ctx, void *target, const void *source, void *dest, size_t len,
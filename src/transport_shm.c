@@ -0,0 +1,341 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#include "config.h"
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define SHMEM_INTERNAL_INCLUDE
+#include "shmem.h"
+#include "shmem_internal.h"
+#include "shmem_comm.h"
+#include "runtime.h"
+
+/* The shared memory transport backs the symmetric heap and the symmetric data
+ * segment with shareable memory segments (memfd_create or shm_open).  Peers
+ * on the same node attach to these segments through /proc/<pid>/fd/<fd>,
+ * which avoids leaving named segments behind if a job is killed.  Once all
+ * peers are mapped, puts, gets, and atomics are performed with regular loads
+ * and stores. */
+
+struct share_info_t {
+    pid_t  pid;
+    int    data_fd;
+    size_t data_len;
+    size_t data_off;
+    int    heap_fd;
+    size_t heap_len;
+    size_t heap_off;
+};
+
+struct shmem_transport_shm_peer_info_t *shmem_transport_shm_peers = NULL;
+static struct share_info_t my_info = { .data_fd = -1, .heap_fd = -1 };
+
+#define FIND_BASE(ptr, page_size) ((char*) (((uintptr_t) ptr / page_size) * page_size))
+#define FIND_LEN(ptr, len, page_size) ((((char*) ptr - FIND_BASE(ptr, page_size) + len - 1) / \
+                                        page_size + 1) * page_size)
+
+static int
+shmem_transport_shm_segment_create(const char *name, size_t len, int huge)
+{
+    int fd;
+
+#ifdef HAVE_MEMFD_CREATE
+    unsigned int flags = MFD_CLOEXEC;
+
+#ifdef MFD_HUGETLB
+    if (huge) flags |= MFD_HUGETLB;
+#endif
+    fd = memfd_create(name, flags);
+#else
+    char path[NAME_MAX];
+
+    snprintf(path, sizeof(path), "/sos-shm-%d-%s", (int) getpid(), name);
+    fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+
+    /* Peers attach through /proc/<pid>/fd, so the name is no longer needed */
+    if (fd >= 0) shm_unlink(path);
+#endif
+
+    if (fd < 0) return -1;
+
+    if (0 != ftruncate(fd, len)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+void *
+shmem_transport_shm_heap_alloc(void *requested_base, size_t len)
+{
+    int huge = 0;
+    char errmsg[256];
+    void *ret;
+
+#ifdef __linux__
+    if (shmem_internal_params.SYMMETRIC_HEAP_USE_HUGE_PAGES) {
+        huge = 1;
+        len = ((len - 1) / shmem_internal_params.SYMMETRIC_HEAP_PAGE_SIZE + 1) *
+              shmem_internal_params.SYMMETRIC_HEAP_PAGE_SIZE;
+    }
+#endif
+
+    my_info.heap_fd = shmem_transport_shm_segment_create("sos-heap", len, huge);
+    if (my_info.heap_fd < 0 && huge) {
+        RAISE_WARN_STR("huge page segment creation failed, cannot use huge pages");
+        my_info.heap_fd = shmem_transport_shm_segment_create("sos-heap", len, 0);
+    }
+    if (my_info.heap_fd < 0) {
+        RAISE_WARN_MSG("Unable to create shared sym. heap segment, size %zuB: %s\n",
+                       len, shmem_util_strerror(errno, errmsg, 256));
+        return NULL;
+    }
+
+    ret = mmap(requested_base, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+               my_info.heap_fd, 0);
+    if (ret == MAP_FAILED) {
+        RAISE_WARN_MSG("Unable to allocate sym. heap, size %zuB: %s\n"
+                       RAISE_PE_PREFIX
+                       "Try reducing SHMEM_SYMMETRIC_SIZE or number of PEs per node\n",
+                       len, shmem_util_strerror(errno, errmsg, 256),
+                       shmem_internal_my_pe);
+        close(my_info.heap_fd);
+        my_info.heap_fd = -1;
+        return NULL;
+    }
+
+    my_info.heap_off = 0;
+    my_info.heap_len = len;
+
+    return ret;
+}
+
+
+/* Move the data segment into a shareable segment.  The segment is populated
+ * with the current contents of the data segment and then mapped over it at
+ * the same address, so existing pointers into the data segment are
+ * preserved. */
+static int
+shmem_transport_shm_remap_data(void)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    char errmsg[256];
+    char *base;
+    size_t len;
+    void *tmp, *ret;
+    int fd;
+
+    base = FIND_BASE(shmem_internal_data_base, page_size);
+    len  = FIND_LEN(shmem_internal_data_base, shmem_internal_data_length, page_size);
+
+    fd = shmem_transport_shm_segment_create("sos-data", len, 0);
+    if (fd < 0) {
+        RETURN_ERROR_MSG("Unable to create shared data segment: %s\n",
+                         shmem_util_strerror(errno, errmsg, 256));
+        return 1;
+    }
+
+    tmp = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (tmp == MAP_FAILED) {
+        RETURN_ERROR_MSG("Unable to map shared data segment: %s\n",
+                         shmem_util_strerror(errno, errmsg, 256));
+        close(fd);
+        return 1;
+    }
+
+    memcpy(tmp, base, len);
+
+    ret = mmap(base, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    munmap(tmp, len);
+
+    if (ret == MAP_FAILED) {
+        RETURN_ERROR_MSG("Unable to remap data segment: %s\n",
+                         shmem_util_strerror(errno, errmsg, 256));
+        close(fd);
+        return 1;
+    }
+
+    my_info.data_fd  = fd;
+    my_info.data_off = (char*) shmem_internal_data_base - base;
+    my_info.data_len = len;
+
+    return 0;
+}
+
+
+int
+shmem_transport_shm_init(void)
+{
+    int ret;
+
+    if (shmem_internal_params.SYMMETRIC_HEAP_USE_MALLOC) {
+        RETURN_ERROR_STR("SHMEM_SYMMETRIC_HEAP_USE_MALLOC is not supported by the SHM transport");
+        return 1;
+    }
+
+    if (my_info.heap_fd < 0) {
+        RETURN_ERROR_STR("Symmetric heap is not backed by a shared segment");
+        return 1;
+    }
+
+    ret = shmem_transport_shm_remap_data();
+    if (0 != ret) return ret;
+
+    my_info.pid = getpid();
+
+    ret = shmem_runtime_put("shm-segids", &my_info, sizeof(struct share_info_t));
+    if (0 != ret) {
+        RETURN_ERROR_MSG("runtime_put failed: %d\n", ret);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+static void *
+shmem_transport_shm_attach(pid_t pid, int fd, size_t len)
+{
+    char path[64];
+    char errmsg[256];
+    void *ptr;
+    int peer_fd;
+
+    snprintf(path, sizeof(path), "/proc/%d/fd/%d", (int) pid, fd);
+
+    peer_fd = open(path, O_RDWR);
+    if (peer_fd < 0) {
+        RETURN_ERROR_MSG("could not open peer segment %s: %s\n", path,
+                         shmem_util_strerror(errno, errmsg, 256));
+        return NULL;
+    }
+
+    ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, peer_fd, 0);
+    close(peer_fd);
+
+    if (ptr == MAP_FAILED) {
+        RETURN_ERROR_MSG("could not map peer segment %s: %s\n", path,
+                         shmem_util_strerror(errno, errmsg, 256));
+        return NULL;
+    }
+
+    return ptr;
+}
+
+
+int
+shmem_transport_shm_startup(void)
+{
+    int ret, i, peer_num, num_on_node;
+    struct share_info_t info;
+
+    num_on_node = shmem_runtime_get_node_size();
+
+    /* allocate space for local peers */
+    shmem_transport_shm_peers = calloc(num_on_node,
+                                       sizeof(struct shmem_transport_shm_peer_info_t));
+    if (NULL == shmem_transport_shm_peers) return 1;
+
+    /* get local peer info and map into our address space ... */
+    for (i = 0 ; i < shmem_internal_num_pes; ++i) {
+        peer_num = shmem_runtime_get_node_rank(i);
+        if (-1 == peer_num) continue;
+
+        if (shmem_internal_my_pe == i) {
+            shmem_transport_shm_peers[peer_num].data_ptr =
+                shmem_internal_data_base;
+            shmem_transport_shm_peers[peer_num].heap_ptr =
+                shmem_internal_heap_base;
+        } else {
+            ret = shmem_runtime_get(i, "shm-segids", &info, sizeof(struct share_info_t));
+            if (0 != ret) {
+                RETURN_ERROR_MSG("runtime_get failed: %d\n", ret);
+                return 1;
+            }
+
+            shmem_transport_shm_peers[peer_num].data_attach_ptr =
+                shmem_transport_shm_attach(info.pid, info.data_fd, info.data_len);
+            if (NULL == shmem_transport_shm_peers[peer_num].data_attach_ptr)
+                return 1;
+            shmem_transport_shm_peers[peer_num].data_attach_len = info.data_len;
+            shmem_transport_shm_peers[peer_num].data_ptr =
+                (char*) shmem_transport_shm_peers[peer_num].data_attach_ptr + info.data_off;
+
+            shmem_transport_shm_peers[peer_num].heap_attach_ptr =
+                shmem_transport_shm_attach(info.pid, info.heap_fd, info.heap_len);
+            if (NULL == shmem_transport_shm_peers[peer_num].heap_attach_ptr)
+                return 1;
+            shmem_transport_shm_peers[peer_num].heap_attach_len = info.heap_len;
+            shmem_transport_shm_peers[peer_num].heap_ptr =
+                (char*) shmem_transport_shm_peers[peer_num].heap_attach_ptr + info.heap_off;
+        }
+    }
+
+    return 0;
+}
+
+
+int
+shmem_transport_shm_fini(void)
+{
+    int i, peer_num;
+
+    if (NULL != shmem_transport_shm_peers) {
+        for (i = 0 ; i < shmem_internal_num_pes; ++i) {
+            peer_num = shmem_runtime_get_node_rank(i);
+            if (-1 == peer_num) continue;
+            if (shmem_internal_my_pe == i) continue;
+
+            if (NULL != shmem_transport_shm_peers[peer_num].data_attach_ptr) {
+                munmap(shmem_transport_shm_peers[peer_num].data_attach_ptr,
+                       shmem_transport_shm_peers[peer_num].data_attach_len);
+            }
+
+            if (NULL != shmem_transport_shm_peers[peer_num].heap_attach_ptr) {
+                munmap(shmem_transport_shm_peers[peer_num].heap_attach_ptr,
+                       shmem_transport_shm_peers[peer_num].heap_attach_len);
+            }
+        }
+        free(shmem_transport_shm_peers);
+        shmem_transport_shm_peers = NULL;
+    }
+
+    /* The local mappings remain valid after the descriptors are closed */
+    if (-1 != my_info.data_fd) {
+        close(my_info.data_fd);
+        my_info.data_fd = -1;
+    }
+    if (-1 != my_info.heap_fd) {
+        close(my_info.heap_fd);
+        my_info.heap_fd = -1;
+    }
+
+    return 0;
+}
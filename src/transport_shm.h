@@ -0,0 +1,123 @@
+/* -*- C -*-
+ *
+ * Copyright 2011 Sandia Corporation. Under the terms of Contract
+ * DE-AC04-94AL85000 with Sandia Corporation, the U.S.  Government
+ * retains certain rights in this software.
+ *
+ * Copyright (c) 2017 Intel Corporation. All rights reserved.
+ * This software is available to you under the BSD license.
+ *
+ * This file is part of the Sandia OpenSHMEM software package. For license
+ * information, see the LICENSE file in the top level directory of the
+ * distribution.
+ *
+ */
+
+#ifndef TRANSPORT_SHM_H
+#define TRANSPORT_SHM_H
+
+#include <string.h>
+#include <inttypes.h>
+
+#include "shmem_internal.h"
+#include "shmem_copy.h"
+
+struct shmem_transport_shm_peer_info_t {
+    void *data_attach_ptr;
+    void *heap_attach_ptr;
+    size_t data_attach_len;
+    size_t heap_attach_len;
+    void *data_ptr;
+    void *heap_ptr;
+};
+
+extern struct shmem_transport_shm_peer_info_t *shmem_transport_shm_peers;
+
+#ifdef ENABLE_ERROR_CHECKING
+#define SHM_GET_REMOTE_ACCESS(target, rank, ptr)                        \
+    do {                                                                \
+        if (((void*) target >= shmem_internal_data_base) &&             \
+            ((char*) target < (char*) shmem_internal_data_base + shmem_internal_data_length)) { \
+            ptr = (char*) target - (char*) shmem_internal_data_base +   \
+                (char*) shmem_transport_shm_peers[rank].data_ptr;       \
+        } else if (((void*) target >= shmem_internal_heap_base) &&      \
+                   ((char*) target < (char*) shmem_internal_heap_base + shmem_internal_heap_length)) { \
+            ptr = (char*) target - (char*) shmem_internal_heap_base +   \
+                (char*) shmem_transport_shm_peers[rank].heap_ptr;       \
+        } else {                                                        \
+            ptr = NULL;                                                 \
+        }                                                               \
+    } while (0)
+#else
+#define SHM_GET_REMOTE_ACCESS(target, rank, ptr)                        \
+    do {                                                                \
+        if ((void*) target < shmem_internal_heap_base) {                \
+            ptr = (char*) target - (char*) shmem_internal_data_base +   \
+                (char*) shmem_transport_shm_peers[rank].data_ptr;       \
+        } else {                                                        \
+            ptr = (char*) target - (char*) shmem_internal_heap_base +   \
+                (char*) shmem_transport_shm_peers[rank].heap_ptr;       \
+        }                                                               \
+    } while (0)
+#endif
+
+int shmem_transport_shm_init(void);
+
+int shmem_transport_shm_startup(void);
+
+int shmem_transport_shm_fini(void);
+
+/* Allocate the symmetric heap from a shareable segment, so that it can be
+ * mapped by peer processes during startup. */
+void *shmem_transport_shm_heap_alloc(void *requested_base, size_t len);
+
+
+static inline
+void *
+shmem_transport_shm_ptr(const void *target, int pe, int noderank)
+{
+    char *remote_ptr;
+
+    SHM_GET_REMOTE_ACCESS(target, noderank, remote_ptr);
+    return remote_ptr;
+}
+
+
+static inline
+void
+shmem_transport_shm_put(void *target, const void *source, size_t len,
+                        int pe, int noderank)
+{
+    char *remote_ptr;
+
+    SHM_GET_REMOTE_ACCESS(target, noderank, remote_ptr);
+#ifdef ENABLE_ERROR_CHECKING
+    if (NULL == remote_ptr) {
+        RAISE_ERROR_MSG("target (0x%"PRIXPTR") outside of symmetric areas\n",
+                        (uintptr_t) target);
+    }
+#endif
+
+    shmem_internal_copy(remote_ptr, source, len);
+}
+
+
+static inline
+void
+shmem_transport_shm_get(void *target, const void *source, size_t len,
+                        int pe, int noderank)
+{
+    char *remote_ptr;
+
+    SHM_GET_REMOTE_ACCESS(source, noderank, remote_ptr);
+#ifdef ENABLE_ERROR_CHECKING
+    if (NULL == remote_ptr) {
+        RAISE_ERROR_MSG("source (0x%"PRIXPTR") outside of symmetric areas\n",
+                        (uintptr_t) source);
+    }
+#endif
+
+    shmem_internal_copy(target, remote_ptr, len);
+}
+
+#endif
@@ -47,6 +47,13 @@ struct shmem_transport_ctx_t {
 };
 typedef struct shmem_transport_ctx_t shmem_transport_ctx_t;
 
+/* Request-based puts are completed by flushing the worker; gets complete in
+ * place and return no request */
+struct shmem_transport_req_t {
+    shmem_transport_ctx_t *ctx;
+};
+typedef struct shmem_transport_req_t shmem_transport_req_t;
+
 typedef struct {
     size_t         addr_len;
     ucp_address_t *addr;
@@ -320,6 +327,50 @@ shmem_transport_get_wait(shmem_transport_ctx_t* ctx)
     /* Blocking fetching ops are completed in place, so this is a nop */
 }
 
+static inline
+void
+shmem_transport_put_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source, size_t len,
+                        int pe, shmem_transport_req_t **req)
+{
+    shmem_transport_put_nbi(ctx, target, source, len, pe);
+
+    *req = malloc(sizeof(shmem_transport_req_t));
+    if (*req == NULL)
+        RAISE_ERROR_STR("Out of memory when allocating UCX RMA request");
+    (*req)->ctx = ctx;
+}
+
+static inline
+void
+shmem_transport_get_nbr(shmem_transport_ctx_t* ctx, void *target, const void *source, size_t len,
+                        int pe, shmem_transport_req_t **req)
+{
+    shmem_transport_get(ctx, target, source, len, pe);
+    *req = NULL;
+}
+
+static inline
+int
+shmem_transport_req_test(shmem_transport_req_t *req)
+{
+    shmem_transport_quiet(req->ctx);
+    return 1;
+}
+
+static inline
+void
+shmem_transport_req_wait(shmem_transport_req_t *req)
+{
+    shmem_transport_quiet(req->ctx);
+}
+
+static inline
+void
+shmem_transport_req_free(shmem_transport_req_t *req)
+{
+    free(req);
+}
+
 
 static inline
 void
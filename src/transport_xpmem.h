@@ -20,6 +20,8 @@
 #include <inttypes.h>
 #include <xpmem.h>
 
+#include "shmem_copy.h"
+
 struct shmem_transport_xpmem_peer_info_t {
     xpmem_apid_t data_apid;
     xpmem_apid_t heap_apid;
@@ -92,7 +94,7 @@ shmem_transport_xpmem_put(void *target, const void *source, size_t len,
     }
 #endif
 
-    memcpy(remote_ptr, source, len);
+    shmem_internal_copy(remote_ptr, source, len);
 }
 
 
@@ -111,7 +113,7 @@ shmem_transport_xpmem_get(void *target, const void *source, size_t len,
     }
 #endif
 
-    memcpy(target, remote_ptr, len);
+    shmem_internal_copy(target, remote_ptr, len);
 }
 
 #endif
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+**
+**  This is a bandwidth centric test for large blocking puts or gets
+**
+**  Features of Test: uni-directional bandwidth for message sizes that use
+**  the large message path of the on-node transport (e.g. pipelined CMA).
+**  Run it once with the default settings and once with SHMEM_CMA_LARGE_MIN=0
+**  to compare against the network transport loopback.
+**
+**  -by default megabytes/second results
+**
+*/
+#include <bw_common.h>
+#include <uni_dir.h>
+
+int main(int argc, char *argv[])
+{
+#ifdef TEST_GET
+    uni_dir_bw_main(argc, argv, STYLE_GET);
+#else
+    uni_dir_bw_main(argc, argv, STYLE_PUT);
+#endif
+
+    return 0;
+}
+
+void
+uni_dir_bw(int len, perf_metrics_t * const metric_info)
+{
+    /* Small messages are covered by shmem_bw_put_perf and shmem_bw_get_perf */
+    if (len < LARGE_MESSAGE_SIZE)
+        return;
+
+#ifdef TEST_GET
+    uni_bw_get(len, metric_info);
+#else
+    uni_bw_put(len, metric_info);
+#endif
+}
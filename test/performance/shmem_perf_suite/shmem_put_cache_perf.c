@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+**
+**  Notice: micro benchmark ~ two PEs on the same node
+**
+**  Features of Test:
+**  1) one sided put latency of various sizes, followed on the sender by a
+**    pass over a private working set that fits in cache
+**  2) the time reported includes the working set pass, so copy methods that
+**    evict the sender's cache (e.g. memcpy on large puts) show up as a
+**    higher latency than cache-bypassing methods.  Run with different
+**    SHMEM_COPY_ENGINE and SHMEM_COPY_NT_MIN settings to locate the
+**    crossover for the local copy engine.
+**
+*/
+
+#include <latency_common.h>
+
+/* Size of the working set re-read after every put */
+#define WORKING_SET_SIZE (256*1024)
+
+static long *working_set;
+static long working_set_sum;
+
+int main(int argc, char *argv[])
+{
+    working_set = malloc(WORKING_SET_SIZE);
+    if (working_set == NULL) {
+        fprintf(stderr, "Unable to allocate %d byte working set\n",
+                WORKING_SET_SIZE);
+        return 1;
+    }
+    memset(working_set, 1, WORKING_SET_SIZE);
+
+    latency_main_ctx(argc, argv, STYLE_PUT);
+
+    free(working_set);
+
+    return 0;
+}  /* end of main() */
+
+
+static inline
+void
+touch_working_set(void)
+{
+    size_t i;
+    long sum = 0;
+
+    for (i = 0; i < WORKING_SET_SIZE / sizeof(long); i++)
+        sum += working_set[i];
+
+    working_set_sum += sum;
+}
+
+void
+streaming_latency(int len, perf_metrics_t * const metric_info)
+{
+    double start = 0.0;
+    double end = 0.0;
+    unsigned long int i = 0;
+    int dest = partner_node(metric_info);
+    int sender = (metric_info->num_pes != 1) ? streaming_node(metric_info) : true;
+    static int check_once = 0;
+
+    if (!check_once) {
+        /* check to see whether sender and receiver are the same process */
+        if (dest == metric_info->my_node) {
+            fprintf(stderr, "Warning: Sender and receiver are the same process (%d)\n",
+                             dest);
+        }
+        /* hostname validation for all sender and receiver processes */
+        int status = check_hostname_validation(metric_info);
+        if (status != 0) return;
+        check_once++;
+    }
+
+    shmem_barrier_all();
+    if (sender) {
+        touch_working_set();
+
+        for (i = 0; i < metric_info->trials + metric_info->warmup; i++) {
+            if(i == metric_info->warmup)
+                start = perf_shmemx_wtime();
+
+            shmem_putmem(metric_info->dest, metric_info->src, len, dest);
+            shmem_quiet();
+            touch_working_set();
+        }
+        end = perf_shmemx_wtime();
+
+        calc_and_print_results(start, end, len, metric_info);
+    }
+} /* put latency plus working set re-read */
@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+**
+**  Notice: micro benchmark ~ two PEs
+**
+**  Features of Test:
+**  1) one sided put latency of various sizes from a private (non-symmetric)
+**    source buffer
+**  2) by default the same source buffer is reused by every put; built with
+**    FRESH_BUFFER, every put uses a newly mapped buffer that is unmapped
+**    after the put completes.  Both variants refill the buffer before each
+**    put.  Run both with SHMEM_OFI_MR_CACHE=1 to compare the cost of cache
+**    hits against registering (and invalidating) every buffer.
+**
+*/
+
+#include <latency_common.h>
+#include <sys/mman.h>
+
+int main(int argc, char *argv[])
+{
+    latency_main_ctx(argc, argv, STYLE_PUT);
+
+    return 0;
+}  /* end of main() */
+
+
+static inline
+char *
+local_buf_alloc(int len)
+{
+#ifdef FRESH_BUFFER
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    return (buf == MAP_FAILED) ? NULL : buf;
+#else
+    return malloc(len);
+#endif
+}
+
+
+static inline
+void
+local_buf_free(char *buf, int len)
+{
+#ifdef FRESH_BUFFER
+    munmap(buf, len);
+#else
+    free(buf);
+#endif
+}
+
+
+void
+streaming_latency(int len, perf_metrics_t * const metric_info)
+{
+    double start = 0.0;
+    double end = 0.0;
+    unsigned long int i = 0;
+    int dest = partner_node(metric_info);
+    int sender = (metric_info->num_pes != 1) ? streaming_node(metric_info) : true;
+    char *buf = NULL;
+    static int check_once = 0;
+
+    if (!check_once) {
+        /* check to see whether sender and receiver are the same process */
+        if (dest == metric_info->my_node) {
+            fprintf(stderr, "Warning: Sender and receiver are the same process (%d)\n",
+                             dest);
+        }
+        /* hostname validation for all sender and receiver processes */
+        int status = check_hostname_validation(metric_info);
+        if (status != 0) return;
+        check_once++;
+    }
+
+    shmem_barrier_all();
+    if (sender) {
+#ifndef FRESH_BUFFER
+        buf = local_buf_alloc(len);
+        if (buf == NULL) {
+            fprintf(stderr, "Unable to allocate %d byte source buffer\n", len);
+            shmem_global_exit(1);
+        }
+#endif
+
+        for (i = 0; i < metric_info->trials + metric_info->warmup; i++) {
+            if(i == metric_info->warmup)
+                start = perf_shmemx_wtime();
+
+#ifdef FRESH_BUFFER
+            buf = local_buf_alloc(len);
+            if (buf == NULL) {
+                fprintf(stderr, "Unable to map %d byte source buffer\n", len);
+                shmem_global_exit(1);
+            }
+#endif
+            memcpy(buf, metric_info->src, len);
+            shmem_putmem(metric_info->dest, buf, len, dest);
+            shmem_quiet();
+#ifdef FRESH_BUFFER
+            local_buf_free(buf, len);
+#endif
+        }
+        end = perf_shmemx_wtime();
+
+#ifndef FRESH_BUFFER
+        local_buf_free(buf, len);
+#endif
+
+        calc_and_print_results(start, end, len, metric_info);
+    }
+} /* put latency from a private source buffer */
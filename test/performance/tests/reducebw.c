@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2017 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+**  Reduction bandwidth for several types and operations over a range of
+**  element counts.  For large counts the time is dominated by the local
+**  combine step, so running with SHMEM_REDUCE_KERNEL=scalar and with the
+**  default kernels compares the vectorized kernels against the scalar
+**  loops.  SHMEM_REDUCE_ALGORITHM selects the reduction algorithm.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <complex.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#ifndef HAVE_SHMEMX_WTIME
+static double shmemx_wtime(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+#endif /* HAVE_SHMEMX_WTIME */
+
+static void *src, *dst;
+static int me, trials;
+
+#define REDUCE_BW(TYPENAME, TYPE, OP, count)                                \
+    do {                                                                    \
+        TYPE *s = (TYPE *) src, *d = (TYPE *) dst;                          \
+        double start, t;                                                    \
+        size_t j;                                                           \
+        int k;                                                              \
+                                                                            \
+        for (j = 0; j < count; j++)                                         \
+            s[j] = (TYPE) (1 + (j + me) % 3);                               \
+                                                                            \
+        shmem_barrier_all();                                                \
+        start = shmemx_wtime();                                             \
+        for (k = 0; k < trials; k++)                                        \
+            shmem_##TYPENAME##_##OP##_reduce(SHMEM_TEAM_WORLD, d, s, count); \
+        t = (shmemx_wtime() - start) / trials;                              \
+                                                                            \
+        if (me == 0)                                                        \
+            printf("%-16s %-5s %12zu %12.2f %12.2f\n", #TYPENAME, #OP,      \
+                   count, t * 1000000.0,                                    \
+                   count * sizeof(TYPE) / t / (1024 * 1024));               \
+    } while (0)
+
+int
+main(int argc, char *argv[])
+{
+    extern char *optarg;
+    int ch, error = 0;
+    size_t count, start_count = 1024, end_count = 4*1024*1024;
+
+    shmem_init();
+    me = shmem_my_pe();
+
+    trials = 10;
+
+    while ((ch = getopt(argc, argv, "s:e:n:")) != EOF) {
+        switch (ch) {
+        case 's':
+            start_count = strtoul(optarg, NULL, 0);
+            if (start_count < 1) start_count = 1;
+            break;
+        case 'e':
+            end_count = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            trials = atoi(optarg);
+            if (trials < 1) trials = 1;
+            break;
+        default:
+            error = 1;
+            break;
+        }
+    }
+
+    if (error) {
+        if (me == 0)
+            fprintf(stderr, "Usage: %s [-s start_count] [-e end_count] [-n trials]\n",
+                    argv[0]);
+        shmem_finalize();
+        return 1;
+    }
+
+    src = shmem_malloc(end_count * sizeof(double _Complex));
+    dst = shmem_malloc(end_count * sizeof(double _Complex));
+
+    if (NULL == src || NULL == dst) {
+        if (me == 0)
+            fprintf(stderr, "Unable to allocate %zu elements\n", end_count);
+        shmem_global_exit(1);
+    }
+
+    if (me == 0) {
+        printf("Reduction bandwidth on %d PEs, %d trials\n\n", shmem_n_pes(), trials);
+        printf("%-16s %-5s %12s %12s %12s\n", "type", "op", "count", "usec", "MB/s");
+    }
+
+    for (count = start_count; count <= end_count; count *= 4) {
+        REDUCE_BW(float, float, sum, count);
+        REDUCE_BW(double, double, sum, count);
+        REDUCE_BW(double, double, max, count);
+        REDUCE_BW(int, int, sum, count);
+        REDUCE_BW(long, long, prod, count);
+        REDUCE_BW(complexd, double _Complex, prod, count);
+    }
+
+    shmem_free(dst);
+    shmem_free(src);
+
+    shmem_finalize();
+    return 0;
+}
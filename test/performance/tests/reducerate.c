@@ -0,0 +1,155 @@
+/*
+ *  Copyright (c) 2017 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+**  Rate of long runs of back-to-back team collectives on small buffers.
+**  Each collective takes the next pSync from the team's ring, so the rate
+**  reflects how often the team must synchronize to recycle its pSyncs.
+**  Running with different SHMEM_TEAM_PSYNC_DEPTH values compares ring depths.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#ifndef HAVE_SHMEMX_WTIME
+static double shmemx_wtime(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+#endif /* HAVE_SHMEMX_WTIME */
+
+#define MAX_COUNT 64
+
+static long *src, *dst;
+static int me, npes, trials;
+
+static void report(const char *name, size_t count, double t)
+{
+    if (me == 0)
+        printf("%-12s %8zu %12.2f %14.2f\n", name, count,
+               t / trials * 1000000.0, trials / t);
+}
+
+int
+main(int argc, char *argv[])
+{
+    extern char *optarg;
+    int ch, error = 0, errors = 0;
+    size_t count, i;
+    double start;
+    int k;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    trials = 1000;
+
+    while ((ch = getopt(argc, argv, "n:")) != EOF) {
+        switch (ch) {
+        case 'n':
+            trials = atoi(optarg);
+            if (trials < 1) trials = 1;
+            break;
+        default:
+            error = 1;
+            break;
+        }
+    }
+
+    if (error) {
+        if (me == 0)
+            fprintf(stderr, "Usage: %s [-n trials]\n", argv[0]);
+        shmem_finalize();
+        return 1;
+    }
+
+    src = shmem_malloc(MAX_COUNT * sizeof(long));
+    dst = shmem_malloc(MAX_COUNT * npes * sizeof(long));
+
+    if (NULL == src || NULL == dst) {
+        if (me == 0)
+            fprintf(stderr, "Unable to allocate buffers\n");
+        shmem_global_exit(1);
+    }
+
+    for (i = 0; i < MAX_COUNT; i++)
+        src[i] = me + i;
+
+    if (me == 0) {
+        printf("Collective rate on %d PEs, %d back-to-back trials\n\n", npes, trials);
+        printf("%-12s %8s %12s %14s\n", "collective", "count", "usec", "ops/s");
+    }
+
+    for (count = 1; count <= MAX_COUNT; count *= 4) {
+        shmem_barrier_all();
+        start = shmemx_wtime();
+        for (k = 0; k < trials; k++)
+            shmem_long_sum_reduce(SHMEM_TEAM_WORLD, dst, src, count);
+        report("sum_reduce", count, shmemx_wtime() - start);
+
+        for (i = 0; i < count; i++)
+            if (dst[i] != (long) (npes * (npes - 1) / 2 + npes * i))
+                errors++;
+
+        shmem_barrier_all();
+        start = shmemx_wtime();
+        for (k = 0; k < trials; k++)
+            shmem_long_broadcast(SHMEM_TEAM_WORLD, dst, src, count, 0);
+        report("broadcast", count, shmemx_wtime() - start);
+
+        for (i = 0; me != 0 && i < count; i++)
+            if (dst[i] != (long) i)
+                errors++;
+
+        shmem_barrier_all();
+        start = shmemx_wtime();
+        for (k = 0; k < trials; k++)
+            shmem_long_fcollect(SHMEM_TEAM_WORLD, dst, src, count);
+        report("fcollect", count, shmemx_wtime() - start);
+
+        for (i = 0; i < count * npes; i++)
+            if (dst[i] != (long) (i / count + i % count))
+                errors++;
+    }
+
+    if (errors) {
+        printf("%d: %d errors\n", me, errors);
+        shmem_global_exit(1);
+    }
+
+    shmem_free(dst);
+    shmem_free(src);
+
+    shmem_finalize();
+    return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate persistent and non-blocking reduction, broadcast, and fcollect
+ * requests on SHMEM_TEAM_WORLD and on a team of the odd PEs.  Persistent
+ * requests are started repeatedly, both with a team sync between iterations
+ * and back-to-back, and several non-blocking collectives are outstanding at
+ * once.  The broadcast dest is checked on every PE, including the root.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define ITER  100
+#define NELEM 4
+#define NBCAST 8192
+
+static long src[NELEM], dst[NELEM];
+static double dsrc, ddst;
+static char bsrc[NBCAST], bdst[NBCAST];
+
+static long *all;
+static int errors = 0;
+
+static void init(int me, int root, int it)
+{
+    int i;
+
+    for (i = 0; i < NELEM; i++) {
+        src[i] = me + i + it;
+        dst[i] = -1;
+    }
+    dsrc = me + it;
+    ddst = -1;
+    memset(bsrc, me == root ? it : -1, NBCAST);
+    memset(bdst, -1, NBCAST);
+}
+
+static void check(const char *kind, int npes, int it)
+{
+    int i, j;
+
+    for (i = 0; i < NELEM; i++) {
+        long expected = (long) npes * (npes - 1) / 2 + (long) npes * (i + it);
+        if (dst[i] != expected) {
+            printf("%d: %s reduce iter %d dst[%d] = %ld, expected %ld\n",
+                   shmem_my_pe(), kind, it, i, dst[i], expected);
+            errors++;
+        }
+    }
+
+    for (i = 0; i < NBCAST; i++) {
+        if (bdst[i] != (char) it) {
+            printf("%d: %s broadcast iter %d bdst[%d] = %d, expected %d\n",
+                   shmem_my_pe(), kind, it, i, bdst[i], (char) it);
+            errors++;
+            break;
+        }
+    }
+
+    for (j = 0; j < npes; j++) {
+        for (i = 0; i < NELEM; i++) {
+            if (all[j * NELEM + i] != j + i + it) {
+                printf("%d: %s fcollect iter %d all[%d] = %ld, expected %d\n",
+                       shmem_my_pe(), kind, it, j * NELEM + i,
+                       all[j * NELEM + i], j + i + it);
+                errors++;
+            }
+        }
+    }
+}
+
+static void test_persistent(shmem_team_t team)
+{
+    shmemx_coll_req_t red, bcast, fcoll;
+    int me = shmem_team_my_pe(team);
+    int npes = shmem_team_n_pes(team);
+    int root = npes - 1;
+    int it;
+
+    if (shmemx_long_sum_reduce_init(team, dst, src, NELEM, &red) ||
+        shmemx_broadcastmem_init(team, bdst, bsrc, NBCAST, root, &bcast) ||
+        shmemx_fcollectmem_init(team, all, src, NELEM * sizeof(long), &fcoll)) {
+        printf("%d: Persistent collective initialization failed\n", shmem_my_pe());
+        shmem_global_exit(1);
+    }
+
+    for (it = 0; it < ITER; it++) {
+        init(me, root, it);
+        shmem_team_sync(team);
+
+        shmemx_coll_start(red);
+        shmemx_coll_wait(red);
+        shmemx_coll_start(bcast);
+        shmemx_coll_wait(bcast);
+        shmemx_coll_start(fcoll);
+        shmemx_coll_wait(fcoll);
+
+        check("persistent", npes, it);
+    }
+
+    /* Restart each request back-to-back, with no synchronization between the
+     * starts, and check the results as soon as the local start returns */
+    for (it = 0; it < ITER; it++) {
+        init(me, root, it);
+
+        shmemx_coll_start(red);
+        shmemx_coll_wait(red);
+        shmemx_coll_start(bcast);
+        shmemx_coll_wait(bcast);
+        shmemx_coll_start(fcoll);
+        shmemx_coll_wait(fcoll);
+
+        check("persistent", npes, it);
+    }
+
+    shmemx_coll_req_free(&red);
+    shmemx_coll_req_free(&bcast);
+    shmemx_coll_req_free(&fcoll);
+}
+
+static void test_nonblocking(shmem_team_t team)
+{
+    shmemx_coll_req_t reqs[5];
+    int me = shmem_team_my_pe(team);
+    int npes = shmem_team_n_pes(team);
+    int i, it;
+
+    for (it = 0; it < ITER; it++) {
+        int root = it % npes;
+        long polls = 0;
+
+        init(me, root, it);
+        shmem_team_sync(team);
+
+        if (shmemx_long_sum_ireduce(team, dst, src, NELEM, &reqs[0]) ||
+            shmemx_ibroadcastmem(team, bdst, bsrc, NBCAST, root, &reqs[1]) ||
+            shmemx_team_ibarrier(team, &reqs[2]) ||
+            shmemx_ifcollectmem(team, all, src, NELEM * sizeof(long), &reqs[3]) ||
+            shmemx_double_max_ireduce(team, &ddst, &dsrc, 1, &reqs[4])) {
+            printf("%d: Non-blocking collective post failed\n", shmem_my_pe());
+            shmem_global_exit(1);
+        }
+
+        /* Overlap the collectives with "computation" */
+        while (!shmemx_coll_test(reqs[4]))
+            polls++;
+
+        for (i = 4; i >= 0; i--) {
+            shmemx_coll_wait(reqs[i]);
+            shmemx_coll_req_free(&reqs[i]);
+        }
+
+        if (ddst != (double) (npes - 1 + it)) {
+            printf("%d: non-blocking reduce iter %d ddst = %f, expected %f\n",
+                   shmem_my_pe(), it, ddst, (double) (npes - 1 + it));
+            errors++;
+        }
+
+        check("non-blocking", npes, it);
+    }
+}
+
+static void test_team(shmem_team_t team)
+{
+    test_persistent(team);
+    test_nonblocking(team);
+}
+
+int main(void)
+{
+    shmem_team_t odd_team;
+    int i;
+
+    shmem_init();
+
+    all = shmem_malloc(NELEM * shmem_n_pes() * sizeof(long));
+
+    test_team(SHMEM_TEAM_WORLD);
+
+    /* A new team reuses the pSyncs and counters of the destroyed one */
+    for (i = 0; i < 2; i++) {
+        shmem_team_split_strided(SHMEM_TEAM_WORLD, 1, 2, shmem_n_pes() / 2, NULL, 0,
+                                 &odd_team);
+        if (odd_team != SHMEM_TEAM_INVALID) {
+            test_team(odd_team);
+            shmem_team_destroy(odd_team);
+        }
+        shmem_barrier_all();
+    }
+
+    /* Freed requests return their pSync to the pool */
+    for (i = 0; i < 2 * ITER; i++) {
+        shmemx_coll_req_t req;
+
+        if (shmemx_long_max_reduce_init(SHMEM_TEAM_WORLD, dst, src, 1, &req)) {
+            printf("%d: Persistent collective initialization %d failed\n",
+                   shmem_my_pe(), i);
+            shmem_global_exit(1);
+        }
+        shmemx_coll_req_free(&req);
+    }
+
+    shmem_free(all);
+
+    if (errors)
+        shmem_global_exit(1);
+
+    shmem_finalize();
+    return 0;
+}
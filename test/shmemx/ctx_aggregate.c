@@ -0,0 +1,139 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate contexts created with SHMEMX_CTX_AGGREGATE: contiguous and
+ * scattered small puts, non-fetching atomics, ordering with respect to gets
+ * and fetching atomics, and ordering across a fence
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NELEM 1024
+#define NUPDATE 4096
+
+long data[NELEM];
+long counts[NELEM];
+unsigned long bits[NELEM];
+long flag;
+
+int main(void) {
+    int me, npes, peer, i, errors = 0;
+    shmem_ctx_t ctx;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+    peer = (me + 1) % npes;
+
+    if (shmem_ctx_create(SHMEMX_CTX_AGGREGATE, &ctx)) {
+        printf("%d: Unable to create an aggregating context, skipping\n", me);
+        shmem_finalize();
+        return 0;
+    }
+
+    /* Contiguous puts coalesce into one run; strided puts into scattered
+     * segments of the same message */
+    for (i = 0; i < NELEM; i += 2)
+        shmem_ctx_long_p(ctx, &data[i], me * NELEM + i, peer);
+    for (i = 1; i < NELEM; i += 2)
+        shmem_ctx_long_p(ctx, &data[i], me * NELEM + i, peer);
+
+    /* A get must observe the batched puts issued before it */
+    for (i = 0; i < NELEM; i += NELEM / 8) {
+        long val = shmem_ctx_long_g(ctx, &data[i], peer);
+        if (val != me * NELEM + i) {
+            printf("%d: get data[%d] = %ld, expected %ld\n", me, i, val,
+                   (long) (me * NELEM + i));
+            ++errors;
+        }
+    }
+
+    /* Random-access updates, as in GUPS */
+    srand(me + 1);
+    for (i = 0; i < NUPDATE; i++) {
+        int idx = rand() % NELEM;
+        shmem_ctx_long_atomic_add(ctx, &counts[idx], 1, peer);
+        shmem_ctx_ulong_atomic_xor(ctx, &bits[idx], 1ul << (i % 64), peer);
+    }
+
+    /* A fetching atomic must observe the batched atomics issued before it */
+    long total = 0;
+    for (i = 0; i < NELEM; i++)
+        total += shmem_ctx_long_atomic_fetch(ctx, &counts[i], peer);
+    if (total != NUPDATE) {
+        printf("%d: fetched %ld updates, expected %d\n", me, total, NUPDATE);
+        ++errors;
+    }
+
+    /* Data put before a fence is visible once the flag put after it lands */
+    shmem_ctx_long_p(ctx, &data[0], -1, peer);
+    shmem_ctx_fence(ctx);
+    shmem_ctx_long_p(ctx, &flag, 1, peer);
+    shmem_ctx_quiet(ctx);
+
+    shmem_long_wait_until(&flag, SHMEM_CMP_EQ, 1);
+    if (data[0] != -1) {
+        printf("%d: data[0] = %ld after fence, expected -1\n", me, data[0]);
+        ++errors;
+    }
+
+    shmem_barrier_all();
+
+    int src = (me + npes - 1) % npes;
+    for (i = 1; i < NELEM; i++) {
+        if (data[i] != src * NELEM + i) {
+            printf("%d: data[%d] = %ld, expected %ld\n", me, i, data[i],
+                   (long) (src * NELEM + i));
+            ++errors;
+        }
+    }
+
+    /* Replay the source PE's updates to check the counts and bits */
+    srand(src + 1);
+    long expect_counts[NELEM] = { 0 };
+    unsigned long expect_bits[NELEM] = { 0 };
+    for (i = 0; i < NUPDATE; i++) {
+        int idx = rand() % NELEM;
+        expect_counts[idx]++;
+        expect_bits[idx] ^= 1ul << (i % 64);
+    }
+    for (i = 0; i < NELEM; i++) {
+        if (counts[i] != expect_counts[i] || bits[i] != expect_bits[i]) {
+            printf("%d: counts[%d] = %ld, bits[%d] = %#lx, expected %ld, %#lx\n",
+                   me, i, counts[i], i, bits[i], expect_counts[i], expect_bits[i]);
+            ++errors;
+        }
+    }
+
+    shmem_ctx_destroy(ctx);
+    shmem_finalize();
+
+    return errors != 0;
+}
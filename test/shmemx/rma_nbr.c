@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate request-based RMA: pipelined chunks retired one at a time with
+ * shmemx_req_wait and shmemx_req_test, on the default and a created context
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NCHUNK 8
+#define CHUNK  4096
+
+long src[NCHUNK * CHUNK];
+long dst[NCHUNK * CHUNK];
+
+static int check(const char *what, long *buf, int from, int me) {
+    int errors = 0;
+
+    for (int i = 0; i < NCHUNK * CHUNK; i++) {
+        if (buf[i] != from * NCHUNK * CHUNK + i) {
+            if (errors < 10)
+                printf("%d: %s[%d] = %ld, expected %ld\n", me, what, i, buf[i],
+                       (long) from * NCHUNK * CHUNK + i);
+            ++errors;
+        }
+    }
+
+    return errors;
+}
+
+int main(void) {
+    int me, npes, peer, left, i, errors = 0;
+    shmemx_req_t req[NCHUNK];
+    shmem_ctx_t ctx;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+    peer = (me + 1) % npes;
+    left = (me + npes - 1) % npes;
+
+    for (i = 0; i < NCHUNK * CHUNK; i++)
+        src[i] = (long) me * NCHUNK * CHUNK + i;
+
+    if (shmem_ctx_create(0, &ctx))
+        ctx = SHMEM_CTX_DEFAULT;
+
+    shmem_barrier_all();
+
+    /* Put all chunks, then retire them in issue order */
+    for (i = 0; i < NCHUNK; i++)
+        shmemx_putmem_nbr(&dst[i * CHUNK], &src[i * CHUNK], CHUNK * sizeof(long),
+                          peer, &req[i]);
+    for (i = 0; i < NCHUNK; i++) {
+        shmemx_req_wait(&req[i]);
+        if (req[i] != NULL) {
+            printf("%d: put request %d not released by wait\n", me, i);
+            ++errors;
+        }
+    }
+
+    shmem_barrier_all();
+    errors += check("put dst", dst, left, me);
+    shmem_barrier_all();
+
+    /* Get all chunks on a context, then poll them in reverse order */
+    for (i = 0; i < NCHUNK * CHUNK; i++)
+        dst[i] = -1;
+    for (i = 0; i < NCHUNK; i++)
+        shmemx_ctx_getmem_nbr(ctx, &dst[i * CHUNK], &src[i * CHUNK],
+                              CHUNK * sizeof(long), peer, &req[i]);
+    for (i = NCHUNK - 1; i >= 0; i--) {
+        while (!shmemx_req_test(&req[i]))
+            ;
+        if (req[i] != NULL) {
+            printf("%d: get request %d not released by test\n", me, i);
+            ++errors;
+        }
+    }
+
+    errors += check("get dst", dst, peer, me);
+
+    /* Completed requests test as complete */
+    if (!shmemx_req_test(&req[0])) {
+        printf("%d: completed request tested incomplete\n", me);
+        ++errors;
+    }
+
+    if (ctx != SHMEM_CTX_DEFAULT)
+        shmem_ctx_destroy(ctx);
+
+    shmem_finalize();
+
+    return errors != 0;
+}
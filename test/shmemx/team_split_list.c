@@ -0,0 +1,269 @@
+/*
+ *  Copyright (c) 2018 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate teams created from an arbitrary list of PEs: PE translation,
+ * barrier, reduction, broadcast, collect, fcollect, and alltoall, as well as
+ * strided and 2d splits of a list team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NELEM 4
+
+long src[NELEM], dst[NELEM];
+long csrc[NELEM], cdst[NELEM * 64];
+long asrc[64], adst[64];
+
+static int me, npes;
+
+static int check_team(shmem_team_t team, const int *members, int nmembers)
+{
+    int errors = 0, i, j;
+    int my_rank = shmem_team_my_pe(team);
+    int size = shmem_team_n_pes(team);
+
+    if (size != nmembers) {
+        printf("%d: team size %d, expected %d\n", me, size, nmembers);
+        return 1;
+    }
+
+    /* Members are numbered in increasing order of their world PE */
+    for (i = 0; i < size; i++) {
+        int pe = shmem_team_translate_pe(team, i, SHMEM_TEAM_WORLD);
+        if (pe != members[i]) {
+            printf("%d: team PE %d is world PE %d, expected %d\n", me, i, pe, members[i]);
+            errors++;
+        }
+        if (shmem_team_translate_pe(SHMEM_TEAM_WORLD, members[i], team) != i) {
+            printf("%d: world PE %d did not translate to team PE %d\n", me, members[i], i);
+            errors++;
+        }
+    }
+
+    if (members[my_rank] != me) {
+        printf("%d: team my_pe %d is world PE %d\n", me, my_rank, members[my_rank]);
+        errors++;
+    }
+
+    shmem_team_sync(team);
+
+    /* Reduction */
+    for (i = 0; i < NELEM; i++)
+        src[i] = me + i;
+
+    shmem_long_sum_reduce(team, dst, src, NELEM);
+
+    for (i = 0; i < NELEM; i++) {
+        long expected = 0;
+        for (j = 0; j < size; j++)
+            expected += members[j] + i;
+        if (dst[i] != expected) {
+            printf("%d: sum_reduce dst[%d] = %ld, expected %ld\n", me, i, dst[i], expected);
+            errors++;
+        }
+    }
+
+    shmem_team_sync(team);
+    shmem_long_max_reduce(team, dst, src, 1);
+
+    if (dst[0] != members[size - 1]) {
+        printf("%d: max_reduce = %ld, expected %d\n", me, dst[0], members[size - 1]);
+        errors++;
+    }
+
+    /* Broadcast from the last team PE, which does not update its own dest */
+    for (i = 0; i < NELEM; i++) {
+        src[i] = me * 100 + i;
+        dst[i] = -1;
+    }
+
+    /* Peers write into dest, so wait until every PE is done reading it */
+    shmem_team_sync(team);
+    shmem_long_broadcast(team, dst, src, NELEM, size - 1);
+
+    for (i = 0; my_rank != size - 1 && i < NELEM; i++) {
+        if (dst[i] != members[size - 1] * 100 + i) {
+            printf("%d: broadcast dst[%d] = %ld, expected %d\n", me, i, dst[i],
+                   members[size - 1] * 100 + i);
+            errors++;
+        }
+    }
+
+    /* fcollect and collect, where team PE i contributes i + 1 elements */
+    for (i = 0; i < NELEM; i++)
+        csrc[i] = me * 100 + i;
+
+    shmem_team_sync(team);
+    shmem_long_fcollect(team, cdst, csrc, NELEM);
+
+    for (i = 0; i < size; i++)
+        for (j = 0; j < NELEM; j++)
+            if (cdst[i * NELEM + j] != members[i] * 100 + j) {
+                printf("%d: fcollect cdst[%d] = %ld\n", me, i * NELEM + j, cdst[i * NELEM + j]);
+                errors++;
+            }
+
+    shmem_team_sync(team);
+    shmem_long_collect(team, cdst, csrc, my_rank % NELEM + 1);
+
+    for (i = 0, j = 0; i < size; i++) {
+        for (int k = 0; k < i % NELEM + 1; k++, j++)
+            if (cdst[j] != members[i] * 100 + k) {
+                printf("%d: collect cdst[%d] = %ld\n", me, j, cdst[j]);
+                errors++;
+            }
+    }
+
+    /* alltoall */
+    for (i = 0; i < size; i++)
+        asrc[i] = me * 100 + i;
+
+    shmem_team_sync(team);
+    shmem_long_alltoall(team, adst, asrc, 1);
+
+    for (i = 0; i < size; i++)
+        if (adst[i] != members[i] * 100 + my_rank) {
+            printf("%d: alltoall adst[%d] = %ld\n", me, i, adst[i]);
+            errors++;
+        }
+
+    shmem_team_sync(team);
+
+    return errors;
+}
+
+int main(void)
+{
+    int errors = 0, i, n, ret;
+    int *list, *members;
+    shmem_team_t team, subteam, xteam, yteam;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (npes > 64) {
+        if (me == 0) printf("Test requires 64 or fewer PEs\n");
+        shmem_finalize();
+        return 0;
+    }
+
+    list = malloc(npes * sizeof(int));
+    members = malloc(npes * sizeof(int));
+
+    /* Every PE but those that are 2 mod 3, listed in reverse order */
+    for (i = npes - 1, n = 0; i >= 0; i--)
+        if (i % 3 != 2)
+            list[n++] = i;
+
+    for (i = 0; i < n; i++)
+        members[i] = list[n - 1 - i];
+
+    ret = shmemx_team_split_list(SHMEM_TEAM_WORLD, list, n, NULL, 0, &team);
+
+    if (ret != 0) {
+        printf("%d: shmemx_team_split_list failed (%d)\n", me, ret);
+        shmem_global_exit(1);
+    }
+
+    if (me % 3 == 2) {
+        if (team != SHMEM_TEAM_INVALID) {
+            printf("%d: non-member received a valid team\n", me);
+            errors++;
+        }
+    } else {
+        if (team == SHMEM_TEAM_INVALID) {
+            printf("%d: member received an invalid team\n", me);
+            shmem_global_exit(1);
+        }
+
+        errors += check_team(team, members, n);
+
+        /* Every other PE of the list team */
+        ret = shmem_team_split_strided(team, 0, 2, (n + 1) / 2, NULL, 0, &subteam);
+        if (ret != 0) {
+            printf("%d: strided split of list team failed\n", me);
+            errors++;
+        } else {
+            int m = 0;
+            for (i = 0; i < n; i += 2)
+                list[m++] = members[i];
+            if (subteam != SHMEM_TEAM_INVALID) {
+                errors += check_team(subteam, list, m);
+                shmem_team_destroy(subteam);
+            }
+        }
+
+        /* Rows of two PEs */
+        ret = shmem_team_split_2d(team, 2, NULL, 0, &xteam, NULL, 0, &yteam);
+        if (ret != 0) {
+            printf("%d: 2d split of list team failed\n", me);
+            errors++;
+        } else {
+            int r = shmem_team_my_pe(team);
+            int m = 0;
+
+            for (i = (r / 2) * 2; i < n && i < (r / 2) * 2 + 2; i++)
+                list[m++] = members[i];
+            errors += check_team(xteam, list, m);
+
+            m = 0;
+            for (i = r % 2; i < n; i += 2)
+                list[m++] = members[i];
+            errors += check_team(yteam, list, m);
+
+            shmem_team_destroy(xteam);
+            shmem_team_destroy(yteam);
+        }
+
+        shmem_team_destroy(team);
+    }
+
+    /* An evenly spaced list creates a strided team */
+    for (i = 0, n = 0; i < npes; i += 2)
+        list[n++] = i;
+
+    ret = shmemx_team_split_list(SHMEM_TEAM_WORLD, list, n, NULL, 0, &team);
+
+    if (ret != 0) {
+        printf("%d: shmemx_team_split_list of even PEs failed (%d)\n", me, ret);
+        errors++;
+    } else if (team != SHMEM_TEAM_INVALID) {
+        errors += check_team(team, list, n);
+        shmem_team_destroy(team);
+    }
+
+    free(members);
+    free(list);
+
+    shmem_finalize();
+    return errors != 0;
+}
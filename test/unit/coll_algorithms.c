@@ -0,0 +1,401 @@
+/*
+ *  Copyright (c) 2017 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate every collective with the algorithms selected at build time (one
+ * program per column of the SHMEM_*_ALGORITHM matrix below), on the world
+ * team, on a team of the even PEs, and through the active set routines.  The
+ * algorithms are selected by setting the environment before shmem_init, so
+ * that they apply regardless of how the launcher forwards the environment.
+ * The active set pSyncs are followed by guard words, which catch algorithms
+ * that need more pSync than the public SHMEM_*_SYNC_SIZE constants provide. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <shmem.h>
+
+#if defined(COLL_ALG_LINEAR)
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "linear" },
+    { "SHMEM_BCAST_ALGORITHM",     "linear" },
+    { "SHMEM_REDUCE_ALGORITHM",    "linear" },
+    { "SHMEM_COLLECT_ALGORITHM",   "linear" },
+    { "SHMEM_FCOLLECT_ALGORITHM",  "linear" },
+    { "SHMEM_ALLTOALL_ALGORITHM",  "linear" },
+    { "SHMEM_ALLTOALLS_ALGORITHM", "linear" },
+};
+#elif defined(COLL_ALG_TREE)
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "tree" },
+    { "SHMEM_BCAST_ALGORITHM",     "tree" },
+    { "SHMEM_REDUCE_ALGORITHM",    "tree" },
+    { "SHMEM_COLLECT_ALGORITHM",   "recdbl" },
+    { "SHMEM_FCOLLECT_ALGORITHM",  "ring" },
+    { "SHMEM_ALLTOALL_ALGORITHM",  "pairwise" },
+    { "SHMEM_ALLTOALLS_ALGORITHM", "packed" },
+};
+#elif defined(COLL_ALG_RECDBL)
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "dissem" },
+    { "SHMEM_BCAST_ALGORITHM",     "pipeline" },
+    { "SHMEM_REDUCE_ALGORITHM",    "recdbl" },
+    { "SHMEM_COLLECT_ALGORITHM",   "recdbl" },
+    { "SHMEM_FCOLLECT_ALGORITHM",  "recdbl" },
+    { "SHMEM_ALLTOALL_ALGORITHM",  "bruck" },
+    { "SHMEM_ALLTOALLS_ALGORITHM", "packed" },
+};
+#elif defined(COLL_ALG_RING)
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "dissem" },
+    { "SHMEM_BCAST_ALGORITHM",     "scatter" },
+    { "SHMEM_REDUCE_ALGORITHM",    "ring" },
+    { "SHMEM_COLLECT_ALGORITHM",   "linear" },
+    { "SHMEM_FCOLLECT_ALGORITHM",  "ring" },
+    { "SHMEM_ALLTOALL_ALGORITHM",  "bruck" },
+    { "SHMEM_ALLTOALLS_ALGORITHM", "linear" },
+};
+#elif defined(COLL_ALG_RABENSEIFNER)
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "tree" },
+    { "SHMEM_BCAST_ALGORITHM",     "scatter" },
+    { "SHMEM_REDUCE_ALGORITHM",    "rabenseifner" },
+    { "SHMEM_COLLECT_ALGORITHM",   "recdbl" },
+    { "SHMEM_FCOLLECT_ALGORITHM",  "recdbl" },
+    { "SHMEM_ALLTOALL_ALGORITHM",  "pairwise" },
+    { "SHMEM_ALLTOALLS_ALGORITHM", "packed" },
+};
+#elif defined(COLL_ALG_HIER)
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "hier" },
+    { "SHMEM_BCAST_ALGORITHM",     "pipeline" },
+    { "SHMEM_REDUCE_ALGORITHM",    "hier" },
+    { "SHMEM_COLLECT_ALGORITHM",   "recdbl" },
+    { "SHMEM_FCOLLECT_ALGORITHM",  "recdbl" },
+    { "SHMEM_ALLTOALL_ALGORITHM",  "hier" },
+    { "SHMEM_ALLTOALLS_ALGORITHM", "packed" },
+};
+#else
+static const char *algorithms[][2] = {
+    { "SHMEM_BARRIER_ALGORITHM",   "auto" },
+};
+#endif
+
+#define NALGORITHMS (sizeof(algorithms) / sizeof(algorithms[0]))
+
+/* Element counts, spanning the latency and bandwidth crossovers */
+static const size_t counts[] = { 0, 1, 7, 64, 3000 };
+#define NCOUNTS (sizeof(counts) / sizeof(counts[0]))
+#define MAX_COUNT 3000
+
+#define ITER  2
+#define GUARD 8
+
+static int me, npes, errors = 0;
+
+#define VAL(pe, j, it) ((long) (pe) * 100003 + (long) (j) * 7 + (it))
+
+static long *src, *dst, *counter, *pwrk, *psync;
+
+#define CHECK(cond, ...)                                                      \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            if (errors++ < 10) {                                              \
+                printf("%d: ", me);                                           \
+                printf(__VA_ARGS__);                                          \
+                printf("\n");                                                 \
+            }                                                                 \
+        }                                                                     \
+    } while (0)
+
+static void reset(int it)
+{
+    for (size_t j = 0; j < MAX_COUNT * npes; j++) {
+        src[j] = VAL(me, j, it);
+        dst[j] = -1;
+    }
+}
+
+/* All PEs must have reset their buffers before any of them writes into them */
+static void reset_team(shmem_team_t team, int it)
+{
+    reset(it);
+    shmem_team_sync(team);
+}
+
+static void reset_psync(long sync_size)
+{
+    for (long i = 0; i < sync_size + GUARD; i++)
+        psync[i] = SHMEM_SYNC_VALUE;
+    shmem_barrier_all();
+}
+
+static void check_guard(long sync_size, const char *routine)
+{
+    shmem_barrier_all();
+    for (long i = sync_size; i < sync_size + GUARD; i++)
+        CHECK(psync[i] == SHMEM_SYNC_VALUE, "%s wrote past the pSync", routine);
+}
+
+static void test_barrier(shmem_team_t team, int it)
+{
+    int team_size = shmem_team_n_pes(team);
+
+    if (team == SHMEM_TEAM_INVALID)
+        return;
+
+    /* Every PE increments the counter of PE 0 of the team before the
+     * barrier, so all increments must be visible after it */
+    shmem_atomic_inc(counter, shmem_team_translate_pe(team, 0, SHMEM_TEAM_WORLD));
+    shmem_quiet();
+    shmem_team_sync(team);
+    if (shmem_team_my_pe(team) == 0)
+        CHECK(*counter == (long) team_size * (it + 1), "team sync iter %d: %ld != %ld",
+              it, *counter, (long) team_size * (it + 1));
+    shmem_team_sync(team);
+}
+
+static void test_team(shmem_team_t team, const char *name)
+{
+    int team_me, team_size;
+
+    if (team == SHMEM_TEAM_INVALID)
+        return;
+
+    team_me = shmem_team_my_pe(team);
+    team_size = shmem_team_n_pes(team);
+
+    for (int it = 0; it < ITER; it++) {
+        for (size_t c = 0; c < NCOUNTS; c++) {
+            const size_t count = counts[c];
+            const int root = (it + (int) c) % team_size;
+            size_t offset;
+
+            /* Broadcast */
+            reset_team(team, it);
+            shmem_long_broadcast(team, dst, src, count, root);
+            for (size_t j = 0; j < count && team_me != root; j++)
+                CHECK(dst[j] == VAL(shmem_team_translate_pe(team, root, SHMEM_TEAM_WORLD), j, it),
+                      "%s broadcast(%zu) root %d dst[%zu]", name, count, root, j);
+            shmem_team_sync(team);
+
+            /* Reductions */
+            reset_team(team, it);
+            shmem_long_sum_reduce(team, dst, src, count);
+            for (size_t j = 0; j < count; j++) {
+                long expected = 0;
+                for (int pe = 0; pe < team_size; pe++)
+                    expected += VAL(shmem_team_translate_pe(team, pe, SHMEM_TEAM_WORLD), j, it);
+                CHECK(dst[j] == expected, "%s sum_reduce(%zu) dst[%zu]", name, count, j);
+            }
+            shmem_team_sync(team);
+
+            reset_team(team, it);
+            shmem_long_max_reduce(team, dst, src, count);
+            for (size_t j = 0; j < count; j++)
+                CHECK(dst[j] == VAL(shmem_team_translate_pe(team, team_size - 1, SHMEM_TEAM_WORLD), j, it),
+                      "%s max_reduce(%zu) dst[%zu]", name, count, j);
+            shmem_team_sync(team);
+
+            /* Collect, where PE i of the team contributes (count + i) % 5
+             * elements when count is nonzero */
+            reset_team(team, it);
+            shmem_long_collect(team, dst, src, count ? (count + team_me) % 5 : 0);
+            offset = 0;
+            for (int pe = 0; pe < team_size; pe++) {
+                size_t n = count ? (count + pe) % 5 : 0;
+                for (size_t j = 0; j < n; j++)
+                    CHECK(dst[offset + j] == VAL(shmem_team_translate_pe(team, pe, SHMEM_TEAM_WORLD), j, it),
+                          "%s collect(%zu) dst[%zu]", name, count, offset + j);
+                offset += n;
+            }
+            shmem_team_sync(team);
+
+            /* Fcollect */
+            reset_team(team, it);
+            shmem_long_fcollect(team, dst, src, count);
+            for (int pe = 0; pe < team_size; pe++)
+                for (size_t j = 0; j < count; j++)
+                    CHECK(dst[pe * count + j] == VAL(shmem_team_translate_pe(team, pe, SHMEM_TEAM_WORLD), j, it),
+                          "%s fcollect(%zu) dst[%zu]", name, count, pe * count + j);
+            shmem_team_sync(team);
+
+            /* Alltoall, where block i of the source goes to PE i */
+            reset_team(team, it);
+            shmem_long_alltoall(team, dst, src, count);
+            for (int pe = 0; pe < team_size; pe++)
+                for (size_t j = 0; j < count; j++)
+                    CHECK(dst[pe * count + j] == VAL(shmem_team_translate_pe(team, pe, SHMEM_TEAM_WORLD),
+                                                     team_me * count + j, it),
+                          "%s alltoall(%zu) dst[%zu]", name, count, pe * count + j);
+            shmem_team_sync(team);
+
+            /* Strided alltoall, with a source stride of 2 and unit dest stride */
+            if (2 * count * team_size <= MAX_COUNT * (size_t) npes) {
+                reset_team(team, it);
+                shmem_long_alltoalls(team, dst, src, 1, 2, count);
+                for (int pe = 0; pe < team_size; pe++)
+                    for (size_t j = 0; j < count; j++)
+                        CHECK(dst[pe * count + j] == VAL(shmem_team_translate_pe(team, pe, SHMEM_TEAM_WORLD),
+                                                         2 * (team_me * count + j), it),
+                              "%s alltoalls(%zu) dst[%zu]", name, count, pe * count + j);
+                shmem_team_sync(team);
+            }
+        }
+
+        test_barrier(team, it);
+    }
+}
+
+/* The active set routines, with pSyncs of the public sizes */
+static void test_active_set(void)
+{
+    for (int it = 0; it < ITER; it++) {
+        for (size_t c = 0; c < NCOUNTS; c++) {
+            const size_t count = counts[c];
+            const int root = (it + (int) c) % npes;
+
+            reset(it);
+            reset_psync(SHMEM_BCAST_SYNC_SIZE);
+            shmem_broadcast64(dst, src, count, root, 0, 0, npes, psync);
+            for (size_t j = 0; j < count && me != root; j++)
+                CHECK(dst[j] == VAL(root, j, it), "broadcast64(%zu) dst[%zu]", count, j);
+            check_guard(SHMEM_BCAST_SYNC_SIZE, "broadcast64");
+
+            reset(it);
+            reset_psync(SHMEM_REDUCE_SYNC_SIZE);
+            shmem_long_sum_to_all(dst, src, count, 0, 0, npes, pwrk, psync);
+            for (size_t j = 0; j < count; j++) {
+                long expected = 0;
+                for (int pe = 0; pe < npes; pe++)
+                    expected += VAL(pe, j, it);
+                CHECK(dst[j] == expected, "long_sum_to_all(%zu) dst[%zu]", count, j);
+            }
+            check_guard(SHMEM_REDUCE_SYNC_SIZE, "long_sum_to_all");
+
+            reset(it);
+            reset_psync(SHMEM_COLLECT_SYNC_SIZE);
+            shmem_collect64(dst, src, count ? (count + me) % 5 : 0, 0, 0, npes, psync);
+            {
+                size_t offset = 0;
+                for (int pe = 0; pe < npes; pe++) {
+                    size_t n = count ? (count + pe) % 5 : 0;
+                    for (size_t j = 0; j < n; j++)
+                        CHECK(dst[offset + j] == VAL(pe, j, it), "collect64(%zu) dst[%zu]",
+                              count, offset + j);
+                    offset += n;
+                }
+            }
+            check_guard(SHMEM_COLLECT_SYNC_SIZE, "collect64");
+
+            reset(it);
+            reset_psync(SHMEM_COLLECT_SYNC_SIZE);
+            shmem_fcollect64(dst, src, count, 0, 0, npes, psync);
+            for (int pe = 0; pe < npes; pe++)
+                for (size_t j = 0; j < count; j++)
+                    CHECK(dst[pe * count + j] == VAL(pe, j, it), "fcollect64(%zu) dst[%zu]",
+                          count, pe * count + j);
+            check_guard(SHMEM_COLLECT_SYNC_SIZE, "fcollect64");
+
+            reset(it);
+            reset_psync(SHMEM_ALLTOALL_SYNC_SIZE);
+            shmem_alltoall64(dst, src, count, 0, 0, npes, psync);
+            for (int pe = 0; pe < npes; pe++)
+                for (size_t j = 0; j < count; j++)
+                    CHECK(dst[pe * count + j] == VAL(pe, me * count + j, it),
+                          "alltoall64(%zu) dst[%zu]", count, pe * count + j);
+            check_guard(SHMEM_ALLTOALL_SYNC_SIZE, "alltoall64");
+
+            if (2 * count <= MAX_COUNT) {
+                reset(it);
+                reset_psync(SHMEM_ALLTOALLS_SYNC_SIZE);
+                shmem_alltoalls64(dst, src, 1, 2, count, 0, 0, npes, psync);
+                for (int pe = 0; pe < npes; pe++)
+                    for (size_t j = 0; j < count; j++)
+                        CHECK(dst[pe * count + j] == VAL(pe, 2 * (me * count + j), it),
+                              "alltoalls64(%zu) dst[%zu]", count, pe * count + j);
+                check_guard(SHMEM_ALLTOALLS_SYNC_SIZE, "alltoalls64");
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    shmem_team_t even_team;
+
+    for (size_t i = 0; i < NALGORITHMS; i++)
+        setenv(algorithms[i][0], algorithms[i][1], 1);
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (me == 0)
+        for (size_t i = 0; i < NALGORITHMS; i++)
+            printf("%s=%s\n", algorithms[i][0], algorithms[i][1]);
+
+    src = shmem_malloc(sizeof(long) * MAX_COUNT * npes);
+    dst = shmem_malloc(sizeof(long) * MAX_COUNT * npes);
+    counter = shmem_calloc(1, sizeof(long));
+    pwrk = shmem_malloc(sizeof(long) * (MAX_COUNT / 2 + 1 + SHMEM_REDUCE_MIN_WRKDATA_SIZE));
+    psync = shmem_malloc(sizeof(long) * (SHMEM_SYNC_SIZE + GUARD));
+
+    if (NULL == src || NULL == dst || NULL == counter || NULL == pwrk || NULL == psync) {
+        printf("%d: allocation failed\n", me);
+        shmem_global_exit(1);
+    }
+
+    shmem_barrier_all();
+
+    test_team(SHMEM_TEAM_WORLD, "world");
+
+    shmem_team_split_strided(SHMEM_TEAM_WORLD, 0, 2, (npes + 1) / 2, NULL, 0,
+                             &even_team);
+    *counter = 0;
+    shmem_barrier_all();
+    test_team(even_team, "even");
+    if (even_team != SHMEM_TEAM_INVALID)
+        shmem_team_destroy(even_team);
+
+    test_active_set();
+
+    shmem_barrier_all();
+
+    if (me == 0 && errors == 0)
+        printf("Passed\n");
+
+    shmem_free(psync);
+    shmem_free(pwrk);
+    shmem_free(counter);
+    shmem_free(dst);
+    shmem_free(src);
+
+    shmem_finalize();
+
+    return errors != 0;
+}
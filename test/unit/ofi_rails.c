@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2017 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate puts and gets striped across two rails.  Unless SHMEM_OFI_DOMAIN
+ * is already set, both rails are opened on the first domain of the provider
+ * (e.g. two rails over the loopback interface), and SHMEM_OFI_STRIPE_MIN is
+ * lowered so that most of the sizes below are striped.  The environment is
+ * set before shmem_init, so that it applies regardless of how the launcher
+ * forwards it.  Transports other than OFI ignore these settings. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <shmem.h>
+
+#define MAX_LEN (1024 * 1024 + 7)
+#define STRIPE_MIN "4096"
+
+static const size_t lens[] = { 1, 4095, 4096, 4097, 65536 + 3, MAX_LEN };
+#define NLENS (sizeof(lens) / sizeof(lens[0]))
+
+static int me, npes, errors = 0;
+
+#define VAL(pe, i, it) ((char) ((pe) * 7 + (i) * 13 + (it)))
+
+static void check(const char *buf, size_t first, size_t len, int pe, int it,
+                  const char *what)
+{
+    for (size_t j = first; j < len; j++) {
+        if (buf[j] != VAL(pe, j, it)) {
+            printf("%d: %s(%zu) iter %d byte %zu = %d, expected %d\n",
+                   me, what, len, it, j, buf[j], VAL(pe, j, it));
+            errors++;
+            break;
+        }
+    }
+}
+
+static void fill(char *buf, size_t len, int pe, int it)
+{
+    for (size_t j = 0; j < len; j++)
+        buf[j] = VAL(pe, j, it);
+}
+
+int main(void)
+{
+    char *sym_src, *sym_dst, *priv;
+    int it = 0;
+
+    if (NULL == getenv("SHMEM_OFI_DOMAIN"))
+        setenv("SHMEM_OFI_DOMAIN", "*,*", 1);
+    setenv("SHMEM_OFI_STRIPE_MIN", STRIPE_MIN, 0);
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    sym_src = shmem_malloc(MAX_LEN);
+    sym_dst = shmem_malloc(MAX_LEN);
+    priv = malloc(MAX_LEN);
+
+    if (NULL == sym_src || NULL == sym_dst || NULL == priv) {
+        printf("%d: allocation failed\n", me);
+        shmem_global_exit(1);
+    }
+
+    for (size_t i = 0; i < NLENS; i++, it++) {
+        const size_t len = lens[i];
+        const int next = (me + 1) % npes;
+        const int prev = (me - 1 + npes) % npes;
+
+        /* Blocking put from a private buffer */
+        fill(priv, len, me, it);
+        memset(sym_dst, -1, len);
+        shmem_barrier_all();
+        shmem_putmem(sym_dst, priv, len, next);
+        shmem_barrier_all();
+        check(sym_dst, 0, len, prev, it, "putmem");
+
+        /* Non-blocking put from a symmetric buffer */
+        fill(sym_src, len, me, it + 1);
+        memset(sym_dst, -1, len);
+        shmem_barrier_all();
+        shmem_putmem_nbi(sym_dst, sym_src, len, next);
+        shmem_barrier_all();
+        check(sym_dst, 0, len, prev, it + 1, "putmem_nbi");
+
+        /* Blocking get into a private buffer */
+        fill(sym_src, len, me, it + 2);
+        memset(priv, -1, len);
+        shmem_barrier_all();
+        shmem_getmem(priv, sym_src, len, next);
+        check(priv, 0, len, next, it + 2, "getmem");
+
+        /* Non-blocking get at an unaligned offset */
+        if (len > 1) {
+            memset(sym_dst, -1, len);
+            shmem_getmem_nbi(sym_dst + 1, sym_src + 1, len - 1, next);
+            shmem_quiet();
+            check(sym_dst, 1, len, next, it + 2, "getmem_nbi");
+        }
+        shmem_barrier_all();
+    }
+
+    if (me == 0 && errors == 0)
+        printf("Passed\n");
+
+    free(priv);
+    shmem_free(sym_dst);
+    shmem_free(sym_src);
+
+    shmem_finalize();
+
+    return errors != 0;
+}
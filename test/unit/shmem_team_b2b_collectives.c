@@ -52,6 +52,18 @@ static void error_check(int *errors, int *total_errors, char *routine, int me) {
     return;
 }
 
+/* Zero-length collectives return without communicating, so they must not
+ * mark the preceding broadcast complete on the other PEs */
+static int bcast_zero_len(shmem_team_t team, long *dest, const long *src,
+                          size_t nelems)
+{
+    shmem_long_broadcast(team, dest, src, nelems, 0);
+    shmem_long_sum_reduce(team, dest, src, 0);
+    shmem_long_fcollect(team, dest, src, 0);
+    shmem_long_alltoall(team, dest, src, 0);
+    return 0;
+}
+
 
 int main(void)
 {
@@ -73,6 +85,7 @@ int main(void)
     TEST_B2B_COLLECTIVE("fcollect", shmem_long_fcollect, SHMEM_TEAM_WORLD, dest, src, NELEMS);
     TEST_B2B_COLLECTIVE("alltoall", shmem_long_alltoall, SHMEM_TEAM_WORLD, dest, src, NELEMS);
     TEST_B2B_COLLECTIVE("alltoalls", shmem_long_alltoalls, SHMEM_TEAM_WORLD, dest, src, 1, 1, NELEMS);
+    TEST_B2B_COLLECTIVE("broadcast+zero-length", bcast_zero_len, SHMEM_TEAM_WORLD, dest, src, NELEMS);
 
     shmem_finalize();
     return total_errors;
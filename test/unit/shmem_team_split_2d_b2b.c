@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2019 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Repeatedly split a parent team into rows and columns, reduce over both
+ * axes, and destroy the teams, so that the pSync slots are recycled many
+ * times while teams from the previous iteration may still be draining. */
+
+#include <stdio.h>
+#include <shmem.h>
+
+#define NITER 50
+
+long src, dst_x, dst_y;
+
+static int check_b2b(shmem_team_t parent_team, int xdim) {
+    int me = shmem_team_my_pe(parent_team);
+    int errors = 0;
+
+    for (int i = 0; i < NITER; i++) {
+        shmem_team_t xteam = SHMEM_TEAM_INVALID;
+        shmem_team_t yteam = SHMEM_TEAM_INVALID;
+        long expected_x = 0, expected_y = 0;
+
+        int ret = shmem_team_split_2d(parent_team, xdim, NULL, 0, &xteam, NULL, 0, &yteam);
+
+        if (ret != 0 || xteam == SHMEM_TEAM_INVALID || yteam == SHMEM_TEAM_INVALID) {
+            printf("%d: 2d split failed in iteration %d\n", shmem_my_pe(), i);
+            return 1;
+        }
+
+        src = me + i;
+        shmem_long_sum_reduce(xteam, &dst_x, &src, 1);
+        shmem_long_sum_reduce(yteam, &dst_y, &src, 1);
+
+        for (int j = 0; j < shmem_team_n_pes(xteam); j++)
+            expected_x += shmem_team_translate_pe(xteam, j, parent_team) + i;
+
+        for (int j = 0; j < shmem_team_n_pes(yteam); j++)
+            expected_y += shmem_team_translate_pe(yteam, j, parent_team) + i;
+
+        if (dst_x != expected_x) {
+            printf("%d: iteration %d, x-axis sum %ld, expected %ld\n", me, i, dst_x, expected_x);
+            errors++;
+        }
+
+        if (dst_y != expected_y) {
+            printf("%d: iteration %d, y-axis sum %ld, expected %ld\n", me, i, dst_y, expected_y);
+            errors++;
+        }
+
+        shmem_team_destroy(xteam);
+        shmem_team_destroy(yteam);
+    }
+
+    return errors != 0;
+}
+
+int main(void) {
+    int errors = 0, me, npes, ret;
+    shmem_team_t even_team;
+
+    shmem_init();
+
+    me   = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (me == 0) printf("Performing back-to-back 2d split test on SHMEM_TEAM_WORLD\n");
+
+    errors += check_b2b(SHMEM_TEAM_WORLD, 1);
+    errors += check_b2b(SHMEM_TEAM_WORLD, 2);
+    errors += check_b2b(SHMEM_TEAM_WORLD, 3);
+
+    ret = shmem_team_split_strided(SHMEM_TEAM_WORLD, 0, 2, (npes-1)/2 + 1,
+                                    NULL, 0, &even_team);
+
+    if (ret == 0) {
+        if (me == 0) printf("Performing back-to-back 2d split test on even team\n");
+
+        if (even_team != SHMEM_TEAM_INVALID) {
+            errors += check_b2b(even_team, 2);
+            shmem_team_destroy(even_team);
+        }
+    } else {
+        if (me == 0) printf("Unable to create even team\n");
+    }
+
+    shmem_finalize();
+    return errors != 0;
+}
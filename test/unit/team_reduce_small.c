@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2017 Intel Corporation. All rights reserved.
+ *  This software is available to you under the BSD license below:
+ *
+ *      Redistribution and use in source and binary forms, with or
+ *      without modification, are permitted provided that the following
+ *      conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Validate team reductions of 1 to 8 elements, which may exchange their values
+ * through the pSync, for a sample of types and all of the operations */
+
+#include <stdio.h>
+#include <string.h>
+#include <complex.h>
+#include <shmem.h>
+
+#define MAX_NELEM 8
+#define ITER      20
+
+static int errors = 0;
+
+#define VAL(pe, j, it) ((pe) + 2 * (j) + (it))
+
+#define TEST_REDUCE(TYPENAME, TYPE, OP, COMBINE)                              \
+    do {                                                                      \
+        static TYPE src[MAX_NELEM], dst[MAX_NELEM];                           \
+        for (int it = 0; it < ITER; it++) {                                   \
+            int nelem = it % MAX_NELEM + 1;                                   \
+                                                                              \
+            if (nelem * sizeof(TYPE) > 64) nelem = 64 / sizeof(TYPE);         \
+                                                                              \
+            for (int j = 0; j < MAX_NELEM; j++) {                             \
+                src[j] = (TYPE) VAL(me, j, it);                               \
+                dst[j] = (TYPE) -1;                                           \
+            }                                                                 \
+                                                                              \
+            shmem_##TYPENAME##_##OP##_reduce(SHMEM_TEAM_WORLD, dst, src,      \
+                                             nelem);                          \
+                                                                              \
+            for (int j = 0; j < MAX_NELEM; j++) {                             \
+                TYPE expected = (TYPE) VAL(0, j, it);                         \
+                                                                              \
+                for (int pe = 1; pe < npes && j < nelem; pe++)                \
+                    expected = COMBINE(expected, (TYPE) VAL(pe, j, it));      \
+                if (j >= nelem)                                               \
+                    expected = (TYPE) -1;                                     \
+                                                                              \
+                if (dst[j] != expected) {                                     \
+                    printf("%d: %s_%s iter %d dst[%d] != expected\n", me,     \
+                           #TYPENAME, #OP, it, j);                            \
+                    errors++;                                                 \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+    } while (0)
+
+#define SUM(a, b)  ((a) + (b))
+#define PROD(a, b) ((a) * (b))
+#define MIN(a, b)  ((a) < (b) ? (a) : (b))
+#define MAX(a, b)  ((a) > (b) ? (a) : (b))
+#define AND(a, b)  ((a) & (b))
+#define OR(a, b)   ((a) | (b))
+#define XOR(a, b)  ((a) ^ (b))
+
+int main(void)
+{
+    int me, npes;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    TEST_REDUCE(uchar, unsigned char, xor, XOR);
+    TEST_REDUCE(short, short, and, AND);
+    TEST_REDUCE(int, int, or, OR);
+    TEST_REDUCE(int, int, sum, SUM);
+    TEST_REDUCE(uint, unsigned int, prod, PROD);
+    TEST_REDUCE(long, long, sum, SUM);
+    TEST_REDUCE(long, long, min, MIN);
+    TEST_REDUCE(ulonglong, unsigned long long, max, MAX);
+    TEST_REDUCE(float, float, max, MAX);
+    TEST_REDUCE(double, double, sum, SUM);
+    TEST_REDUCE(double, double, min, MIN);
+    TEST_REDUCE(longdouble, long double, max, MAX);
+    TEST_REDUCE(complexd, double _Complex, prod, PROD);
+    TEST_REDUCE(complexf, float _Complex, sum, SUM);
+
+    shmem_finalize();
+
+    return errors != 0;
+}